@@ -6,11 +6,12 @@ using namespace std;
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
-Animation::Animation(uint width, uint height, uint* frame_ids, uint num_frames)
-	: mWidth(width), mHeight(height), mFrameIDs(frame_ids), mNumFrames(num_frames)
+Animation::Animation(uint width, uint height, AnimationFrame* frames, uint num_frames)
+	: mWidth(width), mHeight(height), mFrames(frames), mNumFrames(num_frames)
 {
 }
 
 Animation::~Animation()
 {
+	delete[] mFrames;
 }
@@ -2,20 +2,29 @@
 #define __ANIMATION_H__
 
 class Image;
+class Texture;
+
+// A frame is a texture plus the rectangle of it the frame occupies
+struct AnimationFrame
+{
+	Texture* texture;
+	float u1, v1;
+	float u2, v2;
+};
 
 class Animation
 {
 public:
-	Animation(uint width, uint height, uint* frame_ids, uint num_frames);
+	Animation(uint width, uint height, AnimationFrame* frames, uint num_frames);
 	~Animation();
 	uint GetWidth() { return mWidth; }
 	uint GetHeight() { return mHeight; }
-	uint GetFrameTextureID(uint n) const { return mFrameIDs[n]; }
+	const AnimationFrame& GetFrame(uint n) const { return mFrames[n]; }
 	uint GetNumFrames() const { return mNumFrames; }
 private:
 	uint mWidth;
 	uint mHeight;
-	uint* mFrameIDs;
+	AnimationFrame* mFrames;
 	uint mNumFrames;
 };
 
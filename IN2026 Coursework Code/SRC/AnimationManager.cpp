@@ -1,39 +1,225 @@
+#include <chrono>
+#include <thread>
 #include "ImageManager.h"
 #include "Texturemanager.h"
 #include "AnimationManager.h"
+#include "StartupProfiler.h"
+#include "AssetBundle.h"
 #include "Image.h"
 #include "Texture.h"
 #include "Animation.h"
 
 Animation* AnimationManager::CreateAnimationFromFile(const string& name, const uint width, const uint height, const uint frame_width, const uint frame_height, const string& filename)
 {
-	Image* image = ImageManager::GetInstance().CreateImageFromFile(name, width, height, filename);
+	shared_ptr<Image> image = ImageManager::GetInstance().CreateImageFromFile(name, width, height, filename);
 	return CreateAnimationFromImage(name, frame_width, frame_height, image);
 }
 
-Animation* AnimationManager::CreateAnimationFromImage(const string& name, const uint frame_width, const uint frame_height, Image* image)
+Animation* AnimationManager::CreateAnimationFromImage(const string& name, const uint frame_width, const uint frame_height, shared_ptr<Image> image)
 {
-	uint num_frames = (image->GetWidth() / frame_width) * (image->GetHeight() / frame_height);
-	uint* texture_ids = new uint[num_frames];
+	PrepareImage(image.get(), frame_width, frame_height, mCompactFormats, mMaxFormatError);
+	Animation* animation = CreateAnimationFromLevels(name, frame_width, frame_height, image->GetLevelViews(), image);
+	if (mDiscardImagesAfterUpload) DiscardImages(name, animation);
+	return animation;
+}
+
+/** Upload an animation from pixels owned elsewhere, e.g. a mapped asset bundle. Its
+	textures keep the owner, if any, alive for as long as they need the pixels. */
+Animation* AnimationManager::CreateAnimationFromLevels(const string& name, const uint frame_width, const uint frame_height, const ImageViewVector& levels, shared_ptr<Image> owner)
+{
+	if (UseSheetTexture(levels[0].width, levels[0].height)) {
+		return CreateSheetTextureAnimation(name, frame_width, frame_height, levels, owner);
+	}
+	return CreateFrameTextureAnimation(name, frame_width, frame_height, levels, owner);
+}
+
+/** Upload every animation in a bundle straight from its mapped pages. Returns how many were created. */
+uint AnimationManager::CreateAnimationsFromBundle(const AssetBundle& bundle)
+{
+	uint created = 0;
+	for (uint i = 0; i < bundle.GetEntryCount(); i++) {
+		const AssetBundleEntry& entry = bundle.GetEntry(i);
+		if (entry.type != ASSET_BUNDLE_ANIMATION) continue;
+		CreateAnimationFromLevels(entry.name, entry.frame_width, entry.frame_height, bundle.GetImageLevels(entry));
+		created++;
+	}
+	return created;
+}
+
+/** Create an animation with the frames of a w x h sheet but no textures, for running
+	the game without a GL context. Sprites can play it but not draw it. */
+Animation* AnimationManager::CreateEmptyAnimation(const string& name, const uint width, const uint height, const uint frame_width, const uint frame_height)
+{
+	uint num_frames = (width / frame_width) * (height / frame_height);
+	AnimationFrame* frames = new AnimationFrame[num_frames];
+	memset(frames, 0, num_frames * sizeof(AnimationFrame));
+	Animation* animation = new Animation(frame_width, frame_height, frames, num_frames);
+	mAnimationMap.insert(NamedAnimationMap::value_type(name, animation));
+	return animation;
+}
+
+Animation* AnimationManager::GetAnimationByName(const string& name)
+{
+	NamedAnimationMap::iterator it = mAnimationMap.find(name);
+	return (it == mAnimationMap.end()) ? 0 : it->second;
+}
+
+/** Start loading an animation in the background. Must be called on the GL thread. */
+AnimationHandle AnimationManager::LoadAnimationFromFileAsync(const string& name, const uint width, const uint height, const uint frame_width, const uint frame_height, const string& filename)
+{
+	mPendingAnimations.push_back(PendingAnimation());
+	PendingAnimation& pending = mPendingAnimations.back();
+	pending.name = name;
+	pending.frame_width = frame_width;
+	pending.frame_height = frame_height;
+	pending.decoded = async(launch::async, DecodeAnimation, width, height, frame_width, frame_height, filename, mCompactFormats, mMaxFormatError);
+	return pending.animation.get_future().share();
+}
+
+/** Upload any animations whose decoding has finished. Must be called on the GL thread. */
+void AnimationManager::ProcessPendingUploads(void)
+{
+	PendingAnimationList::iterator it = mPendingAnimations.begin();
+	while (it != mPendingAnimations.end()) {
+		if (it->decoded.wait_for(chrono::seconds(0)) == future_status::ready) {
+			UploadPendingAnimation(*it);
+			it = mPendingAnimations.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+/** Block until the given animation is ready, uploading others as they finish.
+	Returns NULL for a handle that was never given a load to wait for. */
+Animation* AnimationManager::WaitForAnimation(const AnimationHandle& handle)
+{
+	if (!handle.valid()) return NULL;
+	while (handle.wait_for(chrono::seconds(0)) != future_status::ready) {
+		ProcessPendingUploads();
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	return handle.get();
+}
+
+/** Block until every pending animation has been uploaded. */
+void AnimationManager::WaitForPendingAnimations(void)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	while (HasPendingAnimations()) {
+		ProcessPendingUploads();
+		if (HasPendingAnimations()) this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	StartupProfiler::GetInstance().RecordStage("wait for animations", StartupProfiler::MillisBetween(start, chrono::steady_clock::now()));
+}
+
+/** Decode an image, build its mipmaps and pick its format. Runs on a worker thread. */
+Image* AnimationManager::DecodeAnimation(const uint width, const uint height, const uint frame_width, const uint frame_height, const string& filename, const bool compact, const uint max_error)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	Image* image = new Image(width, height, filename);
+	chrono::steady_clock::time_point decoded_time = chrono::steady_clock::now();
+	StartupProfiler::GetInstance().RecordStage("decode " + filename, StartupProfiler::MillisBetween(start, decoded_time));
+	PrepareImage(image, frame_width, frame_height, compact, max_error);
+	StartupProfiler::GetInstance().RecordStage("prepare " + filename, StartupProfiler::MillisBetween(decoded_time, chrono::steady_clock::now()));
+	return image;
+}
+
+/** Build a sheet's mipmaps and, if asked, repack it in a compact format. Does
+	nothing to images already prepared, such as those decoded in the background. */
+void AnimationManager::PrepareImage(Image* image, const uint frame_width, const uint frame_height, const bool compact, const uint max_error)
+{
+	if (image->GetFormat() != PIXEL_FORMAT_BGRA8) return;
+	if (image->GetNumLevels() == 1) image->GenerateMipmaps(Image::CountMipLevels(frame_width, frame_height));
+	if (compact) image->ConvertToFormat(image->ChooseFormat(max_error));
+}
+
+/** Whether a sheet should be uploaded as a single texture. */
+bool AnimationManager::UseSheetTexture(const uint width, const uint height)
+{
+	if (!mSingleTextureSheets) return false;
+	// Fall back to one texture per frame if the sheet is too big for the driver
+	GLint max_texture_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+	return (width <= (uint)max_texture_size && height <= (uint)max_texture_size);
+}
+
+/** Hand a decoded animation's images to the managers and upload its textures. */
+void AnimationManager::UploadPendingAnimation(PendingAnimation& pending)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	shared_ptr<Image> image = ImageManager::GetInstance().AddImage(pending.name, pending.decoded.get());
+	Animation* animation = CreateAnimationFromImage(pending.name, pending.frame_width, pending.frame_height, image);
+	StartupProfiler::GetInstance().RecordStage("upload " + pending.name, StartupProfiler::MillisBetween(start, chrono::steady_clock::now()));
+	pending.animation.set_value(animation);
+}
+
+/** Drop every reference to an animation's source image, so it is freed now its textures are uploaded. */
+void AnimationManager::DiscardImages(const string& name, Animation* animation)
+{
+	for (uint i = 0; i < animation->GetNumFrames(); i++) {
+		TextureManager::GetInstance().DiscardSource(animation->GetFrame(i).texture);
+	}
+	ImageManager::GetInstance().ReleaseImage(name);
+}
+
+Animation* AnimationManager::CreateFrameTextureAnimation(const string& name, const uint frame_width, const uint frame_height, const ImageViewVector& levels, shared_ptr<Image> owner)
+{
+	const ImageView& view = levels[0];
+	uint num_frames = (view.width / frame_width) * (view.height / frame_height);
+	AnimationFrame* frames = new AnimationFrame[num_frames];
 	uint current_frame = 0;
-	for (uint i = 0; i < image->GetWidth(); i += frame_width) {
-		for (uint j = 0; j < image->GetHeight(); j += frame_height) {
+	for (uint i = 0; i < view.width; i += frame_width) {
+		for (uint j = 0; j < view.height; j += frame_height) {
 			std::ostringstream frame_stream;
 			frame_stream << name << "-" << current_frame;
 			std::string frame_name = frame_stream.str();
 
-			Image* frame_image = ImageManager::GetInstance().CreateImageFromImage(frame_name, image, i, j, frame_width, frame_height);
-			Texture* frame_texture = TextureManager::GetInstance().CreateTextureFromImage(frame_name, frame_image);
-			texture_ids[current_frame++] = frame_texture->GetTextureID();
+			// Upload straight from the sheet's pixels rather than copying each frame out.
+			// Frames sit on a grid that halves with each level, so each level has the
+			// whole frame at half the size of the one before.
+			ImageViewVector frame_levels;
+			for (uint level = 0; level < levels.size(); level++) {
+				frame_levels.push_back(levels[level].GetView(i >> level, j >> level, frame_width >> level, frame_height >> level));
+			}
+			Texture* frame_texture = TextureManager::GetInstance().CreateTextureFromLevels(frame_name, frame_levels, owner);
+			AnimationFrame& frame = frames[current_frame++];
+			frame.texture = frame_texture;
+			frame.u1 = 0.0f;
+			frame.v1 = 0.0f;
+			frame.u2 = 1.0f;
+			frame.v2 = 1.0f;
 		}
 	}
-	Animation* animation = new Animation(frame_width, frame_height, texture_ids, num_frames);
+	Animation* animation = new Animation(frame_width, frame_height, frames, num_frames);
 	mAnimationMap.insert(NamedAnimationMap::value_type(name, animation));
 	return animation;
 }
 
-Animation* AnimationManager::GetAnimationByName(const string& name)
+Animation* AnimationManager::CreateSheetTextureAnimation(const string& name, const uint frame_width, const uint frame_height, const ImageViewVector& levels, shared_ptr<Image> owner)
 {
-	NamedAnimationMap::iterator it = mAnimationMap.find(name);
-	return (it == mAnimationMap.end()) ? 0 : it->second;
+	const ImageView& view = levels[0];
+	uint num_frames = (view.width / frame_width) * (view.height / frame_height);
+	AnimationFrame* frames = new AnimationFrame[num_frames];
+	ImageViewVector sheet_levels(levels.begin(), levels.begin() + min((uint)levels.size(), MAX_SHEET_LEVELS));
+	Texture* sheet_texture = TextureManager::GetInstance().CreateTextureFromLevels(name, sheet_levels, owner);
+	float texture_width = (float)view.width;
+	float texture_height = (float)view.height;
+	// Half a texel of the smallest level, which is 2^level texels of the full size one
+	float inset = 0.5f * (1 << (sheet_levels.size() - 1));
+	uint current_frame = 0;
+	for (uint i = 0; i < view.width; i += frame_width) {
+		for (uint j = 0; j < view.height; j += frame_height) {
+			// Inset so linear filtering does not pick up neighbouring frames at any level
+			AnimationFrame& frame = frames[current_frame++];
+			frame.texture = sheet_texture;
+			frame.u1 = (i + inset) / texture_width;
+			frame.v1 = (j + inset) / texture_height;
+			frame.u2 = (i + frame_width - inset) / texture_width;
+			frame.v2 = (j + frame_height - inset) / texture_height;
+		}
+	}
+	Animation* animation = new Animation(frame_width, frame_height, frames, num_frames);
+	mAnimationMap.insert(NamedAnimationMap::value_type(name, animation));
+	return animation;
 }
\ No newline at end of file
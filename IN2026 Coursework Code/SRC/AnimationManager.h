@@ -1,10 +1,17 @@
 #ifndef __ANIMATIONMANAGER_H__
 #define __ANIMATIONMANAGER_H__
 
+#include <future>
+#include <vector>
 #include "GameUtil.h"
+#include "Image.h"
 
 class Image;
 class Animation;
+class AssetBundle;
+
+// Becomes ready once a background load has been uploaded on the GL thread
+typedef shared_future<Animation*> AnimationHandle;
 
 class AnimationManager
 {
@@ -16,15 +23,68 @@ public:
 	}
 
 	Animation* CreateAnimationFromFile(const string& n, const uint w, const uint h, const uint fw, const uint fh, const string& name);
-	Animation* CreateAnimationFromImage(const string& name, const uint fw, const uint fh, Image* image);
+	Animation* CreateAnimationFromImage(const string& name, const uint fw, const uint fh, shared_ptr<Image> image);
+	Animation* CreateAnimationFromLevels(const string& name, const uint fw, const uint fh, const ImageViewVector& levels, shared_ptr<Image> owner = shared_ptr<Image>());
+	uint CreateAnimationsFromBundle(const AssetBundle& bundle);
+	Animation* CreateEmptyAnimation(const string& name, const uint w, const uint h, const uint fw, const uint fh);
 	Animation* GetAnimationByName(const string& name);
 
+	// Decode on a worker thread, then upload from ProcessPendingUploads
+	AnimationHandle LoadAnimationFromFileAsync(const string& n, const uint w, const uint h, const uint fw, const uint fh, const string& name);
+	void ProcessPendingUploads(void);
+	Animation* WaitForAnimation(const AnimationHandle& handle);
+	void WaitForPendingAnimations(void);
+	bool HasPendingAnimations() const { return !mPendingAnimations.empty(); }
+
+	// Upload each sheet as a single texture and address frames by UV rectangle.
+	// Frames are inset by half a texel of the smallest level, so that many
+	// levels are kept; below them, filtering would reach neighbouring frames.
+	static const uint MAX_SHEET_LEVELS = 3;
+	void SetSingleTextureSheets(bool enabled) { mSingleTextureSheets = enabled; }
+	bool GetSingleTextureSheets() const { return mSingleTextureSheets; }
+
+	// Free each image once its textures are uploaded, for sprites that never
+	// need CPU access to their pixels. Their textures are pinned in memory.
+	void SetDiscardImagesAfterUpload(bool enabled) { mDiscardImagesAfterUpload = enabled; }
+	bool GetDiscardImagesAfterUpload() const { return mDiscardImagesAfterUpload; }
+
+	// Store sheets loaded from files in the smallest pixel format that keeps
+	// every channel within max_error of the original, 0 being lossless
+	void SetCompactFormats(bool enabled, uint max_error = 0) { mCompactFormats = enabled; mMaxFormatError = max_error; }
+	bool GetCompactFormats() const { return mCompactFormats; }
+
 private:
-	AnimationManager() {} // Private constructor
+	AnimationManager() : mSingleTextureSheets(false), mDiscardImagesAfterUpload(false), mCompactFormats(false), mMaxFormatError(0) {} // Private constructor
 	~AnimationManager() {} // Private destructor
+
+	struct PendingAnimation
+	{
+		string name;
+		uint frame_width;
+		uint frame_height;
+		future<Image*> decoded;
+		promise<Animation*> animation;
+	};
+
+	static Image* DecodeAnimation(const uint w, const uint h, const uint fw, const uint fh, const string& filename, const bool compact, const uint max_error);
+	static void PrepareImage(Image* image, const uint fw, const uint fh, const bool compact, const uint max_error);
+
+	bool UseSheetTexture(const uint w, const uint h);
+	void UploadPendingAnimation(PendingAnimation& pending);
+	void DiscardImages(const string& name, Animation* animation);
+	Animation* CreateFrameTextureAnimation(const string& name, const uint fw, const uint fh, const ImageViewVector& levels, shared_ptr<Image> owner);
+	Animation* CreateSheetTextureAnimation(const string& name, const uint fw, const uint fh, const ImageViewVector& levels, shared_ptr<Image> owner);
+
+	bool mSingleTextureSheets;
+	bool mDiscardImagesAfterUpload;
+	bool mCompactFormats;
+	uint mMaxFormatError;
 	
 	typedef map< string, Animation* > NamedAnimationMap;
 	NamedAnimationMap mAnimationMap;
+
+	typedef list<PendingAnimation> PendingAnimationList;
+	PendingAnimationList mPendingAnimations;
 };
 
 #endif
\ No newline at end of file
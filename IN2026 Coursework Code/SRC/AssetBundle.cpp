@@ -0,0 +1,258 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <string.h>
+#include "AssetBundle.h"
+#include "Shape.h"
+
+const char AssetBundle::MAGIC[4] = { 'A', 'B', 'N', 'D' };
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+AssetBundle::AssetBundle()
+	: mData(NULL),
+	  mSize(0),
+	  mEntries(NULL),
+	  mNumEntries(0)
+{
+}
+
+/** Destructor. */
+AssetBundle::~AssetBundle()
+{
+	Close();
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Map a bundle into memory read-only, so its pages are shared with any other process using it. */
+bool AssetBundle::Open(const string& filename)
+{
+	Close();
+	if (!Map(filename)) return false;
+	if (!Validate()) {
+		cerr << "Invalid asset bundle " << filename << endl;
+		Close();
+		return false;
+	}
+	return true;
+}
+
+/** Unmap the bundle. Anything pointing into it is no longer valid. */
+void AssetBundle::Close(void)
+{
+	Unmap();
+	mEntries = NULL;
+	mNumEntries = 0;
+}
+
+const AssetBundleEntry* AssetBundle::FindEntry(const string& name) const
+{
+	for (uint i = 0; i < mNumEntries; i++) {
+		if (0 == name.compare(mEntries[i].name)) return &mEntries[i];
+	}
+	return NULL;
+}
+
+/** Views of an animation's mipmap levels inside the mapped file, ready to upload. */
+ImageViewVector AssetBundle::GetImageLevels(const AssetBundleEntry& entry) const
+{
+	ImageViewVector levels;
+	const uchar* data = (const uchar*)GetData(entry);
+	PixelFormat format = (PixelFormat)entry.format;
+	uint pixel_size = GetPixelSize(format);
+	for (uint level = 0; level < entry.num_levels; level++) {
+		uint width = entry.width >> level;
+		uint height = entry.height >> level;
+		levels.push_back(ImageView(data, width, height, pixel_size*width, format));
+		data += pixel_size * width * height;
+	}
+	return levels;
+}
+
+/** Whether any animation is stored in a format that needs GL 1.2 to upload. */
+bool AssetBundle::HasPackedFormats(void) const
+{
+	for (uint i = 0; i < mNumEntries; i++) {
+		if (mEntries[i].type == ASSET_BUNDLE_ANIMATION && IsPackedPixelFormat((PixelFormat)mEntries[i].format)) return true;
+	}
+	return false;
+}
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+/** Offline step: decode every asset listed in a manifest and pack them into a bundle.
+	Each manifest line is either "animation name width height frame_width frame_height file [max_error]"
+	or "shape name file". Blank lines and lines starting with # are ignored. Animations are stored
+	in the smallest format within max_error of the original pixels, losslessly if it is left out. */
+bool AssetBundle::BuildBundle(const string& bundle_filename, const string& manifest_filename)
+{
+	ifstream manifest(manifest_filename.c_str());
+	if (!manifest) { cerr << "Error opening " << manifest_filename << endl; return false; }
+
+	vector<AssetBundleEntry> entries;
+	vector<string> blobs;
+	string line;
+	while (getline(manifest, line)) {
+		istringstream line_stream(line);
+		string type, name, filename;
+		if (!(line_stream >> type) || type[0] == '#') continue;
+
+		AssetBundleEntry entry;
+		memset(&entry, 0, sizeof(entry));
+		if (!(line_stream >> name) || name.size() >= sizeof(entry.name)) {
+			cerr << "Bad asset name in " << manifest_filename << ": " << line << endl;
+			return false;
+		}
+		strncpy(entry.name, name.c_str(), sizeof(entry.name) - 1);
+
+		if (0 == type.compare("animation")) {
+			if (!(line_stream >> entry.width >> entry.height >> entry.frame_width >> entry.frame_height >> filename)) {
+				cerr << "Bad animation in " << manifest_filename << ": " << line << endl;
+				return false;
+			}
+			ifstream image_file(filename.c_str(), ios::in | ios::binary);
+			if (!image_file) { cerr << "Error opening " << filename << endl; return false; }
+			image_file.close();
+			uint max_error = 0;
+			if (!(line_stream >> max_error)) max_error = 0;
+
+			// Store the pixels in the layout they are uploaded in, so they can be uploaded as is
+			Image image(entry.width, entry.height, filename);
+			entry.type = ASSET_BUNDLE_ANIMATION;
+			entry.num_frames = (entry.width / entry.frame_width) * (entry.height / entry.frame_height);
+			image.GenerateMipmaps(Image::CountMipLevels(entry.frame_width, entry.frame_height));
+			entry.num_levels = image.GetNumLevels();
+			image.ConvertToFormat(image.ChooseFormat(max_error));
+			entry.format = image.GetFormat();
+			ImageViewVector levels = image.GetLevelViews();
+			string pixels;
+			for (uint level = 0; level < levels.size(); level++) {
+				pixels.append((const char*)levels[level].data, GetPixelSize(image.GetFormat()) * levels[level].width * levels[level].height);
+			}
+			blobs.push_back(pixels);
+		} else if (0 == type.compare("shape")) {
+			Shape shape;
+			if (!(line_stream >> filename) || !shape.LoadShape(filename)) {
+				cerr << "Bad shape in " << manifest_filename << ": " << line << endl;
+				return false;
+			}
+			ostringstream compiled_stream(ios::out | ios::binary);
+			shape.SaveCompiledShape(compiled_stream);
+			entry.type = ASSET_BUNDLE_SHAPE;
+			blobs.push_back(compiled_stream.str());
+		} else {
+			cerr << "Unknown asset type in " << manifest_filename << ": " << line << endl;
+			return false;
+		}
+		entry.size = (uint)blobs.back().size();
+		entries.push_back(entry);
+	}
+
+	// Start each asset on its own page so it can be mapped and uploaded directly
+	AssetBundleHeader header;
+	memcpy(header.magic, MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.num_entries = (uint)entries.size();
+	header.reserved = 0;
+	uint offset = sizeof(header) + header.num_entries * sizeof(AssetBundleEntry);
+	for (uint i = 0; i < entries.size(); i++) {
+		offset = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		entries[i].offset = offset;
+		offset += entries[i].size;
+	}
+
+	ofstream bundle_file(bundle_filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!bundle_file) { cerr << "Error opening " << bundle_filename << endl; return false; }
+	bundle_file.write((const char*)&header, sizeof(header));
+	if (!entries.empty()) {
+		bundle_file.write((const char*)&entries[0], entries.size() * sizeof(AssetBundleEntry));
+	}
+	for (uint i = 0; i < entries.size(); i++) {
+		string padding(entries[i].offset - (uint)bundle_file.tellp(), '\0');
+		bundle_file.write(padding.data(), padding.size());
+		bundle_file.write(blobs[i].data(), blobs[i].size());
+		cout << "Bundled " << entries[i].name << " (" << entries[i].size << " bytes";
+		if (entries[i].type == ASSET_BUNDLE_ANIMATION) cout << ", " << GetPixelFormatName((PixelFormat)entries[i].format);
+		cout << ")" << endl;
+	}
+	return bundle_file.good();
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+/** Map a whole file into memory read-only. The view keeps the file open by itself,
+	so the handles used to make it are closed straight away. */
+bool AssetBundle::Map(const string& filename)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER size;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0) mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) return false;
+	mData = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (mData == NULL) return false;
+	mSize = (size_t)size.QuadPart;
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) return false;
+	struct stat file_stat;
+	void* data = MAP_FAILED;
+	if (fstat(file, &file_stat) == 0 && file_stat.st_size > 0) data = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+	if (data == MAP_FAILED) return false;
+	mData = (const char*)data;
+	mSize = (size_t)file_stat.st_size;
+#endif
+	return true;
+}
+
+void AssetBundle::Unmap(void)
+{
+#ifdef _WIN32
+	if (mData != NULL) UnmapViewOfFile(mData);
+#else
+	if (mData != NULL) munmap((void*)mData, mSize);
+#endif
+	mData = NULL;
+	mSize = 0;
+}
+
+/** Check the header and that every entry lies inside the file. */
+bool AssetBundle::Validate(void)
+{
+	if (mSize < sizeof(AssetBundleHeader)) return false;
+	const AssetBundleHeader* header = (const AssetBundleHeader*)mData;
+	if (0 != memcmp(header->magic, MAGIC, sizeof(header->magic))) return false;
+	if (header->version != VERSION) return false;
+	if ((mSize - sizeof(AssetBundleHeader)) / sizeof(AssetBundleEntry) < header->num_entries) return false;
+
+	mEntries = (const AssetBundleEntry*)(mData + sizeof(AssetBundleHeader));
+	mNumEntries = header->num_entries;
+	for (uint i = 0; i < mNumEntries; i++) {
+		const AssetBundleEntry& entry = mEntries[i];
+		if (entry.name[sizeof(entry.name) - 1] != '\0') return false;
+		if (entry.offset > mSize || entry.size > mSize - entry.offset) return false;
+		if (entry.type == ASSET_BUNDLE_ANIMATION) {
+			if (entry.frame_width == 0 || entry.frame_height == 0) return false;
+			if (entry.num_levels == 0 || entry.num_levels > Image::CountMipLevels(entry.width, entry.height)) return false;
+			if (entry.format >= PIXEL_FORMAT_COUNT) return false;
+			size_t size = 0;
+			for (uint level = 0; level < entry.num_levels; level++) {
+				size += (size_t)GetPixelSize((PixelFormat)entry.format) * (entry.width >> level) * (entry.height >> level);
+			}
+			if (size != entry.size) return false;
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef __ASSETBUNDLE_H__
+#define __ASSETBUNDLE_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "Image.h"
+
+enum AssetBundleEntryType { ASSET_BUNDLE_ANIMATION = 1, ASSET_BUNDLE_SHAPE = 2 };
+
+// Header of a bundle file, followed by num_entries AssetBundleEntry records
+struct AssetBundleHeader
+{
+	char magic[4];
+	uint version;
+	uint num_entries;
+	uint reserved;
+};
+
+// One asset in a bundle. Animations hold num_levels mipmap levels of pixels
+// in the given PixelFormat ready for upload, each half the size of the one
+// before. Shapes hold a compiled shape. Data starts on an ALIGNMENT boundary.
+struct AssetBundleEntry
+{
+	char name[32];
+	uint type;
+	uint offset;
+	uint size;
+	uint width;
+	uint height;
+	uint frame_width;
+	uint frame_height;
+	uint num_frames;
+	uint num_levels;
+	uint format;
+};
+
+class AssetBundle
+{
+public:
+	static const char MAGIC[4];
+	static const uint VERSION = 3;
+	static const uint ALIGNMENT = 4096;
+
+	AssetBundle();
+	~AssetBundle();
+
+	bool Open(const string& filename);
+	void Close(void);
+	bool IsOpen() const { return mData != NULL; }
+
+	uint GetEntryCount() const { return mNumEntries; }
+	const AssetBundleEntry& GetEntry(uint i) const { return mEntries[i]; }
+	const AssetBundleEntry* FindEntry(const string& name) const;
+	const char* GetData(const AssetBundleEntry& entry) const { return mData + entry.offset; }
+	ImageViewVector GetImageLevels(const AssetBundleEntry& entry) const;
+	bool HasPackedFormats(void) const;
+
+	static bool BuildBundle(const string& bundle_filename, const string& manifest_filename);
+
+private:
+	bool Map(const string& filename);
+	void Unmap(void);
+	bool Validate(void);
+
+	const char* mData;
+	size_t mSize;
+	const AssetBundleEntry* mEntries;
+	uint mNumEntries;
+};
+
+#endif
\ No newline at end of file
@@ -1,14 +1,16 @@
-#include <stdlib.h>
 #include "GameUtil.h"
 #include "Asteroid.h"
 #include "BoundingShape.h"
+#include "RandomStream.h"
 
-Asteroid::Asteroid(void) : GameObject("Asteroid")
+/** Construct an asteroid heading in a random direction from a random position, drawn from the given stream. */
+Asteroid::Asteroid(RandomStream& random) : GameObject("Asteroid")
 {
-	mAngle = rand() % 360;
-	mRotation = 0; // rand() % 90;
-	mPosition.x = rand() / 2;
-	mPosition.y = rand() / 2;
+	mAngle = random.NextInt(360);
+	mRotation = 0; // random.NextInt(90);
+	// Anywhere in the same range as rand() / 2 gave, the world wraps it into view
+	mPosition.x = random.NextInt(16384);
+	mPosition.y = random.NextInt(16384);
 	mPosition.z = 0.0;
 	mVelocity.x = 10.0 * cos(DEG2RAD*mAngle);
 	mVelocity.y = 10.0 * sin(DEG2RAD*mAngle);
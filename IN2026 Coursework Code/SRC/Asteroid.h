@@ -3,10 +3,12 @@
 
 #include "GameObject.h"
 
+class RandomStream;
+
 class Asteroid : public GameObject
 {
 public:
-	Asteroid(void);
+	Asteroid(RandomStream& random);
 	~Asteroid(void);
 
 	bool CollisionTest(shared_ptr<GameObject> o);
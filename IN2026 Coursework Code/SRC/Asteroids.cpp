@@ -3,18 +3,31 @@
 #include <iomanip>
 #include "Asteroid.h"
 #include "Asteroids.h"
+#include "Bullet.h"
+#include "DemoBullet.h"
 #include "Animation.h"
 #include "AnimationManager.h"
 #include "GameUtil.h"
 #include "GameWindow.h"
 #include "GameWorld.h"
 #include "GameDisplay.h"
+#include "NetClient.h"
+#include "NetServer.h"
+#include "RenderState.h"
+#include "RollbackSession.h"
 #include "Spaceship.h"
 #include "BoundingShape.h"
 #include "BoundingSphere.h"
 #include "GUILabel.h"
 #include "Explosion.h"
 #include "DemoSpaceship.h"
+#include "ShapeManager.h"
+#include "StartupProfiler.h"
+#include "WorldSnapshot.h"
+
+const char* Asteroids::QUICK_SAVE_FILENAME = "quicksave.snapshot";
+const char* Asteroids::HIGH_SCORE_LOG_FILENAME = "HighScores.log";
+const char* Asteroids::LEGACY_HIGH_SCORE_FILENAME = "HighScores.txt";
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
@@ -25,6 +38,7 @@ Asteroids::Asteroids(int argc, char *argv[])
 	mLevel = 0;
 	mAsteroidCount = 0;
 	mGameStarted = false;
+	mPlayerName = mOptions.name;
 }
 
 /** Destructor. */
@@ -44,7 +58,7 @@ void Asteroids::Start()
 	mGameWorld->AddListener(thisPtr.get());
 
 	// Add this as a listener to the world and the keyboard
-	mGameWindow->AddKeyboardListener(thisPtr);
+	AddKeyboardListener(thisPtr);
 
 	// Add a score keeper to the game world
 	mGameWorld->AddListener(&mScoreKeeper);
@@ -52,38 +66,68 @@ void Asteroids::Start()
 	// Add this class as a listener of the score keeper
 	mScoreKeeper.AddListener(thisPtr);
 
-	// Create an ambient light to show sprite textures
-	GLfloat ambient_light[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	GLfloat diffuse_light[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	glLightfv(GL_LIGHT0, GL_AMBIENT, ambient_light);
-	glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse_light);
-	glEnable(GL_LIGHT0);
-
-	Animation *explosion_anim = AnimationManager::GetInstance().CreateAnimationFromFile("explosion", 64, 1024, 64, 64, "explosion_fs.png");
-	Animation *asteroid1_anim = AnimationManager::GetInstance().CreateAnimationFromFile("asteroid1", 128, 8192, 128, 128, "asteroid1_fs.png");
-	Animation *spaceship_anim = AnimationManager::GetInstance().CreateAnimationFromFile("spaceship", 128, 128, 128, 128, "spaceship_fs.png");
+	// Save the score and lives with the world, and make objects when restoring it
+	mGameWorld->AddSnapshotListener(this);
+	mGameWorld->SetObjectFactory([this](const GameObjectState& state) { return CreateObject(state); });
+
+	if (IsHeadless()) {
+		// Nothing is drawn without a window, so the sprites only need their frames to animate
+		AnimationManager::GetInstance().CreateEmptyAnimation("explosion", 64, 1024, 64, 64);
+		AnimationManager::GetInstance().CreateEmptyAnimation("asteroid1", 128, 8192, 128, 128);
+		AnimationManager::GetInstance().CreateEmptyAnimation("spaceship", 128, 128, 128, 128);
+	} else {
+		LoadAssets();
+	}
+	// Every bullet shares one shape. Without it they still fly and hit, but are not drawn.
+	mBulletShape = ShapeManager::GetInstance().CreateShapeFromFile("bullet", "bullet.shape");
+	if (mBulletShape.get() == NULL) cerr << "Bullets will not be drawn without bullet.shape" << endl;
 
-	// Reads the high scores from the text file
-	ReadHighScoresFromFile();
+	// Reads the high scores from the log
+	OpenHighScores();
 
 	// Create a spaceship and add it to the world
 	//mGameWorld->AddObject(CreateSpaceship()); // Comment out when changing to demo spaceship
 
-	// Create a demo spaceship and add it to the world
-	mGameWorld->AddObject(CreateDemoSpaceship());
-	SetTimer(500, DEMOSPACESHIP_SHOOT);
+	if (IsServer()) {
+		// Players join over the network, so there is no demo to watch
+		mNetServer->AddListener(this);
+		mGameStarted = true;
+	} else if (IsPeer()) {
+		// Both peers add the two players' ships in the same order, so they have the same ids
+		mRollbackSession->SetListener(this);
+		mGameStarted = true;
+		for (uint player = 0; player < RollbackSession::NUM_PLAYERS; player++) {
+			NetPlayer& net_player = mNetPlayers[player];
+			net_player.spaceship = BuildSpaceship();
+			net_player.shots = 0;
+			mGameWorld->AddObject(net_player.spaceship);
+		}
+		mBotRandom = mGameWorld->CreateRandomStream(RANDOM_STREAM_AI, mRollbackSession->GetLocalPlayer() + 1);
+	} else if (!IsClient()) {
+		// Create a demo spaceship and add it to the world
+		mGameWorld->AddObject(CreateDemoSpaceship());
+		SetTimer(500, DEMOSPACESHIP_SHOOT);
+	}
 
-	// Create some asteroids and add them to the world
-	CreateAsteroids(10);
+	// Create some asteroids and add them to the world. A client is sent the server's.
+	if (!IsClient()) CreateAsteroids(10);
 
 	//Create the GUI
 	CreateGUI();
+	if (IsServer() || IsPeer()) {
+		mStartGameLabel->SetVisible(false);
+		mScoreLabel->SetVisible(true);
+	}
+	// Without a window, a client plays by itself so it can be tested against a server
+	if (IsClient() && IsHeadless()) SetTimer(600, NET_BOT_INPUT);
 
-	// Add a player (watcher) to the game world
-	mGameWorld->AddListener(&mPlayer);
+	// Add a player (watcher) to the game world. Networked players' ships come back by themselves.
+	if (!IsServer() && !IsPeer()) mGameWorld->AddListener(&mPlayer);
 
 	// Add this class as a listener of the player
 	mPlayer.AddListener(thisPtr);
+	// Show the lives left on the HUD whenever they change
+	mPlayer.mLives.AddListener([this](const int& lives) { OnLivesChanged(lives); });
 
 	// Start the game
 	GameSession::Start();
@@ -92,50 +136,114 @@ void Asteroids::Start()
 /** Stop the current game. */
 void Asteroids::Stop()
 {
-	// Stop the game
+	// Stop the game, once the last scores are saved
+	mHighScores.Close();
 	GameSession::Stop();
 }
 
-// Reads from the HighScores.txt file
-void Asteroids::ReadHighScoresFromFile()
+/** Show the score and lives as they are after the steps since the last frame. */
+void Asteroids::OnFrame()
+{
+	mScoreKeeper.FireScoreChanged();
+	mPlayer.mLives.Publish();
+}
+
+/** Set up lighting and upload the sprite sheets and shapes. Needs a GL context. */
+void Asteroids::LoadAssets()
 {
-	int HighScoresFromFile;
-	ifstream ifs;
-	ifs.open("HighScores.txt");
-	if (ifs.fail()) {
-		// Print in the terminal if the file fails to open
-		cout << "File failed to open" << endl;
+	// Create an ambient light to show sprite textures
+	GLfloat ambient_light[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	GLfloat diffuse_light[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glLightfv(GL_LIGHT0, GL_AMBIENT, ambient_light);
+	glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse_light);
+	glEnable(GL_LIGHT0);
+
+	// Keep each sprite sheet in one texture so sprites can share batches
+	AnimationManager::GetInstance().SetSingleTextureSheets(true);
+	// Sprites never read their pixels back, so free them once they are on the GPU
+	AnimationManager::GetInstance().SetDiscardImagesAfterUpload(true);
+	// Pack sheets that fit a 16 bit format losslessly into one, halving their memory.
+	// The packed pixel types need GL 1.2, so a 1.1 context keeps 32 bit sheets.
+	bool packed_formats = RenderState::GetInstance().IsVersionAtLeast(1, 2);
+	AnimationManager::GetInstance().SetCompactFormats(packed_formats);
+	// Upload pre-decoded assets from the bundle if one has been built (see --build-bundle)
+	chrono::steady_clock::time_point bundle_start = chrono::steady_clock::now();
+	if (mAssetBundle.Open("assets.bundle") && !packed_formats && mAssetBundle.HasPackedFormats()) {
+		cerr << "assets.bundle needs GL 1.2, decoding the sprite sheets instead" << endl;
+		mAssetBundle.Close();
 	}
-	else {
-		// Print in the terminal if the file successfully opens
-		cout << "File opened successfully" << endl;
+	if (mAssetBundle.IsOpen()) {
+		AnimationManager::GetInstance().CreateAnimationsFromBundle(mAssetBundle);
+		ShapeManager::GetInstance().CreateShapesFromBundle(mAssetBundle);
+		StartupProfiler::GetInstance().RecordStage("load assets.bundle", StartupProfiler::MillisBetween(bundle_start, chrono::steady_clock::now()));
+	} else {
+		// Otherwise decode the sprite sheets in parallel, uploading each one as it finishes
+		AnimationManager::GetInstance().LoadAnimationFromFileAsync("explosion", 64, 1024, 64, 64, "explosion_fs.png");
+		AnimationManager::GetInstance().LoadAnimationFromFileAsync("asteroid1", 128, 8192, 128, 128, "asteroid1_fs.png");
+		AnimationManager::GetInstance().LoadAnimationFromFileAsync("spaceship", 128, 128, 128, 128, "spaceship_fs.png");
+		AnimationManager::GetInstance().WaitForPendingAnimations();
+	}
+}
 
-		// Reads the first three high scores in order of highest to lowest
-		ifs >> HighScoresFromFile;
-		mHighScoreTopFromFile = HighScoresFromFile;
-		ifs >> HighScoresFromFile;
-		mHighScoreMidFromFile = HighScoresFromFile;
-		ifs >> HighScoresFromFile;
-		mHighScoreBotFromFile = HighScoresFromFile;
+/** Read the high scores and save any added from now on in the background. Without
+	a window there is no table to show, so nothing is read or written. */
+void Asteroids::OpenHighScores()
+{
+	if (IsHeadless()) return;
+	if (mHighScores.Open(HIGH_SCORE_LOG_FILENAME, LEGACY_HIGH_SCORE_FILENAME)) {
+		cout << "Read " << mHighScores.GetTable().GetCount() << " high scores" << endl;
 	}
-	ifs.close();
 }
 
-//Saves scores to the HighScores.txt file
-void Asteroids::SaveHighScoresToFile()
+/** The line shown for a rank, from 1, in the high score table. */
+string Asteroids::GetHighScoreText(uint rank, uint player_rank)
 {
-	ofstream fout;
-	fout.open("HighScores.txt");
-	fout << mHighScoreTopFromFile << endl;
-	fout << mHighScoreMidFromFile << endl;
-	fout << mHighScoreBotFromFile << endl;
-	fout.close();
+	static const char* ORDINALS[] = { "1st", "2nd", "3rd" };
+	std::ostringstream h_msg_stream;
+	h_msg_stream << ORDINALS[rank - 1] << ": ";
+	const HighScoreEntry* entry = mHighScores.GetTable().GetEntry(rank);
+	if (entry == NULL) h_msg_stream << "Score: 0";
+	else if (rank == player_rank) h_msg_stream << "New High Score: " << entry->score;
+	else h_msg_stream << entry->name << ": " << entry->score;
+	return h_msg_stream.str();
+}
+
+/** Show the top three scores, and the rank of the player's score if it has one. */
+void Asteroids::RefreshHighScores(uint player_rank)
+{
+	std::ostringstream h_msg_stream;
+	h_msg_stream << "High Scores";
+	if (player_rank > 3) h_msg_stream << " (you came " << player_rank << " of " << mHighScores.GetTable().GetCount() << ")";
+	mHighScoreLabel->SetText(h_msg_stream.str());
+	mHighScoreTopLabel->SetText(GetHighScoreText(1, player_rank));
+	mHighScoreMidLabel->SetText(GetHighScoreText(2, player_rank));
+	mHighScoreBotLabel->SetText(GetHighScoreText(3, player_rank));
 }
 
 // PUBLIC INSTANCE METHODS IMPLEMENTING IKeyboardListener /////////////////////
 
 void Asteroids::OnKeyPressed(uchar key, int x, int y)
 {
+	// The game is run over the network, so just pass the key on
+	if (IsClient() || IsPeer()) {
+		if (key == ' ' && IsClient()) mNetClient->Shoot();
+		if (key == ' ' && IsPeer()) mRollbackSession->Fire();
+		return;
+	}
+	// Game speed controls work at any time
+	SimulationClock& clock = mGameWorld->GetClock();
+	switch (key)
+	{
+	// Pause or resume the game
+	case 'p': clock.TogglePause(); return;
+	// Run the game as fast as possible, drawing only now and then
+	case 'f': clock.ToggleFastForward(); return;
+	// Halve the game speed, down to an eighth, for slow motion
+	case '-': clock.SetTimeScale(max(clock.GetTimeScale() * 0.5f, 0.125f)); return;
+	// Back to normal speed
+	case '=': clock.SetTimeScale(1.0f); return;
+	default: break;
+	}
 	if (!mGameStarted)
 	{
 		switch (key)
@@ -153,8 +261,8 @@ void Asteroids::OnKeyPressed(uchar key, int x, int y)
 			mGameWorld->FlagForRemoval(mDemoSpaceship);
 
 			// Reset the lives and score from the demo
-			mScoreKeeper.mScore = 0;
-			mPlayer.mLives = 3;
+			mScoreKeeper.mScore.Set(0);
+			mPlayer.mLives.Set(3);
 
 			break;
 		default:
@@ -175,8 +283,21 @@ void Asteroids::OnKeyReleased(uchar key, int x, int y) {}
 
 void Asteroids::OnSpecialKeyPressed(int key, int x, int y)
 {
+	if (IsClient() || IsPeer()) {
+		switch (key)
+		{
+		case GLUT_KEY_UP: PressNetButton(NET_INPUT_THRUST, true); break;
+		case GLUT_KEY_LEFT: PressNetButton(NET_INPUT_LEFT, true); break;
+		case GLUT_KEY_RIGHT: PressNetButton(NET_INPUT_RIGHT, true); break;
+		default: break;
+		}
+		return;
+	}
 	switch (key)
 	{
+	// Save the game, or go back to where it was last saved
+	case GLUT_KEY_F5: SaveSnapshot(QUICK_SAVE_FILENAME); break;
+	case GLUT_KEY_F9: LoadSnapshot(QUICK_SAVE_FILENAME); break;
 	// If up arrow key is pressed start applying forward thrust
 	case GLUT_KEY_UP: mSpaceship->Thrust(10); break;
 	// If left arrow key is pressed start rotating anti-clockwise
@@ -190,6 +311,16 @@ void Asteroids::OnSpecialKeyPressed(int key, int x, int y)
 
 void Asteroids::OnSpecialKeyReleased(int key, int x, int y)
 {
+	if (IsClient() || IsPeer()) {
+		switch (key)
+		{
+		case GLUT_KEY_UP: PressNetButton(NET_INPUT_THRUST, false); break;
+		case GLUT_KEY_LEFT: PressNetButton(NET_INPUT_LEFT, false); break;
+		case GLUT_KEY_RIGHT: PressNetButton(NET_INPUT_RIGHT, false); break;
+		default: break;
+		}
+		return;
+	}
 	switch (key)
 	{
 	// If up arrow key is released stop applying forward thrust
@@ -233,6 +364,128 @@ void Asteroids::OnObjectRemoved(GameWorld* world, shared_ptr<GameObject> object)
 		mGameWorld->AddObject(explosion);
 		SetTimer(500, DEMOSPACESHIP_RESPAWN);
 	}
+	if (!mNetPlayers.empty() && object->GetType() == GameObjectType("Spaceship"))
+	{
+		for (NetPlayerMap::iterator it = mNetPlayers.begin(); it != mNetPlayers.end(); ++it) {
+			if (it->second.spaceship != object) continue;
+			shared_ptr<GameObject> explosion = CreateExplosion();
+			explosion->SetPosition(object->GetPosition());
+			explosion->SetRotation(object->GetRotation());
+			mGameWorld->AddObject(explosion);
+			if (mNetServer) mNetServer->SetPlayerObjectId(it->first, 0);
+			SetTimer(1000, NET_RESPAWN_PLAYER + it->first);
+		}
+	}
+}
+
+// PUBLIC INSTANCE METHODS IMPLEMENTING ISnapshotListener /////////////////////
+
+void Asteroids::OnSnapshotTaken(GameWorld* world, WorldSnapshot& snapshot)
+{
+	shared_ptr<GUILabel> labels[] = { mScoreLabel, mLivesLabel, mGameOverLabel, mStartGameLabel,
+		mHighScoreLabel, mHighScoreTopLabel, mHighScoreMidLabel, mHighScoreBotLabel };
+	int visible_labels = 0;
+	for (uint i = 0; i < sizeof(labels) / sizeof(labels[0]); i++) {
+		if (labels[i] && labels[i]->GetVisible()) visible_labels |= 1 << i;
+	}
+	snapshot.SetValue(SNAPSHOT_SCORE, mScoreKeeper.mScore.Get());
+	snapshot.SetValue(SNAPSHOT_LIVES, mPlayer.mLives.Get());
+	snapshot.SetValue(SNAPSHOT_LEVEL, (int)mLevel);
+	snapshot.SetValue(SNAPSHOT_ASTEROID_COUNT, (int)mAsteroidCount);
+	snapshot.SetValue(SNAPSHOT_GAME_STARTED, mGameStarted ? 1 : 0);
+	snapshot.SetValue(SNAPSHOT_SPACESHIP_ID, mSpaceship ? (int)mSpaceship->GetId() : 0);
+	snapshot.SetValue(SNAPSHOT_DEMO_SPACESHIP_ID, mDemoSpaceship ? (int)mDemoSpaceship->GetId() : 0);
+	snapshot.SetValue(SNAPSHOT_VISIBLE_LABELS, visible_labels);
+	for (NetPlayerMap::iterator it = mNetPlayers.begin(); it != mNetPlayers.end(); ++it) {
+		snapshot.SetValue(SNAPSHOT_NET_PLAYER_SPACESHIP_ID + it->first, (int)it->second.spaceship->GetId());
+	}
+}
+
+void Asteroids::OnSnapshotRestored(GameWorld* world, const WorldSnapshot& snapshot)
+{
+	mScoreKeeper.mScore.Set(snapshot.GetValue(SNAPSHOT_SCORE));
+	mPlayer.mLives.Set(snapshot.GetValue(SNAPSHOT_LIVES, 3));
+	mLevel = (uint)snapshot.GetValue(SNAPSHOT_LEVEL);
+	mAsteroidCount = (uint)snapshot.GetValue(SNAPSHOT_ASTEROID_COUNT);
+	mGameStarted = (0 != snapshot.GetValue(SNAPSHOT_GAME_STARTED));
+
+	// Ships that were in the world are the ones restored with it. One that was
+	// between lives keeps the object it had, as it is reset when it comes back.
+	// The ships a client is sent belong to the server's game.
+	if (!IsClient()) {
+		shared_ptr<Spaceship> spaceship = dynamic_pointer_cast<Spaceship>(world->FindObject(snapshot.GetValue(SNAPSHOT_SPACESHIP_ID)));
+		if (spaceship) mSpaceship = spaceship;
+		else if (mGameStarted && !mSpaceship) CreateSpaceship();
+		shared_ptr<DemoSpaceship> demo_spaceship = dynamic_pointer_cast<DemoSpaceship>(world->FindObject(snapshot.GetValue(SNAPSHOT_DEMO_SPACESHIP_ID)));
+		if (demo_spaceship) mDemoSpaceship = demo_spaceship;
+		else if (!mDemoSpaceship) CreateDemoSpaceship();
+	}
+	// Restored ships may have been made from another player's, so each player takes
+	// theirs by id. One between lives needs a ship of its own to come back with.
+	for (NetPlayerMap::iterator it = mNetPlayers.begin(); it != mNetPlayers.end(); ++it) {
+		shared_ptr<Spaceship> spaceship = dynamic_pointer_cast<Spaceship>(world->FindObject(snapshot.GetValue(SNAPSHOT_NET_PLAYER_SPACESHIP_ID + it->first)));
+		if (spaceship) it->second.spaceship = spaceship;
+		else if (it->second.spaceship->GetWorld() != NULL) it->second.spaceship = BuildSpaceship();
+	}
+
+	shared_ptr<GUILabel> labels[] = { mScoreLabel, mLivesLabel, mGameOverLabel, mStartGameLabel,
+		mHighScoreLabel, mHighScoreTopLabel, mHighScoreMidLabel, mHighScoreBotLabel };
+	int visible_labels = snapshot.GetValue(SNAPSHOT_VISIBLE_LABELS, 1 << 3);
+	for (uint i = 0; i < sizeof(labels) / sizeof(labels[0]); i++) {
+		if (labels[i]) labels[i]->SetVisible(0 != (visible_labels & (1 << i)));
+	}
+}
+
+// PUBLIC INSTANCE METHODS IMPLEMENTING INetServerListener ///////////////////
+
+void Asteroids::OnClientConnected(NetServer* server, uint client_id)
+{
+	NetPlayer& player = mNetPlayers[client_id];
+	player.spaceship = BuildSpaceship();
+	player.shots = 0;
+	mGameWorld->AddObject(player.spaceship);
+	server->SetPlayerObjectId(client_id, player.spaceship->GetId());
+}
+
+void Asteroids::OnClientInput(NetServer* server, uint client_id, const NetInput& input)
+{
+	NetPlayerMap::iterator it = mNetPlayers.find(client_id);
+	if (it == mNetPlayers.end()) return;
+	NetPlayer& player = it->second;
+	SteerSpaceship(player.spaceship, input.buttons);
+	// Shots are counted rather than sent as presses, so one is not lost with its packet
+	uint shots = min(input.shots - player.shots, NET_MAX_SHOTS);
+	player.shots = input.shots;
+	while (shots-- > 0) player.spaceship->Shoot();
+}
+
+void Asteroids::OnClientDisconnected(NetServer* server, uint client_id)
+{
+	NetPlayerMap::iterator it = mNetPlayers.find(client_id);
+	if (it == mNetPlayers.end()) return;
+	shared_ptr<Spaceship> spaceship = it->second.spaceship;
+	mNetPlayers.erase(it);
+	// Erased first, so the ship is not brought back
+	if (spaceship->GetWorld() != NULL) mGameWorld->FlagForRemoval(spaceship);
+}
+
+// PUBLIC INSTANCE METHODS IMPLEMENTING IRollbackListener ////////////////////
+
+void Asteroids::OnRollbackFrame(RollbackSession* session, uint frame)
+{
+	// Without a window, play by changing what is held down now and then
+	if (IsHeadless() && frame % 60 == 0) {
+		session->SetButtons(mBotRandom.NextInt(8u));
+		session->Fire();
+	}
+}
+
+void Asteroids::OnRollbackInput(RollbackSession* session, uint player, uint buttons)
+{
+	NetPlayerMap::iterator it = mNetPlayers.find(player);
+	if (it == mNetPlayers.end()) return;
+	SteerSpaceship(it->second.spaceship, buttons);
+	if (buttons & NET_INPUT_FIRE) it->second.spaceship->Shoot();
 }
 
 // PUBLIC INSTANCE METHODS IMPLEMENTING ITimerListener ////////////////////////
@@ -260,44 +513,17 @@ void Asteroids::OnTimer(int value)
 		mHighScoreMidLabel->SetVisible(true);
 		mHighScoreBotLabel->SetVisible(true);
 
-		if (mHighScoreTopFromFile < mCurrentScore) {
-			std::ostringstream h_msg_stream;
-			h_msg_stream << "1st: New High Score: " << mCurrentScore;
-			mHighScoreBotFromFile = mHighScoreMidFromFile;
-			mHighScoreMidFromFile = mHighScoreTopFromFile;
-			mHighScoreTopFromFile = mCurrentScore;
-			std::string h_score_msg = h_msg_stream.str();
-			mHighScoreTopLabel->SetText(h_score_msg);
-			RefreshHighScores(mHighScoreMidLabel, "2nd: Score: " + std::to_string(mHighScoreMidFromFile));
-			RefreshHighScores(mHighScoreBotLabel, "3rd: Score: " + std::to_string(mHighScoreBotFromFile));
-		}
-		else if (mHighScoreMidFromFile < mCurrentScore) {
-			std::ostringstream h_msg_stream;
-			h_msg_stream << "2nd: Score: " << mCurrentScore;
-			mHighScoreBotFromFile = mHighScoreMidFromFile;
-			mHighScoreMidFromFile = mCurrentScore;
-			std::string h_score_msg = h_msg_stream.str();
-			mHighScoreMidLabel->SetText(h_score_msg);
-			RefreshHighScores(mHighScoreBotLabel, "3rd: Score: " + std::to_string(mHighScoreBotFromFile));
-		}
-		else if (mHighScoreBotFromFile < mCurrentScore) {
-			std::ostringstream h_msg_stream;
-			h_msg_stream << "3rd: Your Score: " << mCurrentScore;
-			mHighScoreBotFromFile = mCurrentScore;
-			std::string h_score_msg = h_msg_stream.str();
-			mHighScoreBotLabel->SetText(h_score_msg);
-		}
-		//else if (mHighScoreTopFromFile == mCurrentScore || mHighScoreMidFromFile == mCurrentScore || mHighScoreBotFromFile == mCurrentScore) {
-		//	cout << "Did not beat an existing score" << endl;
-		//}
-		SaveHighScoresToFile();
+		// Soak tests and replays are not real games, so leave the high score table alone
+		uint player_rank = IsHeadless() ? 0 : mHighScores.Add(mPlayerName, mScoreKeeper.mScore.Get());
+		RefreshHighScores(player_rank);
 	}
 	if (value == DEMOSPACESHIP_SHOOT)
 	{
 		if (!mGameStarted)
 		{
-			mDemoSpaceship->Thrust(rand() % 10 + (2));
-			mDemoSpaceship->Rotate(rand() % 120 + (-100));
+			RandomStream& random = mGameWorld->GetRandom(RANDOM_STREAM_AI);
+			mDemoSpaceship->Thrust(random.NextInt(2, 11));
+			mDemoSpaceship->Rotate(random.NextInt(-100, 19));
 			mDemoSpaceship->Shoot();
 			SetTimer(600, DEMOSPACESHIP_SHOOT);
 		}
@@ -309,34 +535,49 @@ void Asteroids::OnTimer(int value)
 			mGameWorld->AddObject(CreateDemoSpaceship());
 		}
 	}
-}
 
-void Asteroids::RefreshHighScores(shared_ptr<GUILabel> RefreshGUILabel, string value) {
-	std::ostringstream h_msg_stream;
-	h_msg_stream << value;
-	std::string h_score_msg = h_msg_stream.str();
-	RefreshGUILabel->SetText(h_score_msg);
+	if (value == NET_BOT_INPUT)
+	{
+		RandomStream& random = mGameWorld->GetRandom(RANDOM_STREAM_AI);
+		mNetClient->SetButtons(random.NextInt(8u));
+		mNetClient->Shoot();
+		SetTimer(600, NET_BOT_INPUT);
+	}
+
+	if (value >= (int)NET_RESPAWN_PLAYER)
+	{
+		NetPlayerMap::iterator it = mNetPlayers.find(value - NET_RESPAWN_PLAYER);
+		if (it != mNetPlayers.end() && it->second.spaceship->GetWorld() == NULL) {
+			it->second.spaceship->Reset();
+			mGameWorld->AddObject(it->second.spaceship);
+			if (mNetServer) mNetServer->SetPlayerObjectId(it->first, it->second.spaceship->GetId());
+		}
+	}
 }
 
 // PROTECTED INSTANCE METHODS /////////////////////////////////////////////////
-shared_ptr<GameObject> Asteroids::CreateSpaceship()
+shared_ptr<Spaceship> Asteroids::BuildSpaceship()
 {
 	// Create a raw pointer to a spaceship that can be converted to
 	// shared_ptrs of different types because GameWorld implements IRefCount
-	mSpaceship = make_shared<Spaceship>();
-	mSpaceship->SetBoundingShape(make_shared<BoundingSphere>(mSpaceship->GetThisPtr(), 4.0f));
-	shared_ptr<Shape> bullet_shape = make_shared<Shape>("bullet.shape");
-	mSpaceship->SetBulletShape(bullet_shape);
+	shared_ptr<Spaceship> spaceship = make_shared<Spaceship>();
+	spaceship->SetBoundingShape(make_shared<BoundingSphere>(spaceship->GetThisPtr(), 4.0f));
+	spaceship->SetBulletShape(mBulletShape);
 	Animation *anim_ptr = AnimationManager::GetInstance().GetAnimationByName("spaceship");
 	shared_ptr<Sprite> spaceship_sprite =
 		make_shared<Sprite>(anim_ptr->GetWidth(), anim_ptr->GetHeight(), anim_ptr);
-	mSpaceship->SetSprite(spaceship_sprite);
-	mSpaceship->SetScale(0.1f);
+	spaceship->SetSprite(spaceship_sprite);
+	spaceship->SetScale(0.1f);
 	// Reset spaceship back to centre of the world
-	mSpaceship->Reset();
+	spaceship->Reset();
+	return spaceship;
+}
+
+shared_ptr<GameObject> Asteroids::CreateSpaceship()
+{
+	mSpaceship = BuildSpaceship();
 	// Return the spaceship so it can be added to the world
 	return mSpaceship;
-
 }
 
 shared_ptr<GameObject> Asteroids::CreateDemoSpaceship()
@@ -345,8 +586,7 @@ shared_ptr<GameObject> Asteroids::CreateDemoSpaceship()
 	// shared_ptrs of different types because GameWorld implements IRefCount
 	mDemoSpaceship = make_shared<DemoSpaceship>();
 	mDemoSpaceship->SetBoundingShape(make_shared<BoundingSphere>(mDemoSpaceship->GetThisPtr(), 4.0f));
-	shared_ptr<Shape> bullet_shape = make_shared<Shape>("bullet.shape");
-	mDemoSpaceship->SetDemoBulletShape(bullet_shape);
+	mDemoSpaceship->SetDemoBulletShape(mBulletShape);
 	Animation* anim_ptr = AnimationManager::GetInstance().GetAnimationByName("spaceship");
 	shared_ptr<Sprite> spaceship_sprite =
 		make_shared<Sprite>(anim_ptr->GetWidth(), anim_ptr->GetHeight(), anim_ptr);
@@ -359,20 +599,26 @@ shared_ptr<GameObject> Asteroids::CreateDemoSpaceship()
 
 }
 
+// Creates an asteroid with a bounding sphere to match its size
+shared_ptr<GameObject> Asteroids::CreateAsteroid(float scale)
+{
+	Animation *anim_ptr = AnimationManager::GetInstance().GetAnimationByName("asteroid1");
+	shared_ptr<Sprite> asteroid_sprite
+		= make_shared<Sprite>(anim_ptr->GetWidth(), anim_ptr->GetHeight(), anim_ptr);
+	asteroid_sprite->SetLoopAnimation(true);
+	shared_ptr<GameObject> asteroid = make_shared<Asteroid>(mGameWorld->GetRandom(RANDOM_STREAM_SPAWN));
+	asteroid->SetBoundingShape(make_shared<BoundingSphere>(asteroid->GetThisPtr(), 50.0f * scale));
+	asteroid->SetSprite(asteroid_sprite);
+	asteroid->SetScale(scale);
+	return asteroid;
+}
+
 void Asteroids::CreateAsteroids(const uint num_asteroids)
 {
 	mAsteroidCount = num_asteroids;
 	for (uint i = 0; i < num_asteroids; i++)
 	{
-		Animation *anim_ptr = AnimationManager::GetInstance().GetAnimationByName("asteroid1");
-		shared_ptr<Sprite> asteroid_sprite
-			= make_shared<Sprite>(anim_ptr->GetWidth(), anim_ptr->GetHeight(), anim_ptr);
-		asteroid_sprite->SetLoopAnimation(true);
-		shared_ptr<GameObject> asteroid = make_shared<Asteroid>();
-		asteroid->SetBoundingShape(make_shared<BoundingSphere>(asteroid->GetThisPtr(), 10.0f));
-		asteroid->SetSprite(asteroid_sprite);
-		asteroid->SetScale(0.2f);
-		mGameWorld->AddObject(asteroid);
+		mGameWorld->AddObject(CreateAsteroid(0.2f));
 	}
 }
 
@@ -381,14 +627,7 @@ void Asteroids::CreateSmallerAsteroids(const uint num_asteroids, GLVector3f p)
 {
 	for (uint i = 0; i < num_asteroids; i++)
 	{
-		Animation* anim_ptr = AnimationManager::GetInstance().GetAnimationByName("asteroid1");
-		shared_ptr<Sprite> asteroid_sprite
-			= make_shared<Sprite>(anim_ptr->GetWidth(), anim_ptr->GetHeight(), anim_ptr);
-		asteroid_sprite->SetLoopAnimation(true);
-		shared_ptr<GameObject> asteroid_small = make_shared<Asteroid>();
-		asteroid_small->SetBoundingShape(make_shared<BoundingSphere>(asteroid_small->GetThisPtr(), 5.0f));
-		asteroid_small->SetSprite(asteroid_sprite);
-		asteroid_small->SetScale(0.1f);
+		shared_ptr<GameObject> asteroid_small = CreateAsteroid(0.1f);
 		asteroid_small->SetPosition(p);
 		mGameWorld->AddObject(asteroid_small);
 	}
@@ -400,6 +639,8 @@ void Asteroids::CreateGUI()
 {
 	// Add a (transparent) border around the edge of the game display
 	mGameDisplay->GetContainer()->SetBorder(GLVector2i(10, 10));
+	// Keep the HUD in a texture that is only redrawn where a label changes
+	mGameDisplay->SetCachedOverlay(true);
 	// Create a new GUILabel and wrap it up in a shared_ptr
 	mScoreLabel = make_shared<GUILabel>("Score: 0");
 	// Set the vertical alignment of the label to GUI_VALIGN_TOP
@@ -444,17 +685,17 @@ void Asteroids::CreateGUI()
 	mHighScoreLabel->SetVerticalAlignment(GUIComponent::GUI_VALIGN_MIDDLE);
 	mHighScoreLabel->SetVisible(false);
 
-	mHighScoreTopLabel = shared_ptr<GUILabel>(new GUILabel("1st: Score: " + std::to_string(mHighScoreTopFromFile)));
+	mHighScoreTopLabel = shared_ptr<GUILabel>(new GUILabel(GetHighScoreText(1, 0)));
 	mHighScoreTopLabel->SetHorizontalAlignment(GUIComponent::GUI_HALIGN_LEFT);
 	mHighScoreTopLabel->SetVerticalAlignment(GUIComponent::GUI_VALIGN_MIDDLE);
 	mHighScoreTopLabel->SetVisible(false);
 
-	mHighScoreMidLabel = shared_ptr<GUILabel>(new GUILabel("2nd: Score: " + std::to_string(mHighScoreMidFromFile)));
+	mHighScoreMidLabel = shared_ptr<GUILabel>(new GUILabel(GetHighScoreText(2, 0)));
 	mHighScoreMidLabel->SetHorizontalAlignment(GUIComponent::GUI_HALIGN_LEFT);
 	mHighScoreMidLabel->SetVerticalAlignment(GUIComponent::GUI_VALIGN_MIDDLE);
 	mHighScoreMidLabel->SetVisible(false);
 
-	mHighScoreBotLabel = shared_ptr<GUILabel>(new GUILabel("3rd: Score: " + std::to_string(mHighScoreBotFromFile)));
+	mHighScoreBotLabel = shared_ptr<GUILabel>(new GUILabel(GetHighScoreText(3, 0)));
 	mHighScoreBotLabel->SetHorizontalAlignment(GUIComponent::GUI_HALIGN_LEFT);
 	mHighScoreBotLabel->SetVerticalAlignment(GUIComponent::GUI_VALIGN_MIDDLE);
 	mHighScoreBotLabel->SetVisible(false);
@@ -484,13 +725,8 @@ void Asteroids::CreateGUI()
 
 void Asteroids::OnScoreChanged(int score)
 {
-	mCurrentScore = score;
-	// Format the score message using an string-based stream
-	std::ostringstream msg_stream;
-	msg_stream << "Score: " << score;
-	// Get the score message as a string
-	std::string score_msg = msg_stream.str();
-	mScoreLabel->SetText(score_msg);
+	// Called at most once a frame, with the final score
+	mScoreLabel->SetText("Score: ", score);
 }
 
 void Asteroids::OnPlayerKilled(int lives_left)
@@ -500,13 +736,6 @@ void Asteroids::OnPlayerKilled(int lives_left)
 	explosion->SetRotation(mSpaceship->GetRotation());
 	mGameWorld->AddObject(explosion);
 
-	// Format the lives left message using an string-based stream
-	std::ostringstream msg_stream;
-	msg_stream << "Lives: " << lives_left;
-	// Get the lives left message as a string
-	std::string lives_msg = msg_stream.str();
-	mLivesLabel->SetText(lives_msg);
-
 	if (lives_left > 0) 
 	{ 
 		SetTimer(1000, CREATE_NEW_PLAYER); 
@@ -517,6 +746,12 @@ void Asteroids::OnPlayerKilled(int lives_left)
 	}
 }
 
+void Asteroids::OnLivesChanged(int lives)
+{
+	// Called at most once a frame, with the final number of lives
+	mLivesLabel->SetText("Lives: ", lives);
+}
+
 shared_ptr<GameObject> Asteroids::CreateExplosion()
 {
 	Animation *anim_ptr = AnimationManager::GetInstance().GetAnimationByName("explosion");
@@ -525,6 +760,55 @@ shared_ptr<GameObject> Asteroids::CreateExplosion()
 	explosion_sprite->SetLoopAnimation(false);
 	shared_ptr<GameObject> explosion = make_shared<Explosion>();
 	explosion->SetSprite(explosion_sprite);
+	// Draw explosions above asteroids and ships
+	explosion->SetRenderLayer(1);
 	explosion->Reset();
 	return explosion;
+}
+
+/** Make an object of the type saved in a snapshot, set up as the game would have made it. */
+shared_ptr<GameObject> Asteroids::CreateObject(const GameObjectState& state)
+{
+	if (state.type == GameObjectType("Asteroid").GetTypeID()) return CreateAsteroid(state.scale);
+	if (state.type == GameObjectType("Explosion").GetTypeID()) return CreateExplosion();
+	if (state.type == GameObjectType("Bullet").GetTypeID() || state.type == GameObjectType("DemoBullet").GetTypeID()) {
+		shared_ptr<GameObject> bullet;
+		if (state.type == GameObjectType("Bullet").GetTypeID()) bullet = make_shared<Bullet>();
+		else bullet = make_shared<DemoBullet>();
+		bullet->SetBoundingShape(make_shared<BoundingSphere>(bullet->GetThisPtr(), 2.0f));
+		bullet->SetShape(mBulletShape);
+		return bullet;
+	}
+	// The game keeps hold of its ships, so reuse them if they are free.
+	// A client is sent everyone's ships, none of which are its own to keep.
+	if (state.type == GameObjectType("Spaceship").GetTypeID()) {
+		if (IsClient()) return BuildSpaceship();
+		for (NetPlayerMap::iterator it = mNetPlayers.begin(); it != mNetPlayers.end(); ++it) {
+			if (it->second.spaceship->GetWorld() == NULL) return it->second.spaceship;
+		}
+		if (!mNetPlayers.empty()) return BuildSpaceship();
+		if (mSpaceship && mSpaceship->GetWorld() == NULL) return mSpaceship;
+		return CreateSpaceship();
+	}
+	if (state.type == GameObjectType("DemoSpaceship").GetTypeID()) {
+		if (mDemoSpaceship && mDemoSpaceship->GetWorld() == NULL) return mDemoSpaceship;
+		return CreateDemoSpaceship();
+	}
+	return shared_ptr<GameObject>();
+}
+
+/** Fly a ship with the buttons a networked player is holding down. */
+void Asteroids::SteerSpaceship(shared_ptr<Spaceship> spaceship, uint buttons)
+{
+	spaceship->Thrust((buttons & NET_INPUT_THRUST) ? 10.0f : 0.0f);
+	if (buttons & NET_INPUT_LEFT) spaceship->Rotate(90);
+	else if (buttons & NET_INPUT_RIGHT) spaceship->Rotate(-90);
+	else spaceship->Rotate(0);
+}
+
+/** Pass a key held down in the window on to whatever is running the game. */
+void Asteroids::PressNetButton(uint button, bool pressed)
+{
+	if (IsClient()) mNetClient->SetButtons(pressed ? mNetClient->GetButtons() | button : mNetClient->GetButtons() & ~button);
+	if (IsPeer()) mRollbackSession->SetButtons(pressed ? mRollbackSession->GetButtons() | button : mRollbackSession->GetButtons() & ~button);
 }
\ No newline at end of file
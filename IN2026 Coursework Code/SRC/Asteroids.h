@@ -9,13 +9,21 @@
 #include "ScoreKeeper.h"
 #include "Player.h"
 #include "IPlayerListener.h"
+#include "ISnapshotListener.h"
+#include "INetServerListener.h"
+#include "IRollbackListener.h"
+#include "RandomStream.h"
+#include "AssetBundle.h"
+#include "HighScoreStore.h"
 
 class GameObject;
 class Spaceship;
 class DemoSpaceship;
 class GUILabel;
+class Shape;
+struct GameObjectState;
 
-class Asteroids : public GameSession, public IKeyboardListener, public IGameWorldListener, public IScoreListener, public IPlayerListener
+class Asteroids : public GameSession, public IKeyboardListener, public IGameWorldListener, public IScoreListener, public IPlayerListener, public ISnapshotListener, public INetServerListener, public IRollbackListener
 {
 public:
 	Asteroids(int argc, char *argv[]);
@@ -23,6 +31,7 @@ public:
 
 	virtual void Start(void);
 	virtual void Stop(void);
+	virtual void OnFrame(void);
 
 	// Declaration of IKeyboardListener interface ////////////////////////////////
 
@@ -38,6 +47,7 @@ public:
 	// Declaration of the IPlayerLister interface //////////////////////////////
 
 	void OnPlayerKilled(int lives_left);
+	void OnLivesChanged(int lives);
 
 	// Declaration of IGameWorldListener interface //////////////////////////////
 
@@ -45,12 +55,29 @@ public:
 	void OnObjectAdded(GameWorld* world, shared_ptr<GameObject> object) {}
 	void OnObjectRemoved(GameWorld* world, shared_ptr<GameObject> object);
 
+	// Declaration of ISnapshotListener interface ///////////////////////////////
+
+	void OnSnapshotTaken(GameWorld* world, WorldSnapshot& snapshot);
+	void OnSnapshotRestored(GameWorld* world, const WorldSnapshot& snapshot);
+
+	// Declaration of INetServerListener interface //////////////////////////////
+
+	void OnClientConnected(NetServer* server, uint client_id);
+	void OnClientInput(NetServer* server, uint client_id, const NetInput& input);
+	void OnClientDisconnected(NetServer* server, uint client_id);
+
+	// Declaration of IRollbackListener interface ///////////////////////////////
+
+	void OnRollbackFrame(RollbackSession* session, uint frame);
+	void OnRollbackInput(RollbackSession* session, uint player, uint buttons);
+
 	// Override the default implementation of ITimerListener ////////////////////
 	void OnTimer(int value);
 
 private:
 	shared_ptr<Spaceship> mSpaceship;
 	shared_ptr<DemoSpaceship> mDemoSpaceship;
+	shared_ptr<Shape> mBulletShape;
 	shared_ptr<GUILabel> mScoreLabel;
 	shared_ptr<GUILabel> mLivesLabel;
 	shared_ptr<GUILabel> mGameOverLabel;
@@ -63,31 +90,74 @@ private:
 	uint mLevel;
 	uint mAsteroidCount;
 
-	int mCurrentScore = 0;
-	int mHighScoreTopFromFile = 0;
-	int mHighScoreMidFromFile = 0;
-	int mHighScoreBotFromFile = 0;
+	HighScoreStore mHighScores;
+	string mPlayerName;
 
 	void ResetSpaceship();
+	shared_ptr<Spaceship> BuildSpaceship();
 	shared_ptr<GameObject> CreateSpaceship();
 	shared_ptr<GameObject> CreateDemoSpaceship();
 	void CreateGUI();
+	void LoadAssets();
+	shared_ptr<GameObject> CreateAsteroid(float scale);
 	void CreateAsteroids(const uint num_asteroids);
 	void CreateSmallerAsteroids(const uint num_asteroids, GLVector3f p);
-	void ReadHighScoresFromFile();
-	void SaveHighScoresToFile();
-	void RefreshHighScores(shared_ptr<GUILabel> RefreshGUILabel, string value);
+	void OpenHighScores();
+	string GetHighScoreText(uint rank, uint player_rank);
+	void RefreshHighScores(uint player_rank);
 	shared_ptr<GameObject> CreateExplosion();
+	shared_ptr<GameObject> CreateObject(const GameObjectState& state);
+	void SteerSpaceship(shared_ptr<Spaceship> spaceship, uint buttons);
+	void PressNetButton(uint button, bool pressed);
 	
 	const static uint SHOW_GAME_OVER = 0;
 	const static uint START_NEXT_LEVEL = 1;
 	const static uint CREATE_NEW_PLAYER = 2;
 	const static uint DEMOSPACESHIP_SHOOT = 4;
 	const static uint DEMOSPACESHIP_RESPAWN = 5;
+	const static uint NET_BOT_INPUT = 6;
+	// Plus the id of the client whose ship comes back
+	const static uint NET_RESPAWN_PLAYER = 100;
+	// Most shots a ship fires for one input, however many the client asks for
+	const static uint NET_MAX_SHOTS = 3;
+
+	// Game values kept in snapshots alongside the world
+	enum SnapshotKey
+	{
+		SNAPSHOT_SCORE = 1,
+		SNAPSHOT_LIVES,
+		SNAPSHOT_LEVEL,
+		SNAPSHOT_ASTEROID_COUNT,
+		SNAPSHOT_GAME_STARTED,
+		SNAPSHOT_SPACESHIP_ID,
+		SNAPSHOT_DEMO_SPACESHIP_ID,
+		SNAPSHOT_VISIBLE_LABELS,
+		// Plus the player, for games with more than one
+		SNAPSHOT_NET_PLAYER_SPACESHIP_ID = 100,
+	};
+	const static char* QUICK_SAVE_FILENAME;
+	const static char* HIGH_SCORE_LOG_FILENAME;
+	// Where older versions kept the top three scores, read once into a new log
+	const static char* LEGACY_HIGH_SCORE_FILENAME;
 
 	ScoreKeeper mScoreKeeper;
 	Player mPlayer;
 	bool mGameStarted;
+	AssetBundle mAssetBundle;
+
+	// A client's ship in a game run with --server, or a player's with --peer.
+	// Everyone plays for the same score, and a ship that is destroyed comes
+	// back without losing a life.
+	struct NetPlayer
+	{
+		shared_ptr<Spaceship> spaceship;
+		// Shots the client had asked for in its last input
+		uint shots;
+	};
+	typedef map<uint, NetPlayer> NetPlayerMap;
+	NetPlayerMap mNetPlayers;
+	// Plays for this peer without a window, apart from the world's own random streams
+	RandomStream mBotRandom;
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "GameWorld.h"
 #include "Bullet.h"
 #include "BoundingSphere.h"
+#include "WorldSnapshot.h"
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
@@ -46,6 +47,18 @@ void Bullet::Update(int t)
 
 }
 
+void Bullet::SaveState(GameObjectState& state)
+{
+	GameObject::SaveState(state);
+	state.user_int = mTimeToLive;
+}
+
+void Bullet::RestoreState(const GameObjectState& state)
+{
+	GameObject::RestoreState(state);
+	mTimeToLive = state.user_int;
+}
+
 bool Bullet::CollisionTest(shared_ptr<GameObject> o)
 {
 	if (o->GetType() != GameObjectType("Asteroid")) return false;
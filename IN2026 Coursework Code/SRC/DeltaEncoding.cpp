@@ -0,0 +1,105 @@
+#include "DeltaEncoding.h"
+
+// Zeros shorter than this are cheaper to leave in a literal run
+static const size_t MIN_ZERO_RUN = 4;
+
+typedef unsigned long long Word;
+
+static const Word LOW_BITS = 0x0101010101010101ull;
+static const Word HIGH_BITS = 0x8080808080808080ull;
+
+static Word LoadWord(const char* p)
+{
+	Word word;
+	memcpy(&word, p, sizeof(word));
+	return word;
+}
+
+static bool HasZeroByte(Word word)
+{
+	return 0 != ((word - LOW_BITS) & ~word & HIGH_BITS);
+}
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+void DeltaEncoding::WriteVarint(string& data, size_t value)
+{
+	while (value >= 0x80) {
+		data.push_back((char)(value | 0x80));
+		value >>= 7;
+	}
+	data.push_back((char)value);
+}
+
+bool DeltaEncoding::ReadVarint(const char* data, size_t size, size_t& offset, size_t& value)
+{
+	value = 0;
+	for (uint shift = 0; shift < 8 * sizeof(size_t); shift += 7) {
+		if (offset >= size) return false;
+		uchar byte = (uchar)data[offset++];
+		value |= (size_t)(byte & 0x7F) << shift;
+		if (byte < 0x80) return true;
+	}
+	return false;
+}
+
+/** XOR a with b into dst, which may be either of them. */
+void DeltaEncoding::XorBytes(char* dst, const char* a, const char* b, size_t size)
+{
+	size_t i = 0;
+	for (; i + sizeof(Word) <= size; i += sizeof(Word)) {
+		Word word = LoadWord(a + i) ^ LoadWord(b + i);
+		memcpy(dst + i, &word, sizeof(word));
+	}
+	for (; i < size; i++) dst[i] = a[i] ^ b[i];
+}
+
+/** Encode raw as its size followed by alternating runs of zeros and literal
+	bytes, each run preceded by its length. */
+void DeltaEncoding::CompressZeroRuns(const char* raw, size_t size, string& data)
+{
+	data.clear();
+	WriteVarint(data, size);
+	size_t i = 0;
+	while (i < size) {
+		// Most of a delta is zeros, so skip them a word at a time
+		size_t start = i;
+		while (i + sizeof(Word) <= size && LoadWord(raw + i) == 0) i += sizeof(Word);
+		while (i < size && raw[i] == 0) i++;
+		size_t zeros = i - start;
+
+		// Likewise for words with no zeros at all in a literal run
+		start = i;
+		while (i < size) {
+			if (i + sizeof(Word) <= size && !HasZeroByte(LoadWord(raw + i))) { i += sizeof(Word); continue; }
+			if (raw[i] != 0) { i++; continue; }
+			size_t j = i;
+			while (j < size && j - i < MIN_ZERO_RUN && raw[j] == 0) j++;
+			if (j - i >= MIN_ZERO_RUN || j == size) break;
+			i = j;
+		}
+		WriteVarint(data, zeros);
+		WriteVarint(data, i - start);
+		data.append(raw + start, i - start);
+	}
+}
+
+/** Decode what CompressZeroRuns wrote. A run of zeros can be any length in a few bytes,
+	so the caller gives the largest size it will accept rather than allocating whatever the data says. */
+bool DeltaEncoding::ExpandZeroRuns(const char* data, size_t size, size_t max_raw_size, string& raw)
+{
+	size_t offset = 0, raw_size;
+	if (!ReadVarint(data, size, offset, raw_size) || raw_size > max_raw_size) return false;
+	raw.assign(raw_size, '\0');
+	size_t i = 0;
+	while (i < raw_size) {
+		size_t zeros, literals;
+		if (!ReadVarint(data, size, offset, zeros) || !ReadVarint(data, size, offset, literals)) return false;
+		if (zeros > raw_size - i || literals > raw_size - i - zeros || literals > size - offset) return false;
+		i += zeros;
+		memcpy(&raw[i], data + offset, literals);
+		i += literals;
+		offset += literals;
+	}
+	return offset == size;
+}
\ No newline at end of file
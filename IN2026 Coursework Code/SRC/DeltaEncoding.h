@@ -0,0 +1,87 @@
+#ifndef __DELTAENCODING_H__
+#define __DELTAENCODING_H__
+
+#include <string.h>
+#include <vector>
+#include "GameUtil.h"
+
+// Encoding of arrays of fixed size records, each with an id, as changes from
+// an earlier version of the same array. Each record is XORed with the one
+// with the same id in the base, so fields that have not changed become zeros,
+// and runs of zeros are then replaced by their length. Records in id order
+// are matched in a single pass. Decoding checks every size it reads against
+// the bytes there are before allocating, so bad input is rejected cheaply.
+class DeltaEncoding
+{
+public:
+	static void WriteVarint(string& data, size_t value);
+	static bool ReadVarint(const char* data, size_t size, size_t& offset, size_t& value);
+	static void XorBytes(char* dst, const char* a, const char* b, size_t size);
+	static void CompressZeroRuns(const char* raw, size_t size, string& data);
+	static bool ExpandZeroRuns(const char* data, size_t size, size_t max_raw_size, string& raw);
+
+	template <class T> static void AppendRecords(const vector<T>& records, const vector<T>& base, string& raw);
+	template <class T> static bool ReadRecords(const char* raw, size_t size, size_t& offset, uint count, const vector<T>& base, vector<T>& records);
+
+private:
+	DeltaEncoding() {} // Not instantiated
+
+	template <class T> static const T* FindRecord(const vector<T>& records, uint id, uint& hint);
+};
+
+/** Append the ids of the records as gaps from the one before, then each record XORed with its base. */
+template <class T>
+void DeltaEncoding::AppendRecords(const vector<T>& records, const vector<T>& base, string& raw)
+{
+	uint previous_id = 0;
+	for (uint i = 0; i < records.size(); i++) {
+		WriteVarint(raw, records[i].id - previous_id);
+		previous_id = records[i].id;
+	}
+
+	// Records that are new since the base are XORed with nothing
+	static const char none[sizeof(T)] = { 0 };
+	size_t offset = raw.size();
+	raw.resize(offset + records.size() * sizeof(T));
+	uint hint = 0;
+	for (uint i = 0; i < records.size(); i++) {
+		const T* base_record = FindRecord(base, records[i].id, hint);
+		XorBytes(&raw[offset], (const char*)&records[i], (base_record ? (const char*)base_record : none), sizeof(T));
+		offset += sizeof(T);
+	}
+}
+
+template <class T>
+bool DeltaEncoding::ReadRecords(const char* raw, size_t size, size_t& offset, uint count, const vector<T>& base, vector<T>& records)
+{
+	// Each record takes at least a byte for its id as well as its own size
+	if (offset > size || count > (size - offset) / (sizeof(T) + 1)) return false;
+	vector<uint> ids(count);
+	uint id = 0;
+	for (uint i = 0; i < count; i++) {
+		size_t id_delta;
+		if (!ReadVarint(raw, size, offset, id_delta)) return false;
+		id += (uint)id_delta;
+		ids[i] = id;
+	}
+	if ((size - offset) / sizeof(T) < count) return false;
+
+	static const char none[sizeof(T)] = { 0 };
+	records.resize(count);
+	uint hint = 0;
+	for (uint i = 0; i < count; i++) {
+		const T* base_record = FindRecord(base, ids[i], hint);
+		XorBytes((char*)&records[i], raw + offset, (base_record ? (const char*)base_record : none), sizeof(T));
+		offset += sizeof(T);
+	}
+	return true;
+}
+
+template <class T>
+const T* DeltaEncoding::FindRecord(const vector<T>& records, uint id, uint& hint)
+{
+	while (hint < records.size() && records[hint].id < id) hint++;
+	return (hint < records.size() && records[hint].id == id) ? &records[hint] : NULL;
+}
+
+#endif
\ No newline at end of file
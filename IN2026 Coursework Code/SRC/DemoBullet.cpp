@@ -1,6 +1,7 @@
 #include "GameWorld.h"
 #include "DemoBullet.h"
 #include "BoundingSphere.h"
+#include "WorldSnapshot.h"
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
@@ -46,6 +47,18 @@ void DemoBullet::Update(int t)
 
 }
 
+void DemoBullet::SaveState(GameObjectState& state)
+{
+	GameObject::SaveState(state);
+	state.user_int = mTimeToLive;
+}
+
+void DemoBullet::RestoreState(const GameObjectState& state)
+{
+	GameObject::RestoreState(state);
+	mTimeToLive = state.user_int;
+}
+
 bool DemoBullet::CollisionTest(shared_ptr<GameObject> o)
 {
 	if (o->GetType() != GameObjectType("Asteroid") && o->GetType() != GameObjectType("Spaceship")) return false;
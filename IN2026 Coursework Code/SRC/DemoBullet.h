@@ -20,6 +20,9 @@ public:
 	bool CollisionTest(shared_ptr<GameObject> o);
 	void OnCollision(const GameObjectList& objects);
 
+	virtual void SaveState(GameObjectState& state);
+	virtual void RestoreState(const GameObjectState& state);
+
 protected:
 	int mTimeToLive;
 };
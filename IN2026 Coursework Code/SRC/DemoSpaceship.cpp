@@ -3,6 +3,8 @@
 #include "DemoBullet.h"
 #include "Spaceship.h"
 #include "BoundingSphere.h"
+#include "RenderQueue.h"
+#include "WorldSnapshot.h"
 #include "DemoSpaceship.h"
 
 using namespace std;
@@ -41,6 +43,19 @@ void DemoSpaceship::Update(int t)
 	GameObject::Update(t);
 }
 
+/** Save this spaceship's thrust, which decides whether the thruster is drawn. */
+void DemoSpaceship::SaveState(GameObjectState& state)
+{
+	GameObject::SaveState(state);
+	state.user_float = mDemoThrust;
+}
+
+void DemoSpaceship::RestoreState(const GameObjectState& state)
+{
+	GameObject::RestoreState(state);
+	mDemoThrust = state.user_float;
+}
+
 /** Render this spaceship. */
 void DemoSpaceship::Render(void)
 {
@@ -54,6 +69,19 @@ void DemoSpaceship::Render(void)
 	GameObject::Render();
 }
 
+/** Submit this spaceship's shapes for rendering. */
+void DemoSpaceship::Submit(RenderQueue& queue)
+{
+	if (mDemoSpaceshipShape.get() != NULL) queue.SubmitShape(mRenderLayer, this, mDemoSpaceshipShape.get());
+
+	// If ship is thrusting
+	if ((mDemoThrust > 0) && (mDemoThrusterShape.get() != NULL)) {
+		queue.SubmitShape(mRenderLayer, this, mDemoThrusterShape.get());
+	}
+
+	GameObject::Submit(queue);
+}
+
 /** Fire the rockets. */
 void DemoSpaceship::Thrust(float t)
 {
@@ -0,0 +1,32 @@
+#include <stdio.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "FileUtil.h"
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+/** Move a fully written temporary file over the given one. Its contents are
+	flushed to disk first, so after a crash the file holds either its old
+	contents or all of the new ones, never an empty or part-written file. */
+bool FileUtil::Replace(const string& temp_filename, const string& filename)
+{
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(temp_filename.c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE) return false;
+	bool flushed = (0 != FlushFileBuffers(handle));
+	CloseHandle(handle);
+	if (!flushed) return false;
+	return (0 != MoveFileExA(temp_filename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH));
+#else
+	int fd = open(temp_filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	bool flushed = (0 == fsync(fd));
+	close(fd);
+	if (!flushed) return false;
+	return (0 == rename(temp_filename.c_str(), filename.c_str()));
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef __FILEUTIL_H__
+#define __FILEUTIL_H__
+
+#include "GameUtil.h"
+
+// File operations that differ between platforms
+class FileUtil
+{
+public:
+	static bool Replace(const string& temp_filename, const string& filename);
+
+private:
+	FileUtil() {} // Not instantiated
+};
+
+#endif
\ No newline at end of file
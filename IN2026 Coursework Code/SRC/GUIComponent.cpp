@@ -9,7 +9,8 @@ GUIComponent::GUIComponent()
 	  mHorizontalAlignment(GUI_HALIGN_LEFT),
 	  mVerticalAlignment(GUI_VALIGN_BOTTOM),
 	  mColor(1, 1, 1),
-	  mVisible(true)
+	  mVisible(true),
+	  mDirty(true)
 {
 }
 
@@ -24,3 +25,10 @@ GUIComponent::~GUIComponent()
 void GUIComponent::Draw()
 {
 }
+
+/** Get the rectangle this component draws into, from min up to but not including max. */
+void GUIComponent::GetBounds(GLVector2i& min, GLVector2i& max)
+{
+	min = mPosition;
+	max = mPosition + mSize;
+}
@@ -27,25 +27,32 @@ public:
 	
 	virtual GLVector2i GetPreferredSize() { return GLVector2i(0,0); }
 
-	virtual void SetSize(const GLVector2i& size) { mSize = size; }
+	// Anything that changes how a component looks marks it dirty, so a cached
+	// copy of the display only has to redraw the area it covers
+	virtual bool IsDirty() { return mDirty; }
+	virtual void ClearDirty() { mDirty = false; }
+	void MarkDirty() { mDirty = true; }
+	virtual void GetBounds(GLVector2i& min, GLVector2i& max);
+
+	virtual void SetSize(const GLVector2i& size) { mSize = size; mDirty = true; }
 	GLVector2i GetSize() { return mSize; }
 
-	virtual void SetPosition(const GLVector2i& position) { mPosition = position; }
+	virtual void SetPosition(const GLVector2i& position) { mPosition = position; mDirty = true; }
 	GLVector2i GetPosition() { return mPosition; }
 
-	void SetHorizontalAlignment(GUIHorizontalAlignment halignment) { mHorizontalAlignment = halignment; }
+	void SetHorizontalAlignment(GUIHorizontalAlignment halignment) { mHorizontalAlignment = halignment; mDirty = true; }
 	GUIHorizontalAlignment GetHorizontalAlignment() { return mHorizontalAlignment; }
 
-	void SetVerticalAlignment(GUIVerticalAlignment valignment) { mVerticalAlignment = valignment; }
+	void SetVerticalAlignment(GUIVerticalAlignment valignment) { mVerticalAlignment = valignment; mDirty = true; }
 	GUIVerticalAlignment GetVerticalAlignment() { return mVerticalAlignment; }
 
-	void SetBorder(const GLVector2i& border) { mBorder = border; }
+	void SetBorder(const GLVector2i& border) { mBorder = border; mDirty = true; }
 	GLVector2i GetBorder() { return mBorder; }
 	
-	void SetVisible(bool visible) { mVisible = visible; }
+	void SetVisible(bool visible) { if (visible != mVisible) { mVisible = visible; mDirty = true; } }
 	bool GetVisible() { return mVisible; }
 	
-	void SetColor(const GLVector3f& color) { mColor = color; }
+	void SetColor(const GLVector3f& color) { mColor = color; mDirty = true; }
 	GLVector3f GetColor() { return mColor; }
 protected:
 	GLVector2i mSize;
@@ -53,6 +60,7 @@ protected:
 	GLVector2i mBorder;
 	GLVector3f mColor;
 	bool mVisible;
+	bool mDirty;
 	GUIHorizontalAlignment mHorizontalAlignment;
 	GUIVerticalAlignment mVerticalAlignment;
 };
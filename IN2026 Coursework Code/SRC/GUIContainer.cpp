@@ -1,5 +1,18 @@
 #include "GUIContainer.h"
 
+// Whether two rectangles, each from min up to but not including max, overlap
+static bool Overlaps(const GLVector2i& min1, const GLVector2i& max1, const GLVector2i& min2, const GLVector2i& max2)
+{
+	return min1.x < max2.x && min2.x < max1.x && min1.y < max2.y && min2.y < max1.y;
+}
+
+// Grow a rectangle to include another
+static void AddToRegion(GLVector2i& min, GLVector2i& max, const GLVector2i& add_min, const GLVector2i& add_max)
+{
+	min = GLVector2i(std::min(min.x, add_min.x), std::min(min.y, add_min.y));
+	max = GLVector2i(std::max(max.x, add_max.x), std::max(max.y, add_max.y));
+}
+
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
 /** Default constructor */
@@ -14,28 +27,43 @@ GUIContainer::~GUIContainer()
 
 // PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
 
-/** Add a component to this container at the given relative position. */
-void GUIContainer::AddComponent( shared_ptr<GUIComponent> component, GLVector2f position )
+/** Add a component to this container at the given relative position and z-order.
+	Adding a component that is already in the container moves it. */
+void GUIContainer::AddComponent( shared_ptr<GUIComponent> component, GLVector2f position, int z )
 {
-	mComponents[component] = position;
+	RemoveComponent(component);
+	GUIComponentVector::iterator it = mComponents.begin();
+	while (it != mComponents.end() && it->z <= z) ++it;
+
+	GUIComponentEntry entry;
+	entry.component = component;
+	entry.position = position;
+	entry.z = z;
+	entry.drawn = false;
+	mComponents.insert(it, entry);
 	mLayoutRequired = true;
+	mDirty = true;
 }
 
 /** Remove a component from this container. */
 void GUIContainer::RemoveComponent( shared_ptr<GUIComponent> component )
 {
-	mComponents.erase( component );
+	for (GUIComponentVector::iterator it = mComponents.begin(); it != mComponents.end(); ++it) {
+		if (it->component == component) {
+			mComponents.erase(it);
+			mDirty = true;
+			return;
+		}
+	}
 }
 
-/** Draw this container by drawing all of its components. */
+/** Draw this container by drawing all of its components, lowest z first. */
 void GUIContainer::Draw()
 {
 	if (mLayoutRequired) LayoutComponents();
 	
-	for (GUIComponentMap::iterator it = mComponents.begin(); it != mComponents.end(); ++it) {
-		shared_ptr<GUIComponent> component = it->first;
-		GLVector2f position = it->second;
-		component->Draw();
+	for (GUIComponentVector::iterator it = mComponents.begin(); it != mComponents.end(); ++it) {
+		it->component->Draw();
 	}
 }
 
@@ -46,12 +74,72 @@ void GUIContainer::SetSize(const GLVector2i& size)
 	LayoutComponents();
 }
 
+/** Whether the container or any of its components has changed since ClearDirty(). */
+bool GUIContainer::IsDirty()
+{
+	if (mDirty || mLayoutRequired) return true;
+	for (GUIComponentVector::iterator it = mComponents.begin(); it != mComponents.end(); ++it) {
+		if (it->component->IsDirty()) return true;
+	}
+	return false;
+}
+
+/** Remember where every component is now, and treat them all as unchanged. */
+void GUIContainer::ClearDirty()
+{
+	for (GUIComponentVector::iterator it = mComponents.begin(); it != mComponents.end(); ++it) {
+		it->component->GetBounds(it->drawn_min, it->drawn_max);
+		it->drawn = true;
+		it->component->ClearDirty();
+	}
+	mDirty = false;
+}
+
+/** Get the smallest rectangle covering every changed component, both where it
+	was last drawn and where it is now. Returns false if nothing has changed. */
+bool GUIContainer::GetDirtyRegion(GLVector2i& min, GLVector2i& max)
+{
+	if (mLayoutRequired) LayoutComponents();
+	if (mDirty) {
+		GetBounds(min, max);
+		return true;
+	}
+
+	bool dirty = false;
+	for (GUIComponentVector::iterator it = mComponents.begin(); it != mComponents.end(); ++it) {
+		if (!it->component->IsDirty()) continue;
+		GLVector2i component_min, component_max;
+		it->component->GetBounds(component_min, component_max);
+		if (!dirty) {
+			min = component_min;
+			max = component_max;
+			dirty = true;
+		} else {
+			AddToRegion(min, max, component_min, component_max);
+		}
+		if (it->drawn) AddToRegion(min, max, it->drawn_min, it->drawn_max);
+	}
+	return dirty;
+}
+
+/** Draw only the components overlapping a region, lowest z first. */
+void GUIContainer::DrawRegion(const GLVector2i& min, const GLVector2i& max)
+{
+	if (mLayoutRequired) LayoutComponents();
+
+	for (GUIComponentVector::iterator it = mComponents.begin(); it != mComponents.end(); ++it) {
+		GLVector2i component_min, component_max;
+		it->component->GetBounds(component_min, component_max);
+		if (Overlaps(min, max, component_min, component_max)) it->component->Draw();
+	}
+}
+
 /** Layout all of this container's components using relative positions. */
 void GUIContainer::LayoutComponents()
 {
-	for (GUIComponentMap::iterator it = mComponents.begin(); it != mComponents.end(); ++it) {
-		shared_ptr<GUIComponent> ptr = it->first;
-		GLVector2f position = it->second;
+	for (GUIComponentVector::iterator it = mComponents.begin(); it != mComponents.end(); ++it) {
+		shared_ptr<GUIComponent> ptr = it->component;
+		GLVector2f position = it->position;
 		int xpos = mPosition.x + mBorder.x + (int)((mSize.x - 2 * mBorder.x) * position.x);
 		int ypos = mPosition.y + mBorder.y + (int)((mSize.y - 2 * mBorder.y) * position.y);
 		ptr->SetPosition(GLVector2i(xpos, ypos));
@@ -1,10 +1,25 @@
 #ifndef __GUICONTAINER_H__
 #define __GUICONTAINER_H__
 
+#include <vector>
 #include "GameUtil.h"
 #include "GUIComponent.h"
 
-typedef map< shared_ptr<GUIComponent>, GLVector2f > GUIComponentMap;
+// A component placed in a container. Components with a higher z are drawn
+// on top, and those with the same z in the order they were added.
+struct GUIComponentEntry
+{
+	shared_ptr<GUIComponent> component;
+	GLVector2f position;
+	int z;
+
+	// Where the component was when the container was last drawn
+	bool drawn;
+	GLVector2i drawn_min;
+	GLVector2i drawn_max;
+};
+
+typedef vector<GUIComponentEntry> GUIComponentVector;
 
 class GUIContainer : public GUIComponent
 {
@@ -13,11 +28,17 @@ public:
 	virtual ~GUIContainer();
 	virtual void Draw();
 	virtual void SetSize(const GLVector2i& size);
-	void AddComponent( shared_ptr<GUIComponent> component, GLVector2f position );
+	void AddComponent( shared_ptr<GUIComponent> component, GLVector2f position, int z = 0 );
 	void RemoveComponent( shared_ptr<GUIComponent> component );
+
+	// Retained drawing: redraw only the components in the area that changed
+	virtual bool IsDirty();
+	virtual void ClearDirty();
+	bool GetDirtyRegion(GLVector2i& min, GLVector2i& max);
+	void DrawRegion(const GLVector2i& min, const GLVector2i& max);
 protected:
 	void LayoutComponents();
-	GUIComponentMap mComponents;
+	GUIComponentVector mComponents;
 	bool mLayoutRequired;
 };
 
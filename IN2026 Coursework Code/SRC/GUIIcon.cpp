@@ -35,8 +35,17 @@ void GUIIcon::Draw()
 	glDisable(GL_ALPHA_TEST);
 }
 
+/** Get the rectangle covered by the image. */
+void GUIIcon::GetBounds(GLVector2i& min, GLVector2i& max)
+{
+	min = mPosition + mBorder;
+	max = min;
+	if (mImage != NULL) max += GLVector2i(mImage->GetWidth(), mImage->GetHeight());
+}
+
 /** Set the image drawn by this icon. */
 void GUIIcon::SetImage(Image* image)
 {
 	mImage = image;
+	mDirty = true;
 }
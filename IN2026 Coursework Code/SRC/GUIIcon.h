@@ -12,6 +12,7 @@ public:
 	GUIIcon(Image* image);
 	virtual ~GUIIcon();
 	virtual void Draw();
+	virtual void GetBounds(GLVector2i& min, GLVector2i& max);
 	void SetImage(Image* i);
 protected:
 	Image* mImage;
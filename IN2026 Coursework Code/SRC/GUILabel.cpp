@@ -1,15 +1,17 @@
 #include <string>
+#include <string.h>
 #include "GUILabel.h"
+#include "RenderState.h"
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
 /** Default constructor. */
-GUILabel::GUILabel() : mText(""), mFontWidth(9), mFontHeight(15)
+GUILabel::GUILabel() : mText(""), mFontWidth(TextRenderer::FONT_WIDTH), mFontHeight(TextRenderer::FONT_HEIGHT), mVerticesValid(false)
 {
 }
 
 /** Construct label with given text. */
-GUILabel::GUILabel(const string& text) : mText(text), mFontWidth(9), mFontHeight(15)
+GUILabel::GUILabel(const string& text) : mText(text), mFontWidth(TextRenderer::FONT_WIDTH), mFontHeight(TextRenderer::FONT_HEIGHT), mVerticesValid(false)
 {
 }
 
@@ -20,11 +22,85 @@ GUILabel::~GUILabel()
 
 // PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
 
-/** Draw label by drawing text with a fixed font. */
+/** Draw label by drawing text with a fixed font, from the glyph atlas if there is one. */
 void GUILabel::Draw()
 {
 	if (!mVisible) return;
 
+	int x, y;
+	GetTextOrigin(x, y);
+
+	TextRenderer& renderer = TextRenderer::GetInstance();
+	if (renderer.IsCreated()) {
+		if (!mVerticesValid || x != mVerticesX || y != mVerticesY) {
+			renderer.LayoutText(mText, x, y, mVertices);
+			mVerticesValid = true;
+			mVerticesX = x;
+			mVerticesY = y;
+		}
+		renderer.AddText(mVertices, mColor);
+		return;
+	}
+
+	RenderState::GetInstance().ApplyMaterial(RENDER_MATERIAL_TEXT);
+	glColor3f(mColor[0], mColor[1], mColor[2]);
+	glRasterPos2i(x, y);
+	for (uint i = 0; i < mText.length(); ++i) {
+		glutBitmapCharacter(GLUT_BITMAP_9_BY_15, mText[i]);
+	}
+}
+
+/** Get the box around the text. Glyphs reach a few pixels below the baseline, and a pixel either side. */
+void GUILabel::GetBounds(GLVector2i& min, GLVector2i& max)
+{
+	int x, y;
+	GetTextOrigin(x, y);
+	min = GLVector2i(x - 1, y - 4);
+	max = GLVector2i(x + (int)mText.length() * mFontWidth + 1, y + mFontHeight + 1);
+}
+
+/** Set the text, which is laid out again the next time the label is drawn. */
+void GUILabel::SetText(const string& text)
+{
+	SetText(text.data(), text.length());
+}
+
+/** Set the text to a prefix followed by a number, e.g. "Score: " and 120.
+	Formats on the stack, so nothing is allocated once the label has had
+	text this long before. */
+void GUILabel::SetText(const char* prefix, int value)
+{
+	char buffer[64];
+	size_t length = min(strlen(prefix), sizeof(buffer) - 11);
+	memcpy(buffer, prefix, length);
+
+	// Write the digits backwards, working in unsigned so INT_MIN negates safely
+	char digits[10];
+	uint magnitude = (value < 0) ? 0u - (uint)value : (uint)value;
+	uint num_digits = 0;
+	do {
+		digits[num_digits++] = (char)('0' + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+	if (value < 0) buffer[length++] = '-';
+	while (num_digits > 0) buffer[length++] = digits[--num_digits];
+
+	SetText(buffer, length);
+}
+
+// PROTECTED INSTANCE METHODS /////////////////////////////////////////////////
+
+void GUILabel::SetText(const char* text, size_t length)
+{
+	if (mText.compare(0, string::npos, text, length) == 0) return;
+	mText.assign(text, length);
+	mVerticesValid = false;
+	mDirty = true;
+}
+
+/** Get where the text starts, after aligning it to the label's position. */
+void GUILabel::GetTextOrigin(int& x, int& y)
+{
 	int w = (int)(mText.length() * mFontWidth);
 	int h = mFontHeight;
 
@@ -42,11 +118,6 @@ void GUILabel::Draw()
 		align_y = -h/2;
 	}
 
-	glDisable(GL_LIGHTING);
-	glColor3f(mColor[0], mColor[1], mColor[2]);
-	glRasterPos2i(mPosition.x + mBorder.x + align_x, mPosition.y + mBorder.y + align_y);
-	for (uint i = 0; i < mText.length(); ++i) {
-		glutBitmapCharacter(GLUT_BITMAP_9_BY_15, mText[i]);
-	}
-	glEnable(GL_LIGHTING);
+	x = mPosition.x + mBorder.x + align_x;
+	y = mPosition.y + mBorder.y + align_y;
 }
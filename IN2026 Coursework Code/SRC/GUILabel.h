@@ -3,6 +3,7 @@
 
 #include "GameUtil.h"
 #include "GUIComponent.h"
+#include "TextRenderer.h"
 
 class GUILabel : public GUIComponent
 {
@@ -11,11 +12,22 @@ public:
 	GUILabel(const string& t);
 	virtual ~GUILabel();
 	virtual void Draw();
-	void SetText(const string& text) { mText = text; }
+	virtual void GetBounds(GLVector2i& min, GLVector2i& max);
+	void SetText(const string& text);
+	void SetText(const char* prefix, int value);
 protected:
+	void SetText(const char* text, size_t length);
+	void GetTextOrigin(int& x, int& y);
+
 	string mText;
 	int mFontWidth;
 	int mFontHeight;
+
+	// Glyph quads for mText, laid out again only when the text or its origin changes
+	TextVertexVector mVertices;
+	bool mVerticesValid;
+	int mVerticesX;
+	int mVerticesY;
 };
 
 #endif
\ No newline at end of file
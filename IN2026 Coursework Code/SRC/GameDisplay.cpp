@@ -1,28 +1,85 @@
 #include "GameUtil.h"
 #include "GUIComponent.h"
 #include "GameDisplay.h"
+#include "RenderState.h"
+#include "TextRenderer.h"
+
+// Smallest power of two at least as big as n, as OpenGL 1.1 textures must be
+static int NextPowerOfTwo(int n)
+{
+	int p = 1;
+	while (p < n) p *= 2;
+	return p;
+}
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
 /** Default constructor. */
-GameDisplay::GameDisplay(void) : mWidth(200), mHeight(200)
+GameDisplay::GameDisplay(void)
+	: mWidth(200),
+	  mHeight(200),
+	  mOverlayEnabled(false),
+	  mOverlayTexture(0),
+	  mOverlayWidth(0),
+	  mOverlayHeight(0),
+	  mOverlayTextureWidth(0),
+	  mOverlayTextureHeight(0),
+	  mOverlayUpdates(0)
 {
 }
 
 /** Construct display with given size. */
-GameDisplay::GameDisplay(int w, int h) : mWidth(w), mHeight(h)
+GameDisplay::GameDisplay(int w, int h)
+	: mWidth(w),
+	  mHeight(h),
+	  mOverlayEnabled(false),
+	  mOverlayTexture(0),
+	  mOverlayWidth(0),
+	  mOverlayHeight(0),
+	  mOverlayTextureWidth(0),
+	  mOverlayTextureHeight(0),
+	  mOverlayUpdates(0)
 {
 }
 
 /** Destructor. */
 GameDisplay::~GameDisplay(void)
 {
+	ReleaseOverlay();
 }
 
 // PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
 
-/** Render display by rendering top level container. */
+/** Bring the cached overlay up to date. Must be called before the world is
+	drawn each frame, as changed parts are drawn in the back buffer first. */
+void GameDisplay::Prepare(void)
+{
+	if (!mOverlayEnabled) {
+		ReleaseOverlay();
+		return;
+	}
+	if (!UpdateOverlay()) ReleaseOverlay();
+}
+
+/** Render display by compositing the cached overlay, or by rendering top level container. */
 void GameDisplay::Render(void)
+{
+	SetProjection();
+
+	if (IsOverlayActive()) {
+		DrawOverlay();
+		return;
+	}
+
+	// Labels add their text to be drawn together once every component is done
+	TextRenderer::GetInstance().Begin();
+	mContainer.Draw();
+	TextRenderer::GetInstance().End();
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+void GameDisplay::SetProjection(void)
 {
 	// Update the projection matrix
 	glMatrixMode(GL_PROJECTION);
@@ -34,6 +91,81 @@ void GameDisplay::Render(void)
 	glMatrixMode(GL_MODELVIEW);
 	// Initialize the projection matrix to the identity matrix
 	glLoadIdentity();
+}
 
-	mContainer.Draw();
+/** Redraw the changed part of the display over a transparent background and
+	copy it into the overlay texture. Returns false if there can be no overlay. */
+bool GameDisplay::UpdateOverlay(void)
+{
+	// Without destination alpha the overlay cannot tell the display from its background
+	GLint alpha_bits = 0;
+	glGetIntegerv(GL_ALPHA_BITS, &alpha_bits);
+	if (alpha_bits == 0 || mWidth <= 0 || mHeight <= 0) return false;
+
+	GLVector2i min, max;
+	if (mOverlayTexture == 0 || mOverlayWidth != mWidth || mOverlayHeight != mHeight) {
+		ReleaseOverlay();
+		mOverlayWidth = mWidth;
+		mOverlayHeight = mHeight;
+		mOverlayTextureWidth = NextPowerOfTwo(mWidth);
+		mOverlayTextureHeight = NextPowerOfTwo(mHeight);
+		GLuint textures[1];
+		glGenTextures(1, &textures[0]);
+		mOverlayTexture = textures[0];
+		RenderState::GetInstance().BindTexture(mOverlayTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, mOverlayTextureWidth, mOverlayTextureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		min = GLVector2i(0, 0);
+		max = GLVector2i(mWidth, mHeight);
+	} else if (!mContainer.GetDirtyRegion(min, max)) {
+		return true;
+	}
+
+	// Only the dirty region is cleared, drawn and copied
+	min = GLVector2i(std::max(min.x, 0), std::max(min.y, 0));
+	max = GLVector2i(std::min(max.x, mWidth), std::min(max.y, mHeight));
+	if (min.x < max.x && min.y < max.y) {
+		glPushAttrib(GL_COLOR_BUFFER_BIT | GL_SCISSOR_BIT);
+		glScissor(min.x, min.y, max.x - min.x, max.y - min.y);
+		glEnable(GL_SCISSOR_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		SetProjection();
+		TextRenderer::GetInstance().Begin();
+		mContainer.DrawRegion(min, max);
+		TextRenderer::GetInstance().End();
+		RenderState::GetInstance().BindTexture(mOverlayTexture);
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, min.x, min.y, min.x, min.y, max.x - min.x, max.y - min.y);
+		glPopAttrib();
+		mOverlayUpdates++;
+	}
+	mContainer.ClearDirty();
+	return true;
+}
+
+/** Blend the overlay over the world with a single textured quad. */
+void GameDisplay::DrawOverlay(void)
+{
+	GLfloat u = (GLfloat)mOverlayWidth / mOverlayTextureWidth;
+	GLfloat v = (GLfloat)mOverlayHeight / mOverlayTextureHeight;
+	RenderState::GetInstance().ApplyMaterial(RENDER_MATERIAL_OVERLAY);
+	RenderState::GetInstance().BindTexture(mOverlayTexture);
+	glColor3f(1.0f, 1.0f, 1.0f);
+	glBegin(GL_QUADS);
+		glTexCoord2f(0, 0); glVertex2i(0, 0);
+		glTexCoord2f(u, 0); glVertex2i(mOverlayWidth, 0);
+		glTexCoord2f(u, v); glVertex2i(mOverlayWidth, mOverlayHeight);
+		glTexCoord2f(0, v); glVertex2i(0, mOverlayHeight);
+	glEnd();
+	RenderState::GetInstance().CountDrawCall();
+}
+
+void GameDisplay::ReleaseOverlay(void)
+{
+	if (mOverlayTexture == 0) return;
+	GLuint textures[1] = { mOverlayTexture };
+	glDeleteTextures(1, &textures[0]);
+	RenderState::GetInstance().ForgetTexture(mOverlayTexture);
+	mOverlayTexture = 0;
 }
@@ -12,8 +12,16 @@ public:
 	virtual ~GameDisplay(void);
 
 	virtual void Update(int t) {}
+	virtual void Prepare(void);
 	virtual void Render(void);
 
+	// Keep the display in a texture, redrawing only the parts that change and
+	// compositing it over the world each frame. Needs destination alpha.
+	void SetCachedOverlay(bool enabled) { mOverlayEnabled = enabled; }
+	bool GetCachedOverlay() const { return mOverlayEnabled; }
+	bool IsOverlayActive() const { return mOverlayTexture != 0; }
+	uint GetOverlayUpdateCount() const { return mOverlayUpdates; }
+
 	void Reshape(int w, int h)
 	{
 		mWidth = w;
@@ -31,6 +39,20 @@ protected:
 	int mHeight;
 	
 	GUIContainer mContainer;
+
+private:
+	void SetProjection(void);
+	bool UpdateOverlay(void);
+	void DrawOverlay(void);
+	void ReleaseOverlay(void);
+
+	bool mOverlayEnabled;
+	uint mOverlayTexture;
+	int mOverlayWidth;
+	int mOverlayHeight;
+	int mOverlayTextureWidth;
+	int mOverlayTextureHeight;
+	uint mOverlayUpdates;
 };
 
 #endif
\ No newline at end of file
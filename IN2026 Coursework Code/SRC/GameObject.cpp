@@ -1,5 +1,8 @@
 #include "GameWorld.h"
 #include "GameObject.h"
+#include "SpriteBatch.h"
+#include "RenderQueue.h"
+#include "WorldSnapshot.h"
 
 bool GameObject::mRenderDebug = false;
 
@@ -8,39 +11,45 @@ bool GameObject::mRenderDebug = false;
 /** Default constructor. */
 GameObject::GameObject(char const * const type_name)
 	: mType(type_name),
+	  mId(0),
 	  mWorld(NULL),
 	  mPosition(0,0,0),
 	  mVelocity(0,0,0),
 	  mAcceleration(0,0,0),
 	  mAngle(0),
 	  mRotation(0),
-	  mScale(1)
+	  mScale(1),
+	  mRenderLayer(0)
 {
 }
 
 /** Construct game object with given position, velocity, acceleration, angle and rotation. */
 GameObject::GameObject(char const * const type_name, GLVector3f p, GLVector3f v, GLVector3f a, GLfloat h, GLfloat r)
 	: mType(type_name),
+	  mId(0),
 	  mWorld(NULL),
 	  mPosition(p),
 	  mVelocity(v),
 	  mAcceleration(a),
 	  mAngle(h),
 	  mRotation(r),
-	  mScale(1)
+	  mScale(1),
+	  mRenderLayer(0)
 {
 }
 
 /** Copy constructor. */
 GameObject::GameObject(const GameObject& o)
 	: mType(o.mType.GetTypeName()),
+	  mId(0),
 	  mWorld(o.mWorld),
 	  mPosition(o.mPosition),
 	  mVelocity(o.mVelocity),
 	  mAcceleration(o.mAcceleration),
 	  mAngle(o.mAngle),
 	  mRotation(o.mRotation),
-	  mScale(o.mScale)
+	  mScale(o.mScale),
+	  mRenderLayer(o.mRenderLayer)
 {
 }
 
@@ -61,6 +70,47 @@ void GameObject::Reset()
 	SetRotation(0);
 }
 
+/** Save everything that changes as the game runs. Subclasses with more state add it to the user fields. */
+void GameObject::SaveState(GameObjectState& state)
+{
+	state.id = mId;
+	state.type = (uint)mType.GetTypeID();
+	state.position = mPosition;
+	state.velocity = mVelocity;
+	state.acceleration = mAcceleration;
+	state.angle = mAngle;
+	state.rotation = mRotation;
+	state.scale = mScale;
+	state.render_layer = mRenderLayer;
+	state.flags = 0;
+	state.sprite_frame = 0;
+	state.sprite_millis = 0;
+	if (mSprite.get() != NULL) {
+		state.flags |= GAME_OBJECT_STATE_HAS_SPRITE;
+		if (mSprite->IsAnimating()) state.flags |= GAME_OBJECT_STATE_ANIMATING;
+		state.sprite_frame = mSprite->GetCurrentFrame();
+		state.sprite_millis = mSprite->GetFrameMillis();
+	}
+	state.user_int = 0;
+	state.user_float = 0;
+}
+
+/** Put back state saved by SaveState. Shapes and sprites are left as they are. */
+void GameObject::RestoreState(const GameObjectState& state)
+{
+	mId = state.id;
+	mPosition = state.position;
+	mVelocity = state.velocity;
+	mAcceleration = state.acceleration;
+	mAngle = state.angle;
+	mRotation = state.rotation;
+	mScale = state.scale;
+	mRenderLayer = state.render_layer;
+	if (mSprite.get() != NULL && (state.flags & GAME_OBJECT_STATE_HAS_SPRITE)) {
+		mSprite->SetAnimationState(state.sprite_frame, state.sprite_millis, 0 != (state.flags & GAME_OBJECT_STATE_ANIMATING));
+	}
+}
+
 /** Update this game object by updating position, velocity and angle of object. */
 void GameObject::Update(int t)
 {
@@ -95,7 +145,19 @@ void GameObject::PreRender(void)
 void GameObject::Render(void)
 {
 	if (mShape.get() != NULL) mShape->Render();
-	if (mSprite.get() != NULL) mSprite->Render();
+	if (mSprite.get() != NULL) {
+		// Hand the sprite to the world's batch if one is collecting this frame
+		SpriteBatch* batch = (mWorld != NULL) ? mWorld->GetSpriteBatch() : NULL;
+		if (batch != NULL && batch->IsActive()) { mSprite->Render(*batch, mPosition, mAngle, mScale); }
+		else { mSprite->Render(); }
+	}
+}
+
+/** Submit draw commands for this object's shape and sprite. */
+void GameObject::Submit(RenderQueue& queue)
+{
+	if (mShape.get() != NULL) queue.SubmitShape(mRenderLayer, this, mShape.get());
+	if (mSprite.get() != NULL) queue.SubmitSprite(mRenderLayer, this, mSprite.get());
 }
 
 /** Clear up after rendering game object. */
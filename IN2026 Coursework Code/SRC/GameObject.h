@@ -8,6 +8,8 @@
 #include "Sprite.h"
 
 class BoundingShape;
+class RenderQueue;
+struct GameObjectState;
 
 class GameObject : public enable_shared_from_this<GameObject>
 {
@@ -23,12 +25,19 @@ public:
 	virtual void PreRender(void);
 	virtual void Render(void);
 	virtual void PostRender(void);
+	virtual void Submit(RenderQueue& queue);
 	
 	virtual bool CollisionTest(shared_ptr<GameObject> o) { return false; }
 	virtual void OnCollision(const GameObjectList& objects) {}
 
+	virtual void SaveState(GameObjectState& state);
+	virtual void RestoreState(const GameObjectState& state);
+
 	const GameObjectType& GetType() const { return mType; }
 
+	void SetId(uint id) { mId = id; }
+	uint GetId() const { return mId; }
+
 	void SetWorld(GameWorld *w) { mWorld = w; }
 	GameWorld* GetWorld() { return mWorld; }
 
@@ -53,6 +62,9 @@ public:
 	void SetScale(float s) { mScale = s; }
 	float GetScale() { return mScale; }
 
+	void SetRenderLayer(uint layer) { mRenderLayer = layer; }
+	uint GetRenderLayer() { return mRenderLayer; }
+
 	void SetShape(shared_ptr<Shape> shape) { mShape = shape; }
 	void SetSprite(shared_ptr<Sprite> sprite) { mSprite = sprite; }
 	const shared_ptr<BoundingShape>& GetBoundingShape() const { return mBoundingShape; }
@@ -62,6 +74,8 @@ public:
 
 protected:
 	GameObjectType mType;
+	// Unique within the world the object was first added to, 0 until then
+	uint mId;
 
 	GameWorld* mWorld;
 	GLVector3f mPosition;
@@ -70,6 +84,7 @@ protected:
 	GLfloat mAngle;
 	GLfloat mRotation;
 	GLfloat mScale;
+	uint mRenderLayer;
 
 	shared_ptr<Shape> mShape;
 	shared_ptr<Sprite> mSprite;
@@ -1,22 +1,72 @@
+#include <chrono>
+#include <thread>
 #include "GameUtil.h"
 #include "GameWindow.h"
 #include "GameDisplay.h"
 #include "GameWorld.h"
 #include "GlutSession.h"
+#include "IKeyboardListener.h"
+#include "InputRecorder.h"
+#include "NetClient.h"
+#include "NetServer.h"
+#include "RollbackSession.h"
+#include "WorldSnapshot.h"
 #include "GameSession.h"
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
 /** Construct new game session with given command line arguments. */
 GameSession::GameSession(int argc, char *argv[])
+	: mOptions(argc, argv),
+	  mGameWindow(NULL),
+	  mHeadlessEndStep(0)
 {
 	mGameWorld = new GameWorld();
 	mGameDisplay = new GameDisplay(400, 400);
+	// Play the game given by --seed, or a new one each time, showing its seed so it can be played again
+	mGameWorld->SetSeed(mOptions.seed);
+	cout << "Seed " << mGameWorld->GetSeed() << endl;
+	// The session's timers are saved in snapshots
+	mGameWorld->GetTimers().RegisterListener(this);
+	// Carry on from a snapshot saved earlier, e.g. after a crash
+	mLoadFilename = mOptions.load_filename;
+	if (!mLoadFilename.empty() && !mOptions.record_filename.empty()) {
+		cerr << "--record starts from the seed, so it cannot be used with --load" << endl;
+		::exit(1);
+	}
+	// Run the world for other players, or join one run elsewhere
+	if (!StartNetworking(mOptions)) ::exit(1);
+	// Simulate without a window or GL context, e.g. for soak tests on a build server
+	if (mOptions.headless) {
+		if (mOptions.replay_filename.empty()) {
+			// A server without --headless runs until it is stopped
+			mHeadlessEndStep = (uint)(mOptions.headless_seconds * 1000) / SimulationClock::STEP_MILLIS;
+			return;
+		}
+		// Play a recorded session again, exactly as it happened
+		if (!mInputLog.Load(mOptions.replay_filename)) ::exit(1);
+		const InputLogHeader& header = mInputLog.GetHeader();
+		mGameWorld->SetSeed(header.seed);
+		mGameWorld->SetWidth(header.world_width);
+		mGameWorld->SetHeight(header.world_height);
+		mHeadlessEndStep = header.end_step;
+		cout << "Replaying " << mOptions.replay_filename << " with seed " << header.seed << endl;
+		return;
+	}
 	mGameWindow = new GameWindow(400, 400, -1, -1, "GameWindow");
 	mGameWindow->SetDisplay(mGameDisplay);
 	mGameWindow->SetWorld(mGameWorld);
+	mGameWindow->SetSession(this);
 	// Set the window for this session
 	GlutSession::GetInstance().SetWindow(mGameWindow);
+	// Record what is played with --record, to play it again with --replay
+	if (!mOptions.record_filename.empty()) {
+		mInputRecorder = make_shared<InputRecorder>(mGameWorld);
+		if (mInputRecorder->Open(mOptions.record_filename)) {
+			mGameWindow->AddKeyboardListener(mInputRecorder);
+			mGameWorld->AddListener(mInputRecorder.get());
+		}
+	}
 }
 
 /** Destructor. */
@@ -32,6 +82,17 @@ GameSession::~GameSession()
 /** Start the game. */
 void GameSession::Start(void)
 {
+	if (!mLoadFilename.empty()) {
+		if (!LoadSnapshot(mLoadFilename)) ::exit(1);
+		// Run headless for the time given on from where the snapshot was taken
+		mHeadlessEndStep += mGameWorld->GetClock().GetStepCount();
+	}
+	if (IsHeadless()) {
+		// Other players are playing along, so the world must keep to real time
+		if (IsServer() || IsClient() || IsPeer()) RunRealTime(mHeadlessEndStep);
+		else RunHeadless(mHeadlessEndStep);
+		Stop();
+	}
 	// Enable the idle function
 	GlutSession::GetInstance().EnableIdleFunction();
 	// Start the idle loop to begin the game
@@ -41,13 +102,167 @@ void GameSession::Start(void)
 /** Stop the game. */
 void GameSession::Stop(void)
 {
+	if (mInputRecorder) mInputRecorder->Close();
+	if (mNetServer) mNetServer->Close();
+	if (mNetClient) mNetClient->Close();
+	if (mRollbackSession) mRollbackSession->Close();
 	GlutSession::Stop();
 }
 
 // PROTECTED INSTANCE METHODS /////////////////////////////////////////////////
 
-/** Protected method to set a timer. */
-void GameSession::SetTimer(uint msecs, int value)
+/** Add a listener for keys, which are pressed in the window or replayed from a log. */
+void GameSession::AddKeyboardListener(shared_ptr<IKeyboardListener> listener)
 {
-	GlutSession::GetInstance().SetTimer(msecs, this, value);
+	if (mGameWindow) mGameWindow->AddKeyboardListener(listener);
+	mKeyboardListeners.push_back(listener);
+}
+
+/** Step the world as fast as it will go until end_step, then report the speed. Any replayed
+	input is fed in before the step it arrived before when it was recorded. */
+void GameSession::RunHeadless(uint end_step)
+{
+	SimulationClock& clock = mGameWorld->GetClock();
+	uint start_time = clock.GetTime();
+	uint start_steps = clock.GetStepCount();
+	const InputEventVector& events = mInputLog.GetEvents();
+	uint next_event = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (;;) {
+		while (next_event < events.size() && events[next_event].step <= clock.GetStepCount()) {
+			ReplayEvent(events[next_event++]);
+		}
+		if (clock.GetStepCount() >= end_step) break;
+		mGameWorld->Step();
+	}
+	double wall_msecs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+	uint game_msecs = clock.GetTime() - start_time;
+	cout << "Simulated " << game_msecs / 1000.0 << " s in " << clock.GetStepCount() - start_steps << " steps, taking "
+		<< wall_msecs << " ms (" << game_msecs / max(wall_msecs, 1.0) << "x real time)" << endl;
+	// Runs with the same seed and input end in the same state, so this must match between them
+	cout << "State checksum " << hex << mGameWorld->GetStateChecksum() << dec << endl;
+}
+
+/** Run the world at the speed of the wall clock until end_step, or for ever if it is 0,
+	as a networked world must for the players sharing it. */
+void GameSession::RunRealTime(uint end_step)
+{
+	SimulationClock& clock = mGameWorld->GetClock();
+	chrono::steady_clock::time_point last = chrono::steady_clock::now();
+	while (end_step == 0 || clock.GetStepCount() < end_step) {
+		this_thread::sleep_for(chrono::milliseconds(1));
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		int elapsed = (int)chrono::duration_cast<chrono::milliseconds>(now - last).count();
+		if (elapsed == 0) continue;
+		last += chrono::milliseconds(elapsed);
+		mGameWorld->Advance(elapsed);
+	}
+}
+
+/** Open a server with "--server port" or connect to one with "--connect host[:port]". A server can
+	send snapshots less often with "--send-rate hz", only send each client what is within
+	"--view-radius units" of its ship and keep each snapshot to "--client-budget bytes". Or play one other player directly with
+	"--peer host:port", listening on "--port n" as "--player 1" or 2, with "--input-delay frames".
+	Any of them can test a poor network with "--latency ms", "--jitter ms" and "--loss percent",
+	which apply to the packets it sends. */
+bool GameSession::StartNetworking(const GameSessionOptions& options)
+{
+	if (options.server_port >= 0) {
+		mNetServer = make_shared<NetServer>(mGameWorld);
+		if (options.send_rate > 0) mNetServer->SetSendRate(options.send_rate);
+		if (options.view_radius > 0) mNetServer->GetInterest().SetViewRadius(options.view_radius);
+		if (options.client_budget > 0) mNetServer->GetInterest().SetByteBudget(options.client_budget);
+		ConfigureConditioner(mNetServer->GetConditioner(), options);
+		if (!mNetServer->Open((unsigned short)options.server_port)) return false;
+		mGameWorld->AddListener(mNetServer.get());
+		return true;
+	}
+	if (!options.connect_address.empty()) {
+		NetAddress server;
+		if (!UdpSocket::ParseAddress(options.connect_address, NetProtocol::DEFAULT_PORT, server)) return false;
+		mNetClient = make_shared<NetClient>(mGameWorld);
+		ConfigureConditioner(mNetClient->GetConditioner(), options);
+		if (!mNetClient->Connect(server)) return false;
+		// Everything in the world comes from the server
+		mGameWorld->SetReplicated(true);
+		mGameWorld->AddListener(mNetClient.get());
+		return true;
+	}
+	if (!options.peer_address.empty()) {
+		NetAddress peer_address;
+		if (!UdpSocket::ParseAddress(options.peer_address, NetProtocol::DEFAULT_PORT, peer_address)) return false;
+		// Unless told otherwise, the peer on the lower port is player 1, which suits two on one machine
+		if (options.player == 0 && options.local_port == peer_address.port) {
+			cerr << "Both peers use port " << options.local_port << ", give each a --player" << endl;
+			return false;
+		}
+		uint player_index = (options.player != 0) ? options.player - 1 : (options.local_port < peer_address.port ? 0 : 1);
+		mRollbackSession = make_shared<RollbackSession>(mGameWorld);
+		if (options.input_delay >= 0) mRollbackSession->SetInputDelay((uint)options.input_delay);
+		ConfigureConditioner(mRollbackSession->GetConditioner(), options);
+		if (!mRollbackSession->Open(options.local_port, peer_address, player_index)) return false;
+	}
+	return true;
+}
+
+void GameSession::ConfigureConditioner(NetworkConditioner& conditioner, const GameSessionOptions& options)
+{
+	conditioner.SetLatency(options.latency);
+	conditioner.SetJitter(options.jitter);
+	conditioner.SetLoss(options.loss);
+	if (conditioner.IsEnabled()) {
+		cout << "Simulating " << conditioner.GetLatency() << " ms latency, " << conditioner.GetJitter() << " ms jitter and "
+			<< conditioner.GetLoss() * 100 << "% loss" << endl;
+	}
+}
+
+/** Pass a recorded event on as it was when it happened. */
+void GameSession::ReplayEvent(const InputEvent& event)
+{
+	if (event.type == INPUT_WORLD_RESIZED) {
+		mGameWorld->SetWidth(event.width);
+		mGameWorld->SetHeight(event.height);
+		return;
+	}
+	for (KeyboardListenerList::iterator it = mKeyboardListeners.begin(); it != mKeyboardListeners.end(); ++it) {
+		switch (event.type) {
+		case INPUT_KEY_PRESSED: (*it)->OnKeyPressed((uchar)event.key, 0, 0); break;
+		case INPUT_KEY_RELEASED: (*it)->OnKeyReleased((uchar)event.key, 0, 0); break;
+		case INPUT_SPECIAL_KEY_PRESSED: (*it)->OnSpecialKeyPressed(event.key, 0, 0); break;
+		case INPUT_SPECIAL_KEY_RELEASED: (*it)->OnSpecialKeyReleased(event.key, 0, 0); break;
+		default: break;
+		}
+	}
+}
+
+/** Save the world and game to a file, replacing it only once the new one is complete. */
+bool GameSession::SaveSnapshot(const string& filename)
+{
+	WorldSnapshot snapshot;
+	mGameWorld->TakeSnapshot(snapshot);
+	if (!snapshot.Save(filename)) return false;
+	cout << "Saved " << filename << " at step " << snapshot.header.step_count << endl;
+	return true;
+}
+
+/** Put the world and game back as they were saved in a file. */
+bool GameSession::LoadSnapshot(const string& filename)
+{
+	WorldSnapshot snapshot;
+	if (!snapshot.Load(filename) || !mGameWorld->RestoreSnapshot(snapshot)) return false;
+	cout << "Loaded " << filename << " at step " << snapshot.header.step_count << endl;
+	return true;
+}
+
+/** Protected method to set a timer. It runs on game time, so only counts down while the world is updated. */
+TimerHandle GameSession::SetTimer(uint msecs, int value)
+{
+	return mGameWorld->GetTimers().Schedule(msecs, this, value);
+}
+
+/** Protected method to cancel a timer before it fires. */
+bool GameSession::CancelTimer(TimerHandle& handle)
+{
+	return mGameWorld->GetTimers().Cancel(handle);
 }
@@ -2,10 +2,19 @@
 #define __GAMESESSION_H__
 
 #include "ITimerListener.h"
+#include "TimerWheel.h"
+#include "InputLog.h"
+#include "GameSessionOptions.h"
 
 class GameWorld;
 class GameDisplay;
 class GameWindow;
+class IKeyboardListener;
+class InputRecorder;
+class NetServer;
+class NetClient;
+class NetworkConditioner;
+class RollbackSession;
 
 class GameSession : public ITimerListener
 {
@@ -17,13 +26,50 @@ public:
 
 	virtual void Start(void);
 	virtual void Stop(void);
+	// Called before each frame is drawn, however many steps were run since the last
+	virtual void OnFrame(void) {}
+
+	bool IsHeadless() const { return mGameWindow == NULL; }
+	bool IsServer() const { return mNetServer != NULL; }
+	bool IsClient() const { return mNetClient != NULL; }
+	bool IsPeer() const { return mRollbackSession != NULL; }
 
 protected:
+	// As given on the command line
+	GameSessionOptions mOptions;
 	GameWorld* mGameWorld;
 	GameDisplay* mGameDisplay;
 	GameWindow* mGameWindow;
+	// Step to run up to when running without a window
+	uint mHeadlessEndStep;
+	// Session being replayed with --replay
+	InputLog mInputLog;
+	// Session being recorded with --record
+	shared_ptr<InputRecorder> mInputRecorder;
+	// Snapshot to carry on from, given with --load
+	string mLoadFilename;
+	// Runs the world for other players with --server
+	shared_ptr<NetServer> mNetServer;
+	// Shows a world run by a server with --connect
+	shared_ptr<NetClient> mNetClient;
+	// Plays another peer directly with --peer
+	shared_ptr<RollbackSession> mRollbackSession;
+
+	typedef list< shared_ptr<IKeyboardListener> > KeyboardListenerList;
+	KeyboardListenerList mKeyboardListeners;
+
+	void AddKeyboardListener(shared_ptr<IKeyboardListener> listener);
+	void RunHeadless(uint end_step);
+	void RunRealTime(uint end_step);
+	bool StartNetworking(const GameSessionOptions& options);
+	void ConfigureConditioner(NetworkConditioner& conditioner, const GameSessionOptions& options);
+	void ReplayEvent(const InputEvent& event);
+
+	bool SaveSnapshot(const string& filename);
+	bool LoadSnapshot(const string& filename);
 
-	void SetTimer(uint msecs, int value);
+	TimerHandle SetTimer(uint msecs, int value);
+	bool CancelTimer(TimerHandle& handle);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include <chrono>
+#include <string.h>
+#include "NetProtocol.h"
+#include "GameSessionOptions.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Read the options from the command line. */
+GameSessionOptions::GameSessionOptions(int argc, char* argv[])
+{
+	const char* seed_value = GetArgument(argc, argv, "--seed");
+	seed = (seed_value != NULL) ? (uint)strtoul(seed_value, NULL, 10) : (uint)chrono::system_clock::now().time_since_epoch().count();
+	const char* headless_value = GetArgument(argc, argv, "--headless");
+	headless_seconds = (headless_value != NULL) ? (float)atof(headless_value) : 0;
+	const char* replay_value = GetArgument(argc, argv, "--replay");
+	if (replay_value != NULL) replay_filename = replay_value;
+	const char* load_value = GetArgument(argc, argv, "--load");
+	if (load_value != NULL && replay_value == NULL) load_filename = load_value;
+	const char* record_value = GetArgument(argc, argv, "--record");
+	if (record_value != NULL) record_filename = record_value;
+
+	const char* server_value = GetArgument(argc, argv, "--server");
+	server_port = (server_value != NULL) ? atoi(server_value) : -1;
+	headless = headless_value != NULL || replay_value != NULL || server_value != NULL;
+	const char* send_rate_value = GetArgument(argc, argv, "--send-rate");
+	send_rate = (send_rate_value != NULL) ? (uint)atoi(send_rate_value) : 0;
+	const char* view_radius_value = GetArgument(argc, argv, "--view-radius");
+	view_radius = (view_radius_value != NULL) ? (float)atof(view_radius_value) : 0;
+	const char* client_budget_value = GetArgument(argc, argv, "--client-budget");
+	client_budget = (client_budget_value != NULL) ? (uint)atoi(client_budget_value) : 0;
+	const char* connect_value = GetArgument(argc, argv, "--connect");
+	if (connect_value != NULL) connect_address = connect_value;
+	const char* peer_value = GetArgument(argc, argv, "--peer");
+	if (peer_value != NULL) peer_address = peer_value;
+	const char* port_value = GetArgument(argc, argv, "--port");
+	local_port = (port_value != NULL) ? (unsigned short)atoi(port_value) : NetProtocol::DEFAULT_PORT;
+	const char* player_value = GetArgument(argc, argv, "--player");
+	player = (player_value != NULL) ? (uint)atoi(player_value) : 0;
+	const char* input_delay_value = GetArgument(argc, argv, "--input-delay");
+	input_delay = (input_delay_value != NULL) ? atoi(input_delay_value) : -1;
+
+	const char* latency_value = GetArgument(argc, argv, "--latency");
+	latency = (latency_value != NULL) ? (uint)atoi(latency_value) : 0;
+	const char* jitter_value = GetArgument(argc, argv, "--jitter");
+	jitter = (jitter_value != NULL) ? (uint)atoi(jitter_value) : 0;
+	const char* loss_value = GetArgument(argc, argv, "--loss");
+	loss = (loss_value != NULL) ? (float)atof(loss_value) / 100 : 0;
+
+	const char* name_value = GetArgument(argc, argv, "--name");
+	name = (name_value != NULL) ? name_value : "Player";
+}
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+/** The value following the given option on the command line, or NULL if it is not there. */
+const char* GameSessionOptions::GetArgument(int argc, char* argv[], const char* name)
+{
+	for (int i = 1; i + 1 < argc; i++) {
+		if (0 == strcmp(argv[i], name)) return argv[i + 1];
+	}
+	return NULL;
+}
\ No newline at end of file
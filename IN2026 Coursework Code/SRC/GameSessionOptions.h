@@ -0,0 +1,49 @@
+#ifndef __GAMESESSIONOPTIONS_H__
+#define __GAMESESSIONOPTIONS_H__
+
+#include "GameUtil.h"
+
+// Everything a session can be told on the command line, read in one place.
+// Values that are left out keep the defaults of the classes they are given
+// to, so numbers that were not given are 0, or -1 where 0 means something.
+struct GameSessionOptions
+{
+	// --seed n, otherwise one taken from the time
+	uint seed;
+	// Run without a window, with --headless, --replay or --server
+	bool headless;
+	// --headless seconds, or 0 to run until stopped
+	float headless_seconds;
+	// --load filename, left out with --replay as a replay starts from its seed
+	string load_filename;
+	// --replay filename and --record filename, which cannot be given with --load
+	// as a recording is played again from its seed
+	string replay_filename;
+	string record_filename;
+
+	// --server port, with --send-rate hz, --view-radius units and --client-budget bytes
+	int server_port;
+	uint send_rate;
+	float view_radius;
+	uint client_budget;
+	// --connect host[:port]
+	string connect_address;
+	// --peer host:port, with --port n, --player 1 or 2 and --input-delay frames
+	string peer_address;
+	unsigned short local_port;
+	uint player;
+	int input_delay;
+	// --latency ms, --jitter ms and --loss percent, as a fraction
+	uint latency;
+	uint jitter;
+	float loss;
+
+	// --name name, which high scores are saved under, otherwise Player
+	string name;
+
+	GameSessionOptions(int argc, char* argv[]);
+
+	static const char* GetArgument(int argc, char* argv[], const char* name);
+};
+
+#endif
\ No newline at end of file
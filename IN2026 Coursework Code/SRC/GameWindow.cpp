@@ -2,9 +2,17 @@
 #include "GameWorld.h"
 #include "IKeyboardListener.h"
 #include "GameDisplay.h"
+#include "GameSession.h"
 #include "GameWindow.h"
+#include "RenderState.h"
+#include "TextureManager.h"
+#include "AnimationManager.h"
+#include "StartupProfiler.h"
+#include "TextRenderer.h"
 
 const int GameWindow::ZOOM_LEVEL = 3;
+const int GameWindow::FAST_FORWARD_SLICE_MILLIS = 50;
+const int GameWindow::FAST_FORWARD_DISPLAY_MILLIS = 500;
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
@@ -12,7 +20,9 @@ const int GameWindow::ZOOM_LEVEL = 3;
 GameWindow::GameWindow(int w, int h, int x, int y, char *t)
 	: GlutWindow(w, h, x, y, t),
 	  mWorld(NULL),
-	  mDisplay(NULL)
+	  mDisplay(NULL),
+	  mSession(NULL),
+	  mLastDisplayTime(0)
 {
 }
 
@@ -26,6 +36,15 @@ GameWindow::~GameWindow()
 /** Call world and display to render themselves. */
 void GameWindow::OnDisplay(void)
 {
+	// Start counting state changes for this frame
+	RenderState::GetInstance().BeginFrame();
+	TextureManager::GetInstance().BeginFrame();
+	// Capture the font into the glyph atlas, while the backbuffer is about to be cleared anyway
+	TextRenderer::GetInstance().Create();
+	// Let the session bring what it shows up to date, then redraw anything that changed
+	// in the cached display, before the world is drawn
+	if (mSession) { mSession->OnFrame(); }
+	if (mDisplay) { mDisplay->Prepare(); }
 	// Clear the backbuffer
 	glClear(GL_COLOR_BUFFER_BIT);
 	// Render the world and display
@@ -33,6 +52,8 @@ void GameWindow::OnDisplay(void)
 	if (mDisplay) { mDisplay->Render(); }
 	// Show the backbuffer
 	glutSwapBuffers();
+	// Report how long it took to get here the first time
+	StartupProfiler::GetInstance().ReportFirstFrame();
 }
 
 /** Update world and display. */
@@ -40,15 +61,31 @@ void GameWindow::OnIdle(void)
 {
 	// Call parent to do any idle loop processing
 	GlutWindow::OnIdle();
+	// Upload any animations that have finished loading in the background
+	AnimationManager::GetInstance().ProcessPendingUploads();
 	// Calculate the time in milliseconds since the last update
 	static int lasttime;
 	int dt=glutGet(GLUT_ELAPSED_TIME)-lasttime;
 	lasttime=glutGet(GLUT_ELAPSED_TIME);
-	// Update the world and display
-	if (mWorld) { mWorld->Update(dt); }
+	// Step the world on by the game time that has passed
+	bool fast_forward = false;
+	if (mWorld) {
+		SimulationClock& clock = mWorld->GetClock();
+		fast_forward = clock.IsFastForward() && !clock.IsPaused();
+		if (fast_forward) {
+			// Step as often as possible for a slice of wall time, then return so input is still handled
+			int slice_start = glutGet(GLUT_ELAPSED_TIME);
+			do { mWorld->Step(); } while (glutGet(GLUT_ELAPSED_TIME) - slice_start < FAST_FORWARD_SLICE_MILLIS);
+		} else {
+			mWorld->Advance(dt);
+		}
+	}
 	if (mDisplay) { mDisplay->Update(dt); }
-	// Request a redisplay
-	glutPostRedisplay();
+	// Request a redisplay, only now and then in fast-forward so the time goes on stepping
+	if (!fast_forward || lasttime - mLastDisplayTime >= FAST_FORWARD_DISPLAY_MILLIS) {
+		mLastDisplayTime = lasttime;
+		glutPostRedisplay();
+	}
 }
 
 /** Reshape viewport, world and display. */
@@ -63,6 +100,13 @@ void  GameWindow::OnWindowReshaped(int w, int h)
 	UpdateDisplaySize();
 }
    
+/** Stop the session when Esc is pressed, otherwise pass the key on. */
+void GameWindow::OnKeyPressed(uchar key, int x, int y)
+{
+	if (key == 27 && mSession) { mSession->Stop(); }
+	GlutWindow::OnKeyPressed(key, x, y);
+}
+
 void GameWindow::SetWorld(GameWorld* w) { mWorld = w; UpdateWorldSize(); }
 GameWorld* GameWindow::GetWorld() { return mWorld; }
 
@@ -7,6 +7,7 @@
 
 class GameWorld;
 class GameDisplay;
+class GameSession;
 
 class GameWindow : public GlutWindow
 {
@@ -17,6 +18,7 @@ public:
 	virtual void OnDisplay(void);
 	virtual void OnIdle(void);
 	virtual void OnWindowReshaped(int w, int h);
+	virtual void OnKeyPressed(uchar key, int x, int y);
 
 	void UpdateWorldSize(void);
 	void UpdateDisplaySize(void);
@@ -27,11 +29,19 @@ public:
 	void SetDisplay(GameDisplay* w);
 	GameDisplay* GetDisplay();
 
+	void SetSession(GameSession* s) { mSession = s; }
+
 protected:
 	static const int ZOOM_LEVEL;
+	static const int FAST_FORWARD_SLICE_MILLIS;
+	static const int FAST_FORWARD_DISPLAY_MILLIS;
 
 	GameWorld* mWorld;
 	GameDisplay* mDisplay;
+	// Stopped when Esc is pressed, so it can close its files and connections first
+	GameSession* mSession;
+	// When the last frame was drawn, to draw only occasionally in fast-forward
+	int mLastDisplayTime;
 };
 
 #endif
\ No newline at end of file
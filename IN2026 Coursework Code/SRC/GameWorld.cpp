@@ -1,12 +1,15 @@
+#include <string.h>
 #include "GameUtil.h"
 #include "GameObject.h"
 #include "GameWorld.h"
+#include "WorldSnapshot.h"
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
 /** Default constructor. */
-GameWorld::GameWorld(void) : mWidth(200), mHeight(200)
+GameWorld::GameWorld(void) : mStepListener(NULL), mWidth(200), mHeight(200), mNextObjectId(1), mReplicated(false)
 {
+	SetSeed(0);
 }
 
 /** Destructor. */
@@ -19,8 +22,11 @@ GameWorld::~GameWorld(void)
 /** Update the world. */
 void GameWorld::Update(int t)
 {
-	UpdateObjects(t);
-	UpdateCollisions(t);
+	// A replicated world is moved on by the snapshots it is sent
+	if (!mReplicated) {
+		UpdateObjects(t);
+		UpdateCollisions(t);
+	}
 
 	// Remove objects flagged for removal
 	WeakGameObjectList::iterator it = mGameObjectsToRemove.begin();
@@ -30,10 +36,32 @@ void GameWorld::Update(int t)
 		it = mGameObjectsToRemove.erase( it );
 	}
 
+	// Fire any timers that have come due during this update
+	if (t > 0) mTimers.Advance(t);
+
 	// Send update message to listeners
 	FireWorldUpdated();
 }
 
+/** Step the world on by however much game time has built up over real_msecs of wall time. */
+void GameWorld::Advance(int real_msecs)
+{
+	uint steps = mClock.Advance(real_msecs);
+	while (steps-- > 0) {
+		// Steps that are held back are dropped, so the world falls behind real time
+		if (mStepListener && !mStepListener->OnStepStarting(this)) break;
+		Step();
+	}
+}
+
+/** Update the world by one fixed step of game time. Everything that counts down,
+	such as timers, sprite animations and bullets, sees the same step. */
+void GameWorld::Step(void)
+{
+	Update(SimulationClock::STEP_MILLIS);
+	mClock.CountStep();
+}
+
 /** Render the world by rendering all of its objects. */
 void GameWorld::Render(void)
 {
@@ -50,17 +78,20 @@ void GameWorld::Render(void)
 	glMatrixMode(GL_MODELVIEW);
 	// Initialize the projection matrix to the identity matrix
 	glLoadIdentity();
-	// Render every object in the world
+	// Collect draw commands from every object in the world
+	mRenderQueue.Clear();
 	for (GameObjectList::iterator it = mGameObjects.begin(); it != mGameObjects.end(); ++it) {
-		(*it)->PreRender();
-		(*it)->Render();
-		(*it)->PostRender();
+		(*it)->Submit(mRenderQueue);
 	}
+	// Draw the commands sorted by layer, material and texture
+	mRenderQueue.Execute(mSpriteBatch);
 }
 
 /** Add a game object to the world. */
 void GameWorld::AddObject(shared_ptr<GameObject> ptr)
 {
+	// Number the object the first time it is added, before it is used as a key
+	if (ptr->GetId() == 0) ptr->SetId(mNextObjectId++);
 	// Add game object
 	mGameObjects.push_back(ptr);
 	// Add game object to collision map
@@ -95,6 +126,8 @@ void GameWorld::RemoveObject(shared_ptr<GameObject> ptr)
 	mCollisions.erase(ptr);
 	// Remove reference to this world
 	ptr->SetWorld(NULL);
+	// Number it again if it comes back, so objects stay in the order of their ids
+	ptr->SetId(0);
 	// Send message to all listeners
 	FireObjectRemoved(ptr);
 }
@@ -126,6 +159,87 @@ void GameWorld::FireObjectRemoved(shared_ptr<GameObject> ptr)
 	}
 }
 
+/** Find the object in the world with the given id, or NULL if there is none. */
+shared_ptr<GameObject> GameWorld::FindObject(uint id)
+{
+	for (GameObjectList::iterator it = mGameObjects.begin(); it != mGameObjects.end(); ++it) {
+		if ((*it)->GetId() == id) return *it;
+	}
+	return shared_ptr<GameObject>();
+}
+
+/** Save the state of the world, and whatever the snapshot listeners add, at the end of a step. */
+void GameWorld::TakeSnapshot(WorldSnapshot& snapshot)
+{
+	WorldSnapshotHeader& header = snapshot.header;
+	header.time = mClock.GetTime();
+	header.step_count = mClock.GetStepCount();
+	header.timer_time = mTimers.GetTime();
+	header.next_timer_sequence = mTimers.GetNextSequence();
+	header.seed = mSeed;
+	for (uint i = 0; i < RANDOM_STREAM_COUNT; i++) mRandom[i].GetState(header.random_state[i]);
+	header.next_object_id = mNextObjectId;
+	header.width = mWidth;
+	header.height = mHeight;
+
+	// Objects are added in the order of their ids, so the snapshot is in id order too
+	snapshot.objects.resize(mGameObjects.size());
+	uint i = 0;
+	for (GameObjectList::iterator it = mGameObjects.begin(); it != mGameObjects.end(); ++it) {
+		(*it)->SaveState(snapshot.objects[i++]);
+	}
+	mTimers.SaveState(snapshot.timers);
+
+	snapshot.values.clear();
+	for (SnapshotListenerList::iterator it = mSnapshotListeners.begin(); it != mSnapshotListeners.end(); ++it) {
+		(*it)->OnSnapshotTaken(this, snapshot);
+	}
+	header.num_objects = (uint)snapshot.objects.size();
+	header.num_timers = (uint)snapshot.timers.size();
+	header.num_values = (uint)snapshot.values.size();
+}
+
+/** Put the world back as it was when the snapshot was taken. Objects still in
+	the world keep their identity and are restored in place; the rest are made
+	by the object factory. No object added or removed events are sent, as this
+	is not something that happened in the game. */
+bool GameWorld::RestoreSnapshot(const WorldSnapshot& snapshot)
+{
+	const WorldSnapshotHeader& header = snapshot.header;
+	if (0 != memcmp(header.magic, WorldSnapshot::MAGIC, sizeof(header.magic)) || header.version != WorldSnapshot::VERSION) return false;
+
+	RestoreObjects(snapshot);
+
+	mClock.Restore(header.time, header.step_count);
+	mTimers.RestoreState(header.timer_time, header.next_timer_sequence, snapshot.timers);
+	// Random streams last, so the object factory is free to draw from them
+	mSeed = header.seed;
+	for (uint i = 0; i < RANDOM_STREAM_COUNT; i++) mRandom[i].SetState(header.random_state[i]);
+	mNextObjectId = header.next_object_id;
+	mWidth = header.width;
+	mHeight = header.height;
+
+	for (SnapshotListenerList::iterator lit = mSnapshotListeners.begin(); lit != mSnapshotListeners.end(); ++lit) {
+		(*lit)->OnSnapshotRestored(this, snapshot);
+	}
+	return true;
+}
+
+/** Make the world's objects match a snapshot sent from a world that is run
+	elsewhere. Unlike RestoreSnapshot the world keeps its own clock, timers
+	and random streams, which only matter to a world that is simulated. */
+bool GameWorld::ReplicateSnapshot(const WorldSnapshot& snapshot)
+{
+	RestoreObjects(snapshot);
+	mWidth = snapshot.header.width;
+	mHeight = snapshot.header.height;
+
+	for (SnapshotListenerList::iterator lit = mSnapshotListeners.begin(); lit != mSnapshotListeners.end(); ++lit) {
+		(*lit)->OnSnapshotRestored(this, snapshot);
+	}
+	return true;
+}
+
 /** Get all the collisions for a given object. */
 GameObjectList GameWorld::GetCollisions(shared_ptr<GameObject> ptr)
 {
@@ -199,6 +313,102 @@ void GameWorld::UpdateCollisions(int t)
 	}
 }
 
+/** Restore the objects in a snapshot, reusing those the world still has. */
+void GameWorld::RestoreObjects(const WorldSnapshot& snapshot)
+{
+	mGameObjectsToRemove.clear();
+
+	// Rolling back a few steps usually finds the same objects, which can be restored where they are
+	bool same_objects = (mGameObjects.size() == snapshot.objects.size());
+	const GameObjectState* state = snapshot.objects.empty() ? NULL : &snapshot.objects[0];
+	for (GameObjectList::iterator it = mGameObjects.begin(); same_objects && it != mGameObjects.end(); ++it, ++state) {
+		same_objects = ((*it)->GetId() == state->id && (*it)->GetType().GetTypeID() == state->type);
+	}
+	if (same_objects) {
+		state = snapshot.objects.empty() ? NULL : &snapshot.objects[0];
+		for (GameObjectList::iterator it = mGameObjects.begin(); it != mGameObjects.end(); ++it) (*it)->RestoreState(*state++);
+		return;
+	}
+
+	// Both lists are in id order, so objects can be matched in a single pass.
+	// Everything unmatched is taken out first, so the factory may hand back
+	// an object the game keeps hold of, such as the player's ship.
+	vector< shared_ptr<GameObject> > matched(snapshot.objects.size());
+	GameObjectList::iterator it = mGameObjects.begin();
+	for (uint i = 0; i < snapshot.objects.size(); i++) {
+		const GameObjectState& state = snapshot.objects[i];
+		while (it != mGameObjects.end() && (*it)->GetId() < state.id) DetachObject(*it++);
+		if (it != mGameObjects.end() && (*it)->GetId() == state.id) {
+			if ((*it)->GetType().GetTypeID() == state.type) matched[i] = *it;
+			else DetachObject(*it);
+			++it;
+		}
+	}
+	while (it != mGameObjects.end()) DetachObject(*it++);
+
+	GameObjectList restored;
+	for (uint i = 0; i < snapshot.objects.size(); i++) {
+		const GameObjectState& state = snapshot.objects[i];
+		shared_ptr<GameObject> object = matched[i];
+		if (object) {
+			object->RestoreState(state);
+		} else {
+			if (mObjectFactory) object = mObjectFactory(state);
+			if (!object || object->GetWorld() != NULL) {
+				cerr << "Unable to restore object " << state.id << endl;
+				continue;
+			}
+			// Numbered before it is used as a key
+			object->RestoreState(state);
+			object->SetWorld(this);
+			mCollisions[object] = GameObjectList();
+		}
+		restored.push_back(object);
+	}
+	mGameObjects.swap(restored);
+}
+
+/** Take an object out of the world while restoring a snapshot, without telling listeners. */
+void GameWorld::DetachObject(shared_ptr<GameObject> ptr)
+{
+	mCollisions.erase(ptr);
+	ptr->SetWorld(NULL);
+	ptr->SetId(0);
+}
+
+/** Reseed every random stream. The same seed and the same input always give the same game. */
+void GameWorld::SetSeed(uint seed)
+{
+	mSeed = seed;
+	for (uint i = 0; i < RANDOM_STREAM_COUNT; i++) mRandom[i].Seed(seed, i);
+}
+
+/** Create a stream for one thread's share of a subsystem's work, e.g. spawning in parallel.
+	It depends only on the seed, subsystem and thread number, not on when threads run. */
+RandomStream GameWorld::CreateRandomStream(RandomStreamId id, uint thread) const
+{
+	return RandomStream(mSeed, RANDOM_STREAM_COUNT * (thread + 1) + id);
+}
+
+/** Hash the position and motion of every object, to check that two runs ended up in the same state. */
+uint GameWorld::GetStateChecksum() const
+{
+	// FNV-1a over the raw bits, as any difference at all means the runs diverged
+	uint hash = 2166136261u;
+	for (GameObjectList::const_iterator it = mGameObjects.begin(); it != mGameObjects.end(); ++it) {
+		GameObject* object = it->get();
+		GLfloat values[] = {
+			object->GetPosition().x, object->GetPosition().y,
+			object->GetVelocity().x, object->GetVelocity().y,
+			object->GetAngle(), object->GetScale()
+		};
+		const uchar* bytes = (const uchar*)values;
+		for (uint i = 0; i < sizeof(values); i++) hash = (hash ^ bytes[i]) * 16777619u;
+		hash = (hash ^ object->GetId()) * 16777619u;
+	}
+	return hash;
+}
+
 /** Utility method to wrap positions around the world's edges. */
 void GameWorld::WrapXY(GLfloat &x, GLfloat &y)
 {
@@ -208,3 +418,12 @@ void GameWorld::WrapXY(GLfloat &x, GLfloat &y)
 	while (x < -mWidth/2)  x += mWidth; 
 	while (y < -mHeight/2) y += mHeight; 
 }
+
+// GameObjectOrder ////////////////////////////////////////////////////////////
+
+bool GameObjectOrder::operator()(const shared_ptr<GameObject>& a, const shared_ptr<GameObject>& b) const
+{
+	// Objects that were never added have no id, and fall back to their address
+	if (a->GetId() != b->GetId()) return a->GetId() < b->GetId();
+	return a.get() < b.get();
+}
\ No newline at end of file
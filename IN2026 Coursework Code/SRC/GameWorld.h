@@ -1,17 +1,47 @@
 #ifndef __GAMEWORLD_H__
 #define __GAMEWORLD_H__
 
+#include <functional>
 #include "GameUtil.h"
 #include "IGameWorldListener.h"
+#include "ISnapshotListener.h"
+#include "IStepListener.h"
+#include "SpriteBatch.h"
+#include "RenderQueue.h"
+#include "TimerWheel.h"
+#include "SimulationClock.h"
+#include "RandomStream.h"
 
 class GameObject;
+class WorldSnapshot;
+struct GameObjectState;
 
 // Define a type of list to hold game objects
 typedef list< shared_ptr< GameObject > > GameObjectList;
 typedef list< weak_ptr< GameObject > > WeakGameObjectList;
 
+// Orders objects by when they were added to the world rather than by address,
+// so collisions are handled in the same order on every run
+struct GameObjectOrder
+{
+	bool operator()(const shared_ptr<GameObject>& a, const shared_ptr<GameObject>& b) const;
+};
+
 // Define a type of map to hold lists of collisions
-typedef map< shared_ptr<GameObject>, GameObjectList > CollisionMap;
+typedef map< shared_ptr<GameObject>, GameObjectList, GameObjectOrder > CollisionMap;
+
+// Makes an object of the type saved in a snapshot, ready to have its state restored
+typedef function< shared_ptr<GameObject>(const GameObjectState&) > GameObjectFactory;
+
+// Each subsystem draws from its own random stream, so adding a draw to one
+// does not change what the others see
+enum RandomStreamId
+{
+	RANDOM_STREAM_SPAWN,
+	RANDOM_STREAM_AI,
+	RANDOM_STREAM_EFFECTS,
+	RANDOM_STREAM_COUNT
+};
 
 class GameWorld
 {
@@ -20,6 +50,8 @@ public:
 	~GameWorld(void);
 
 	void Update(int t);
+	void Advance(int real_msecs);
+	void Step(void);
 	void Render(void);
 
 	void AddObject( shared_ptr<GameObject> ptr );
@@ -40,6 +72,18 @@ public:
 	void FireObjectAdded( shared_ptr<GameObject> ptr );
 	void FireObjectRemoved( shared_ptr<GameObject> ptr );
 
+	shared_ptr<GameObject> FindObject(uint id);
+
+	void TakeSnapshot(WorldSnapshot& snapshot);
+	bool RestoreSnapshot(const WorldSnapshot& snapshot);
+	bool ReplicateSnapshot(const WorldSnapshot& snapshot);
+	void SetObjectFactory(GameObjectFactory factory) { mObjectFactory = factory; }
+
+	void SetStepListener(IStepListener* lptr) { mStepListener = lptr; }
+
+	void AddSnapshotListener(ISnapshotListener* lptr) { mSnapshotListeners.push_back(lptr); }
+	void RemoveSnapshotListener(ISnapshotListener* lptr) { mSnapshotListeners.remove(lptr); }
+
 	void SetWidth(int w) { mWidth = w; }
 	int GetWidth() { return mWidth; }
 
@@ -48,9 +92,27 @@ public:
 
 	void WrapXY(float &x, float &y);
 
+	SpriteBatch* GetSpriteBatch() { return &mSpriteBatch; }
+	void SetSpriteBatching(bool enabled) { mSpriteBatch.SetEnabled(enabled); }
+
+	TimerWheel& GetTimers() { return mTimers; }
+	SimulationClock& GetClock() { return mClock; }
+
+	void SetSeed(uint seed);
+	uint GetSeed() const { return mSeed; }
+	RandomStream& GetRandom(RandomStreamId id) { return mRandom[id]; }
+	RandomStream CreateRandomStream(RandomStreamId id, uint thread) const;
+
+	uint GetStateChecksum() const;
+
+	void SetReplicated(bool replicated) { mReplicated = replicated; }
+	bool IsReplicated() const { return mReplicated; }
+
 protected:
 	void UpdateObjects(int t);
 	void UpdateCollisions(int t);
+	void RestoreObjects(const WorldSnapshot& snapshot);
+	void DetachObject(shared_ptr<GameObject> ptr);
 
 	// Create a map of named game objects
 	GameObjectList mGameObjects;
@@ -65,10 +127,35 @@ protected:
 	// Create a list of game world listeners
 	GameWorldListenerList mListeners;
 
+	// Listeners that save and restore game state alongside the world's
+	typedef list< ISnapshotListener* > SnapshotListenerList;
+	SnapshotListenerList mSnapshotListeners;
+	// Makes objects a restored snapshot has that the world does not
+	GameObjectFactory mObjectFactory;
+	// Decides whether each step taken as the world is advanced can go ahead
+	IStepListener* mStepListener;
+
 	// The width of the world
 	int mWidth;
 	// The height of the world
 	int mHeight;
+
+	// Collects sprites during rendering so they can be drawn together
+	SpriteBatch mSpriteBatch;
+	// Draw commands for every object, sorted to minimise state changes
+	RenderQueue mRenderQueue;
+	// Timers that run on game time, advanced with each update
+	TimerWheel mTimers;
+	// Decides how many fixed steps to run for the time that has passed
+	SimulationClock mClock;
+
+	// Seed for every random stream in the world
+	uint mSeed;
+	RandomStream mRandom[RANDOM_STREAM_COUNT];
+	// Given to each object as it is added, starting from 1
+	uint mNextObjectId;
+	// Objects are only moved by snapshots from a world run elsewhere
+	bool mReplicated;
 };
 
 #endif
\ No newline at end of file
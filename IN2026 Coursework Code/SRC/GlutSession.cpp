@@ -1,6 +1,5 @@
 #include <GL/glut.h>
 #include <stdlib.h>
-#include "ITimerListener.h"
 #include "GlutWindow.h"
 #include "GlutSession.h"
 
@@ -73,12 +72,6 @@ void GlutSession::CallBackVisibilityFunc(int visibility)
 	if (mWindow) mWindow->OnWindowVisible(visibility);
 }
 
-void GlutSession::CallBackSessionTimerFunc(int value)
-{
-	// Pass callback to window
-	GlutSession::GetInstance().OnTimer(value);
-}
-
 void GlutSession::CallBackWindowTimerFunc(int value)
 {
 	// Pass callback to window
@@ -102,42 +95,12 @@ void GlutSession::RegisterCallbacks()
 	if (mWindow) { glutIdleFunc(CallBackIdleFunc); } else { glutIdleFunc(0); }
 }
 
-void GlutSession::RegisterSessionTimer(uint msecs, int value)
-{
-	// Register callback function for session based timers
-	glutTimerFunc(msecs, CallBackSessionTimerFunc, value);
-}
-
 void GlutSession::RegisterWindowTimer(uint msecs, int value)
 {
 	// Register callback function for window based timers
 	glutTimerFunc(msecs, CallBackWindowTimerFunc, value);
 }
 
-void GlutSession::SetTimer(uint msecs, ITimerListener* listener, int value)
-{
-	// A unique key for timer event
-	static int key = INT_MIN;
-	if (++key == INT_MAX) key = INT_MIN;
-	// Store listener and value
-	mTimerListeners[key] = ListenerValuePair(listener, value);
-	// Register timer event
-	RegisterSessionTimer(msecs, key);
-}
-
-void GlutSession::OnTimer(int key)
-{
-	// Retrieve listener and value given key
-	TimerListenerMap::iterator i = mTimerListeners.find(key);
-	if (i == mTimerListeners.end()) return;
-	ITimerListener* listener = (i->second).first;
-	int value = (i->second).second;
-	// Call listener with value
-	listener->OnTimer(value);
-	// Remove listener and value
-	mTimerListeners.erase(i);
-}
-
 void GlutSession::Init(int &argc, char* argv[])
 {
 	// Initialize GLUT
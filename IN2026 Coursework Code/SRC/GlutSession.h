@@ -1,12 +1,9 @@
 #ifndef __GLUTSESSION_H__
 #define __GLUTSESSION_H__
 
-#include <map>
-
 using namespace std;
 
 class GlutWindow;
-class ITimerListener;
 
 typedef unsigned int uint;
 typedef unsigned char uchar;
@@ -27,24 +24,16 @@ public:
 	void EnableIdleFunction(void) { mIdleFunctionEnabled = true; }
 	bool IdleFunctionEnabled(void) { return(mIdleFunctionEnabled); }
 
-	static void RegisterSessionTimer(uint msecs, int value);
 	static void RegisterWindowTimer(uint msecs, int value);
 
 	static void Init(int &argc, char* argv[]);
 	static void Start(void);
 	static void Stop(void);
 
-	void SetTimer(uint msecs, ITimerListener* listener, int value = 0);
-	void OnTimer(int value);
-
 private:
 	GlutSession(void) {}
 	~GlutSession(void) {}
 
-	typedef pair<ITimerListener*, int> ListenerValuePair;
-	typedef map<int, ListenerValuePair> TimerListenerMap;
-	TimerListenerMap mTimerListeners;
-
 	static void CallBackDisplayFunc(void);
 	static void CallBackIdleFunc(void); 
 	static void CallBackKeyboardFunc(uchar key, int x, int y);
@@ -57,7 +46,6 @@ private:
 	static void CallBackReshapeFunc(int w, int h); 
 	static void CallBackVisibilityFunc(int visibility);
 	
-	static void CallBackSessionTimerFunc(int value);
 	static void CallBackWindowTimerFunc(int value);
 
 	static void RegisterCallbacks(void);
@@ -14,8 +14,10 @@ GlutWindow::GlutWindow(int w, int h, int x, int y, char* title)
 	mYCoord = y;
 	mFullscreen = false;
 
-	// Set initial display mode to use 32-bit colour and double buffering
-	glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE);
+	// Set initial display mode to use 32-bit colour and double buffering, with
+	// destination alpha for the display's cached overlay where there is any
+	glutInitDisplayMode(GLUT_RGBA | GLUT_ALPHA | GLUT_DOUBLE);
+	if (!glutGet(GLUT_DISPLAY_MODE_POSSIBLE)) glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE);
 	
 	// Set initial window size
 	glutInitWindowSize(mWidth, mHeight);
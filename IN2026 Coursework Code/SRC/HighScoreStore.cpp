@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <string.h>
+#include <time.h>
+#include "FileUtil.h"
+#include "HighScoreStore.h"
+
+const char HighScoreStore::MAGIC[4] = { 'H', 'S', 'L', 'G' };
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. Scores can be added before opening, but are not saved. */
+HighScoreStore::HighScoreStore()
+	: mTable(MAX_ENTRIES),
+	  mNextSequence(1),
+	  mWriting(false),
+	  mStopping(false),
+	  mCompactNeeded(false)
+{
+}
+
+/** Destructor. Waits for scores still being written. */
+HighScoreStore::~HighScoreStore()
+{
+	Close();
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Read the scores in a log and start saving new ones to it. If there is no log yet
+	it is created, starting with the scores in the old text file legacy_filename. */
+bool HighScoreStore::Open(const string& filename, const string& legacy_filename)
+{
+	Close();
+	mFilename = filename;
+	mTable.Clear();
+	mLogEntries.clear();
+	mNextSequence = 1;
+	mCompactNeeded = false;
+
+	ifstream file(filename.c_str(), ios::in | ios::binary);
+	if (file) {
+		HighScoreLogHeader header;
+		file.read((char*)&header, sizeof(header));
+		if (!file || 0 != memcmp(header.magic, MAGIC, sizeof(header.magic)) || header.version != VERSION) {
+			// Leave it for someone to look at rather than write over it
+			cerr << "Invalid high score log " << filename << endl;
+			return false;
+		}
+		Load(file);
+	} else {
+		if (!legacy_filename.empty()) ImportLegacy(legacy_filename);
+		mCompactNeeded = true;
+	}
+
+	mStopping = false;
+	mWriting = mCompactNeeded;
+	mWriter = thread(&HighScoreStore::RunWriter, this);
+	return true;
+}
+
+/** Write any scores still waiting and stop the writer. */
+void HighScoreStore::Close(void)
+{
+	if (!mWriter.joinable()) return;
+	{
+		lock_guard<mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mWakeWriter.notify_one();
+	mWriter.join();
+}
+
+/** Add a score to the table and have it saved in the background. Returns its rank, from 1. */
+uint HighScoreStore::Add(const string& name, int score)
+{
+	HighScoreEntry entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.score = score;
+	entry.sequence = mNextSequence++;
+	entry.time = (uint)::time(NULL);
+	strncpy(entry.name, name.c_str(), sizeof(entry.name) - 1);
+
+	// Ties rank below the scores already there, so the rank is known before adding it
+	uint rank = mTable.GetRank(score);
+	mTable.Add(entry);
+	if (IsOpen()) {
+		{
+			lock_guard<mutex> lock(mMutex);
+			mPending.push_back(entry);
+		}
+		mWakeWriter.notify_one();
+	}
+	return rank;
+}
+
+/** Wait until every score added so far has been written. */
+void HighScoreStore::Flush(void)
+{
+	unique_lock<mutex> lock(mMutex);
+	mWritten.wait(lock, [this] { return !mWriter.joinable() || (mPending.empty() && !mWriting); });
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+/** Read every whole entry after the header. Anything after the first torn entry is dropped
+	by compacting the log, as it was written after a crash part way through an append. */
+void HighScoreStore::Load(ifstream& file)
+{
+	char record[sizeof(HighScoreEntry) + sizeof(uint)];
+	HighScoreEntry entry;
+	uint checksum;
+	while (file.read(record, sizeof(record))) {
+		memcpy(&entry, record, sizeof(entry));
+		memcpy(&checksum, record + sizeof(entry), sizeof(checksum));
+		if (checksum != GetChecksum(entry)) break;
+		entry.name[sizeof(entry.name) - 1] = '\0';
+		mTable.Add(entry);
+		mLogEntries.push_back(entry);
+		mNextSequence = max(mNextSequence, entry.sequence + 1);
+	}
+	if (!file.eof() || file.gcount() != 0) {
+		cerr << "Dropped a damaged entry at the end of " << mFilename << endl;
+		mCompactNeeded = true;
+	}
+	if (mLogEntries.size() >= MAX_ENTRIES + COMPACT_SLACK) mCompactNeeded = true;
+}
+
+/** Add the three scores from the high score text file of older versions. */
+void HighScoreStore::ImportLegacy(const string& legacy_filename)
+{
+	ifstream file(legacy_filename.c_str());
+	if (!file) return;
+	int score;
+	uint imported = 0;
+	while (imported < 3 && file >> score) {
+		imported++;
+		if (score <= 0) continue;
+		uint rank = Add("Player", score);
+		mLogEntries.push_back(*mTable.GetEntry(rank));
+	}
+	cout << "Imported high scores from " << legacy_filename << endl;
+}
+
+void HighScoreStore::RunWriter(void)
+{
+	if (mCompactNeeded) {
+		Compact();
+		lock_guard<mutex> lock(mMutex);
+		mWriting = false;
+		mWritten.notify_all();
+	} else {
+		mLog.open(mFilename.c_str(), ios::out | ios::binary | ios::app);
+		if (!mLog) cerr << "Error opening " << mFilename << endl;
+	}
+
+	vector<HighScoreEntry> entries;
+	unique_lock<mutex> lock(mMutex);
+	while (true) {
+		mWakeWriter.wait(lock, [this] { return mStopping || !mPending.empty(); });
+		if (mPending.empty()) break;
+		entries.swap(mPending);
+		mWriting = true;
+		lock.unlock();
+
+		Append(entries);
+		entries.clear();
+		if (mLogEntries.size() >= MAX_ENTRIES + COMPACT_SLACK) Compact();
+
+		lock.lock();
+		mWriting = false;
+		mWritten.notify_all();
+	}
+	mLog.close();
+}
+
+bool HighScoreStore::Append(const vector<HighScoreEntry>& entries)
+{
+	for (uint i = 0; i < entries.size(); i++) {
+		uint checksum = GetChecksum(entries[i]);
+		mLog.write((const char*)&entries[i], sizeof(entries[i]));
+		mLog.write((const char*)&checksum, sizeof(checksum));
+		mLogEntries.push_back(entries[i]);
+	}
+	mLog.flush();
+	if (!mLog) { cerr << "Error writing " << mFilename << endl; return false; }
+	return true;
+}
+
+/** Write the scores still in the table to a new log and rename it over the old one,
+	so a crash part way through leaves the old log as it was. */
+bool HighScoreStore::Compact(void)
+{
+	mCompactNeeded = false;
+	if (mLogEntries.size() > MAX_ENTRIES) {
+		nth_element(mLogEntries.begin(), mLogEntries.begin() + MAX_ENTRIES, mLogEntries.end(), HighScoreTable::IsBefore);
+		mLogEntries.resize(MAX_ENTRIES);
+	}
+	// Written in the order added, so reading it back builds the same table
+	sort(mLogEntries.begin(), mLogEntries.end(),
+		[](const HighScoreEntry& a, const HighScoreEntry& b) { return a.sequence < b.sequence; });
+
+	mLog.close();
+	string temp_filename = mFilename + ".tmp";
+	ofstream file(temp_filename.c_str(), ios::out | ios::binary | ios::trunc);
+	bool written = !!file;
+	if (written) {
+		HighScoreLogHeader header;
+		memcpy(header.magic, MAGIC, sizeof(header.magic));
+		header.version = VERSION;
+		file.write((const char*)&header, sizeof(header));
+		for (uint i = 0; i < mLogEntries.size(); i++) {
+			uint checksum = GetChecksum(mLogEntries[i]);
+			file.write((const char*)&mLogEntries[i], sizeof(mLogEntries[i]));
+			file.write((const char*)&checksum, sizeof(checksum));
+		}
+		file.close();
+		written = !!file;
+	}
+	if (!written) {
+		cerr << "Error writing " << temp_filename << endl;
+	} else {
+		written = FileUtil::Replace(temp_filename, mFilename);
+		if (!written) cerr << "Error replacing " << mFilename << endl;
+	}
+	mLog.open(mFilename.c_str(), ios::out | ios::binary | ios::app);
+	return written;
+}
+
+// PRIVATE STATIC METHODS /////////////////////////////////////////////////////
+
+/** FNV-1a hash of an entry, to tell a whole entry from one cut off by a crash. */
+uint HighScoreStore::GetChecksum(const HighScoreEntry& entry)
+{
+	const uchar* bytes = (const uchar*)&entry;
+	uint hash = 2166136261u;
+	for (uint i = 0; i < sizeof(entry); i++) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef __HIGHSCORESTORE_H__
+#define __HIGHSCORESTORE_H__
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "GameUtil.h"
+#include "HighScoreTable.h"
+
+// Header of a high score log, followed by a HighScoreEntry and its checksum for each score added
+struct HighScoreLogHeader
+{
+	char magic[4];
+	uint version;
+};
+
+// Keeps the high scores in memory and on disk. Each score is added to the
+// table at once and appended to a log by a writer thread, so the game never
+// waits for the disk. A crash can only cut off the end of the log, and a
+// torn entry fails its checksum and is ignored when the log is read. Once
+// the log holds enough scores that have fallen off the table, the writer
+// writes the table to a new file and renames it over the log, so the log
+// on disk is always complete.
+class HighScoreStore
+{
+public:
+	static const char MAGIC[4];
+	static const uint VERSION = 1;
+	static const uint MAX_ENTRIES = 10000;
+	// Scores the log can hold beyond the table before it is compacted
+	static const uint COMPACT_SLACK = 1000;
+
+	HighScoreStore();
+	~HighScoreStore();
+
+	bool Open(const string& filename, const string& legacy_filename = "");
+	void Close(void);
+	bool IsOpen() const { return mWriter.joinable(); }
+
+	uint Add(const string& name, int score);
+	void Flush(void);
+
+	const HighScoreTable& GetTable() const { return mTable; }
+
+private:
+	void Load(ifstream& file);
+	void ImportLegacy(const string& legacy_filename);
+	void RunWriter(void);
+	bool Append(const vector<HighScoreEntry>& entries);
+	bool Compact(void);
+
+	static uint GetChecksum(const HighScoreEntry& entry);
+
+	string mFilename;
+	HighScoreTable mTable;
+	uint mNextSequence;
+
+	// Shared with the writer thread
+	thread mWriter;
+	mutex mMutex;
+	condition_variable mWakeWriter;
+	condition_variable mWritten;
+	vector<HighScoreEntry> mPending;
+	bool mWriting;
+	bool mStopping;
+
+	// Only used by the writer thread once it has started
+	ofstream mLog;
+	vector<HighScoreEntry> mLogEntries;
+	bool mCompactNeeded;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "HighScoreTable.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Constructor, for a table of at most max_entries scores. */
+HighScoreTable::HighScoreTable(uint max_entries)
+	: mMaxEntries(max_entries),
+	  mRoot(NONE),
+	  mRandom(1)
+{
+}
+
+/** Destructor. */
+HighScoreTable::~HighScoreTable()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+void HighScoreTable::Clear(void)
+{
+	mRoot = NONE;
+	mNodes.clear();
+	mFreeNodes.clear();
+}
+
+/** Add an entry in its place, dropping the lowest if the table is then too large. */
+void HighScoreTable::Add(const HighScoreEntry& entry)
+{
+	uint node;
+	if (mFreeNodes.empty()) {
+		node = (uint)mNodes.size();
+		mNodes.push_back(HighScoreNode());
+	} else {
+		node = mFreeNodes.back();
+		mFreeNodes.pop_back();
+	}
+	HighScoreNode& new_node = mNodes[node];
+	new_node.entry = entry;
+	new_node.priority = mRandom.Next();
+	new_node.left = new_node.right = NONE;
+	new_node.size = 1;
+
+	uint before, after;
+	Split(mRoot, entry, before, after);
+	mRoot = Merge(Merge(before, node), after);
+
+	if (GetCount() > mMaxEntries) {
+		uint removed = NONE;
+		mRoot = RemoveLast(mRoot, removed);
+		mFreeNodes.push_back(removed);
+	}
+}
+
+/** The rank, from 1, that a new entry with this score would have. */
+uint HighScoreTable::GetRank(int score) const
+{
+	uint ahead = 0;
+	uint node = mRoot;
+	while (node != NONE) {
+		const HighScoreNode& n = mNodes[node];
+		if (n.entry.score >= score) {
+			ahead += GetSize(n.left) + 1;
+			node = n.right;
+		} else {
+			node = n.left;
+		}
+	}
+	return ahead + 1;
+}
+
+/** The entry at a rank, from 1, or NULL if there are not that many. */
+const HighScoreEntry* HighScoreTable::GetEntry(uint rank) const
+{
+	if (rank == 0 || rank > GetCount()) return NULL;
+	uint index = rank - 1;
+	uint node = mRoot;
+	while (node != NONE) {
+		const HighScoreNode& n = mNodes[node];
+		uint left_size = GetSize(n.left);
+		if (index < left_size) {
+			node = n.left;
+		} else if (index == left_size) {
+			return &n.entry;
+		} else {
+			index -= left_size + 1;
+			node = n.right;
+		}
+	}
+	return NULL;
+}
+
+/** Replace entries with up to count entries in rank order, starting at the rank first_rank (from 1). */
+void HighScoreTable::GetRange(uint first_rank, uint count, vector<HighScoreEntry>& entries) const
+{
+	entries.clear();
+	if (first_rank == 0 || first_rank > GetCount()) return;
+
+	// Find the first entry, keeping the nodes still to visit after it
+	vector<uint> path;
+	uint index = first_rank - 1;
+	uint node = mRoot;
+	while (node != NONE) {
+		const HighScoreNode& n = mNodes[node];
+		uint left_size = GetSize(n.left);
+		if (index < left_size) {
+			path.push_back(node);
+			node = n.left;
+		} else if (index == left_size) {
+			path.push_back(node);
+			break;
+		} else {
+			index -= left_size + 1;
+			node = n.right;
+		}
+	}
+
+	while (!path.empty() && entries.size() < count) {
+		node = path.back();
+		path.pop_back();
+		entries.push_back(mNodes[node].entry);
+		for (node = mNodes[node].right; node != NONE; node = mNodes[node].left) path.push_back(node);
+	}
+}
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+/** Whether a ranks above b. */
+bool HighScoreTable::IsBefore(const HighScoreEntry& a, const HighScoreEntry& b)
+{
+	if (a.score != b.score) return a.score > b.score;
+	return a.sequence < b.sequence;
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+void HighScoreTable::UpdateSize(uint node)
+{
+	HighScoreNode& n = mNodes[node];
+	n.size = GetSize(n.left) + GetSize(n.right) + 1;
+}
+
+/** Split a subtree into the entries that rank above entry and the rest. */
+void HighScoreTable::Split(uint node, const HighScoreEntry& entry, uint& before, uint& after)
+{
+	if (node == NONE) {
+		before = after = NONE;
+		return;
+	}
+	if (IsBefore(mNodes[node].entry, entry)) {
+		Split(mNodes[node].right, entry, mNodes[node].right, after);
+		before = node;
+	} else {
+		Split(mNodes[node].left, entry, before, mNodes[node].left);
+		after = node;
+	}
+	UpdateSize(node);
+}
+
+/** Join two subtrees where everything in before ranks above everything in after. */
+uint HighScoreTable::Merge(uint before, uint after)
+{
+	if (before == NONE) return after;
+	if (after == NONE) return before;
+	if (mNodes[before].priority > mNodes[after].priority) {
+		mNodes[before].right = Merge(mNodes[before].right, after);
+		UpdateSize(before);
+		return before;
+	}
+	mNodes[after].left = Merge(before, mNodes[after].left);
+	UpdateSize(after);
+	return after;
+}
+
+/** Take the lowest ranked node out of a subtree, returning the subtree's new root. */
+uint HighScoreTable::RemoveLast(uint node, uint& removed)
+{
+	if (mNodes[node].right == NONE) {
+		removed = node;
+		return mNodes[node].left;
+	}
+	mNodes[node].right = RemoveLast(mNodes[node].right, removed);
+	UpdateSize(node);
+	return node;
+}
\ No newline at end of file
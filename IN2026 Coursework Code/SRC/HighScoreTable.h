@@ -0,0 +1,66 @@
+#ifndef __HIGHSCORETABLE_H__
+#define __HIGHSCORETABLE_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "RandomStream.h"
+
+// One score in the table, as it is stored in the high score log
+struct HighScoreEntry
+{
+	int score;
+	// Increases with each score added, so the first to reach a score ranks above later ones
+	uint sequence;
+	// Seconds since 1970
+	uint time;
+	char name[20];
+};
+
+// Every score in rank order, highest first, kept in a treap whose nodes know
+// the size of their subtree. Adding a score, finding the rank a score would
+// have and finding the entry at a rank all take O(log n), and reading n
+// entries from any rank takes O(log n + n). Above the maximum size, the
+// lowest score is dropped as each new one is added.
+class HighScoreTable
+{
+public:
+	HighScoreTable(uint max_entries);
+	~HighScoreTable();
+
+	void Clear(void);
+	void Add(const HighScoreEntry& entry);
+
+	uint GetCount() const { return mRoot == NONE ? 0 : mNodes[mRoot].size; }
+	uint GetMaxEntries() const { return mMaxEntries; }
+	uint GetRank(int score) const;
+	const HighScoreEntry* GetEntry(uint rank) const;
+	void GetRange(uint first_rank, uint count, vector<HighScoreEntry>& entries) const;
+
+	static bool IsBefore(const HighScoreEntry& a, const HighScoreEntry& b);
+
+private:
+	static const uint NONE = 0xFFFFFFFF;
+
+	struct HighScoreNode
+	{
+		HighScoreEntry entry;
+		uint priority;
+		uint left;
+		uint right;
+		uint size;
+	};
+
+	uint GetSize(uint node) const { return node == NONE ? 0 : mNodes[node].size; }
+	void UpdateSize(uint node);
+	void Split(uint node, const HighScoreEntry& entry, uint& before, uint& after);
+	uint Merge(uint before, uint after);
+	uint RemoveLast(uint node, uint& removed);
+
+	uint mMaxEntries;
+	uint mRoot;
+	vector<HighScoreNode> mNodes;
+	vector<uint> mFreeNodes;
+	RandomStream mRandom;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef __INETSERVERLISTENER_H__
+#define __INETSERVERLISTENER_H__
+
+#include "NetProtocol.h"
+
+class NetServer;
+
+class INetServerListener
+{
+public:
+	virtual void OnClientConnected(NetServer* server, uint client_id) = 0;
+	virtual void OnClientInput(NetServer* server, uint client_id, const NetInput& input) = 0;
+	virtual void OnClientDisconnected(NetServer* server, uint client_id) = 0;
+};
+
+#endif
\ No newline at end of file
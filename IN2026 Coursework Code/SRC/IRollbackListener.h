@@ -0,0 +1,17 @@
+#ifndef __IROLLBACKLISTENER_H__
+#define __IROLLBACKLISTENER_H__
+
+#include "GameUtil.h"
+
+class RollbackSession;
+
+class IRollbackListener
+{
+public:
+	// Once for each new frame, before the local player's input is taken for it
+	virtual void OnRollbackFrame(RollbackSession* session, uint frame) = 0;
+	// A player's buttons for the step about to be taken, again each time it is simulated
+	virtual void OnRollbackInput(RollbackSession* session, uint player, uint buttons) = 0;
+};
+
+#endif
\ No newline at end of file
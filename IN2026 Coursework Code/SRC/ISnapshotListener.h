@@ -0,0 +1,14 @@
+#ifndef __ISNAPSHOTLISTENER_H__
+#define __ISNAPSHOTLISTENER_H__
+
+class GameWorld;
+class WorldSnapshot;
+
+class ISnapshotListener
+{
+public:
+	virtual void OnSnapshotTaken(GameWorld* world, WorldSnapshot& snapshot) = 0;
+	virtual void OnSnapshotRestored(GameWorld* world, const WorldSnapshot& snapshot) = 0;
+};
+
+#endif
\ No newline at end of file
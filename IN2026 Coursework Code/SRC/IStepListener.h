@@ -0,0 +1,13 @@
+#ifndef __ISTEPLISTENER_H__
+#define __ISTEPLISTENER_H__
+
+class GameWorld;
+
+class IStepListener
+{
+public:
+	// Return false to hold the step back until the world is next advanced
+	virtual bool OnStepStarting(GameWorld* world) = 0;
+};
+
+#endif
\ No newline at end of file
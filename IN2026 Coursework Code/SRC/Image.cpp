@@ -1,5 +1,6 @@
 #include "GameUtil.h"
 #include "Image.h"
+#include "PixelKernels.h"
 
 #include "FreeImage.h"
 
@@ -9,14 +10,16 @@ Image::Image()
 	: mWidth(0),
 	  mHeight(0),
 	  mNumPixels(0),
-	  mPixelData(NULL)
+	  mPixelData(NULL),
+	  mFormat(PIXEL_FORMAT_BGRA8)
 {
 }
 
 Image::Image(uint width, uint height)
 	: mWidth(width),
 	  mHeight(height),
-	  mNumPixels(width*height)
+	  mNumPixels(width*height),
+	  mFormat(PIXEL_FORMAT_BGRA8)
 {
 	mPixelData = new uchar[4*mNumPixels];
 }
@@ -24,7 +27,8 @@ Image::Image(uint width, uint height)
 Image::Image(uint width, uint height, const string& filename)
 	: mWidth(width),
 	  mHeight(height),
-	  mNumPixels(width*height)
+	  mNumPixels(width*height),
+	  mFormat(PIXEL_FORMAT_BGRA8)
 {
 	mPixelData = new uchar[4*mNumPixels];
 	LoadFile(filename);
@@ -33,53 +37,130 @@ Image::Image(uint width, uint height, const string& filename)
 Image::Image(Image* image, uint x, uint y, uint width, uint height)
 	: mWidth(width),
 	  mHeight(height),
-	  mNumPixels(width*height)
+	  mNumPixels(width*height),
+	  mFormat(image->GetFormat())
 {
 	mPixelData = new uchar[4*mNumPixels];
-	uchar *src_pixels = image->GetPixelData();
-	uint dst = 0;
-	
-	for (uint j = 0; j < height; j++)
-	{
-		for (uint i = 0; i < width; i++)
-		{
-			mPixelData[dst++] = 255;
-			mPixelData[dst++] = 0;
-			mPixelData[dst++] = 0;
-			mPixelData[dst++] = 255;
-		}
-	}
-	dst = 0;
-	
-	for (uint j = 0; j < height; j++)
-	{
-		uint src = 4 * (x + ((y + j) * image->GetWidth()));
-		for (uint i = 0; i < width; i++)
-		{
-			mPixelData[dst++] = src_pixels[src++];
-			mPixelData[dst++] = src_pixels[src++];
-			mPixelData[dst++] = src_pixels[src++];
-			mPixelData[dst++] = src_pixels[src++];
-		}
-	}
+	CopyView(image->GetView(x, y, width, height));
+}
+
+Image::Image(const ImageView& view)
+	: mWidth(view.width),
+	  mHeight(view.height),
+	  mNumPixels(view.width*view.height),
+	  mFormat(view.format)
+{
+	mPixelData = new uchar[GetPixelSize(mFormat)*mNumPixels];
+	CopyView(view);
 }
 
 Image::~Image()
 {
 	delete[] mPixelData;
+	for (uint i = 0; i < mMipLevels.size(); i++) delete mMipLevels[i];
+}
+
+void Image::CopyView(const ImageView& view)
+{
+	// Copy whole rows at a time, or everything at once if the view has no gaps
+	uint row_bytes = GetPixelSize(view.format) * view.width;
+	if (view.IsContiguous()) {
+		memcpy(mPixelData, view.data, row_bytes * view.height);
+		return;
+	}
+	for (uint j = 0; j < view.height; j++) {
+		memcpy(mPixelData + j*row_bytes, view.GetRow(j), row_bytes);
+	}
 }
 
 void Image::SetTransparentColour(uchar r, uchar g, uchar b)
 {
-	for (uint i = 0; i < 4*mNumPixels; i += 4) {
-		if (mPixelData[i] == r && mPixelData[i+1] == g && mPixelData[i+2] == b) {
-			// Make pixel transparent
-			mPixelData[i+3] = 0;
-		} else {
-			// Make pixel opaque
-			mPixelData[i+3] = 255;
-		}
+	// Pixels matching the colour become transparent, all others opaque
+	PixelKernels::ApplyColourKey(mPixelData, mNumPixels, r, g, b);
+}
+
+void Image::PremultiplyAlpha(void)
+{
+	PixelKernels::PremultiplyAlpha(mPixelData, mNumPixels);
+}
+
+/** Build successively halved copies of the image with a box filter, up to max_levels
+	levels in total including the image itself. Safe to call on a worker thread. */
+void Image::GenerateMipmaps(uint max_levels)
+{
+	if (mFormat != PIXEL_FORMAT_BGRA8) return;
+	Image* level = mMipLevels.empty() ? this : mMipLevels.back();
+	while (GetNumLevels() < max_levels && level->mWidth % 2 == 0 && level->mHeight % 2 == 0) {
+		Image* next = new Image(level->mWidth / 2, level->mHeight / 2);
+		PixelKernels::Downsample2x2(level->mPixelData, 4 * level->mWidth, next->mPixelData, next->mWidth, next->mHeight);
+		mMipLevels.push_back(next);
+		level = next;
+	}
+}
+
+/** Bytes of pixel data held by the image, including its mipmaps. */
+size_t Image::GetByteSize() const
+{
+	size_t bytes = GetPixelSize(mFormat) * (size_t)mNumPixels;
+	for (uint i = 0; i < mMipLevels.size(); i++) bytes += mMipLevels[i]->GetByteSize();
+	return bytes;
+}
+
+ImageViewVector Image::GetLevelViews() const
+{
+	ImageViewVector levels(1, GetView());
+	for (uint i = 0; i < mMipLevels.size(); i++) levels.push_back(mMipLevels[i]->GetView());
+	return levels;
+}
+
+/** Number of levels, including the full size one, a width x height block can be
+	halved into while both sides stay whole. Blocks on a grid of that size, such
+	as the frames of a sprite sheet, never mix with each other in those levels. */
+uint Image::CountMipLevels(uint width, uint height)
+{
+	uint levels = 1;
+	while (width > 1 && height > 1 && width % 2 == 0 && height % 2 == 0) {
+		width /= 2;
+		height /= 2;
+		levels++;
+	}
+	return levels;
+}
+
+/** Offline or worker thread analysis: the smallest format that keeps every
+	channel of every level within max_error of its current value, with 0
+	meaning lossless. Filtered mipmaps have soft edges a full size level with
+	hard ones may not, so each level is measured. */
+PixelFormat Image::ChooseFormat(uint max_error) const
+{
+	if (mFormat != PIXEL_FORMAT_BGRA8) return mFormat;
+	uint errors[PIXEL_FORMAT_COUNT];
+	PixelKernels::MeasureFormatErrors(mPixelData, 4 * mWidth, mWidth, mHeight, errors);
+	for (uint i = 0; i < mMipLevels.size(); i++) {
+		const Image* level = mMipLevels[i];
+		uint level_errors[PIXEL_FORMAT_COUNT];
+		PixelKernels::MeasureFormatErrors(level->mPixelData, 4 * level->mWidth, level->mWidth, level->mHeight, level_errors);
+		for (uint f = 0; f < PIXEL_FORMAT_COUNT; f++) errors[f] = max(errors[f], level_errors[f]);
 	}
+
+	// The compact formats are all the same size, so pick the most faithful
+	PixelFormat best = PIXEL_FORMAT_BGRA8;
+	for (uint f = PIXEL_FORMAT_LA8; f < PIXEL_FORMAT_COUNT; f++) {
+		if (errors[f] <= max_error && (best == PIXEL_FORMAT_BGRA8 || errors[f] < errors[best])) best = (PixelFormat)f;
+	}
+	return best;
+}
+
+/** Repack the image and its mipmaps into a different format. Only BGRA8 can be converted. */
+void Image::ConvertToFormat(PixelFormat format)
+{
+	if (mFormat != PIXEL_FORMAT_BGRA8 || format == PIXEL_FORMAT_BGRA8) return;
+	uchar* packed = new uchar[GetPixelSize(format)*mNumPixels];
+	PixelKernels::ConvertFromBGRA(mPixelData, 4 * mWidth, mWidth, mHeight, format, packed);
+	delete[] mPixelData;
+	mPixelData = packed;
+	mFormat = format;
+	for (uint i = 0; i < mMipLevels.size(); i++) mMipLevels[i]->ConvertToFormat(format);
 }
 
 void Image::LoadFile(const string& filename)
@@ -107,30 +188,19 @@ void Image::LoadFile(const string& filename)
 	}
 
 	// Check for 24 bits or 32 bits
-	int bpp = FreeImage_GetBPP(pBitmap);
-
-	//Free image has an inverted co-ordinate system. Fix as follows:
-	// Flip the image vertically
-	FreeImage_FlipVertical(pBitmap);
-	// Flip the image horizontally
-	FreeImage_FlipHorizontal(pBitmap);
-
-	BYTE* pPixelData = FreeImage_GetBits(pBitmap);
-
-	if(bpp == 24)
-	{
-		for(uint i = 0; i < mNumPixels*4; i +=4)
-		{
-			mPixelData[i+0] = pPixelData[i+0];
-			mPixelData[i+1] = pPixelData[i+1];
-			mPixelData[i+2] = pPixelData[i+2];
-			mPixelData[i+3] = 255;
-		}
-	}
-	else if(bpp == 32)
+	uint bpp = FreeImage_GetBPP(pBitmap);
+	if ((bpp != 24 && bpp != 32) || FreeImage_GetWidth(pBitmap) != mWidth || FreeImage_GetHeight(pBitmap) != mHeight)
 	{
-		memcpy(mPixelData, pPixelData, sizeof(uchar) * mNumPixels * 4);
+		cerr << "Unsupported image " << filename << " (" << FreeImage_GetWidth(pBitmap) << "x" << FreeImage_GetHeight(pBitmap) << ", " << bpp << " bpp)" << endl;
+		FreeImage_Unload(pBitmap);
+		return;
 	}
 
+	//Free image has an inverted co-ordinate system. Fix it by rotating the
+	//image 180 degrees while copying, which is the same as flipping it
+	//vertically and then horizontally. Rows are padded to the bitmap's pitch.
+	BYTE* pPixelData = FreeImage_GetBits(pBitmap);
+	PixelKernels::ConvertToBGRA(pPixelData, FreeImage_GetPitch(pBitmap), bpp, mPixelData, mWidth, mHeight, PIXEL_ORIENTATION_ROTATE_180);
+
 	FreeImage_Unload(pBitmap);
 }
\ No newline at end of file
@@ -1,10 +1,33 @@
 #ifndef __IMAGE_H__
 #define __IMAGE_H__
 
+#include <vector>
 #include "GameUtil.h"
+#include "PixelFormat.h"
 
 using namespace std;
 
+// Non-owning rectangle of pixels inside an image. Rows are stride bytes
+// apart, so a view of part of a sheet shares the sheet's pixels.
+struct ImageView
+{
+	ImageView() : data(NULL), width(0), height(0), stride(0), format(PIXEL_FORMAT_BGRA8) {}
+	ImageView(const uchar* d, uint w, uint h, uint s, PixelFormat f = PIXEL_FORMAT_BGRA8) : data(d), width(w), height(h), stride(s), format(f) {}
+
+	const uchar* GetRow(uint y) const { return data + y*stride; }
+	ImageView GetView(uint x, uint y, uint w, uint h) const { return ImageView(data + GetPixelSize(format)*x + y*stride, w, h, stride, format); }
+	bool IsContiguous() const { return stride == GetPixelSize(format)*width; }
+
+	const uchar* data;
+	uint width;
+	uint height;
+	uint stride;
+	PixelFormat format;
+};
+
+// Mipmap levels of an image, full size first
+typedef vector<ImageView> ImageViewVector;
+
 class Image
 {
 public:
@@ -12,9 +35,25 @@ public:
 	Image(uint width, uint height);
 	Image(uint width, uint height, const string& filename);
 	Image(Image* image, const uint x, const uint y, const uint w, const uint h);
+	Image(const ImageView& view);
 	~Image();
 
+	ImageView GetView() const { return ImageView(mPixelData, mWidth, mHeight, GetPixelSize(mFormat)*mWidth, mFormat); }
+	ImageView GetView(uint x, uint y, uint w, uint h) const { return GetView().GetView(x, y, w, h); }
+
+	// Pixel operations need BGRA8, so convert to a compact format last
 	void SetTransparentColour(uchar r, uchar g, uchar b);
+	void PremultiplyAlpha(void);
+
+	void GenerateMipmaps(uint max_levels);
+	uint GetNumLevels() const { return 1 + (uint)mMipLevels.size(); }
+	size_t GetByteSize() const;
+	ImageViewVector GetLevelViews() const;
+	static uint CountMipLevels(uint width, uint height);
+
+	PixelFormat GetFormat() const { return mFormat; }
+	PixelFormat ChooseFormat(uint max_error) const;
+	void ConvertToFormat(PixelFormat format);
 
 	uint GetWidth() const { return mWidth; };
 	uint GetHeight() const { return mHeight; };
@@ -22,6 +61,7 @@ public:
 	uchar* GetPixelData() const { return mPixelData; };
 
 private:
+	void CopyView(const ImageView& view);
 	void LoadRawRGB(const string& rgb_filename);
 	void LoadRawAlpha(const string& alpha_filename);
 	void LoadFile(const string& filename);
@@ -30,6 +70,8 @@ private:
 	uint mHeight;
 	uint mNumPixels;
 	uchar* mPixelData;
+	PixelFormat mFormat;
+	vector<Image*> mMipLevels;
 };
 
 #endif
\ No newline at end of file
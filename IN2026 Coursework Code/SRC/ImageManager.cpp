@@ -1,22 +1,42 @@
 #include "Image.h"
 #include "ImageManager.h"
 
-Image* ImageManager::CreateImageFromFile(const string& name, const uint width, const uint height, const string& filename)
+shared_ptr<Image> ImageManager::CreateImageFromFile(const string& name, const uint width, const uint height, const string& filename)
 {
-	Image* image = new Image(width, height, filename);
-	mImageMap.insert(NamedImageMap::value_type(name, image));
-	return image;
+	return AddImage(name, new Image(width, height, filename));
 }
 
-Image* ImageManager::CreateImageFromImage(const string& name, Image* image, const uint x, const uint y, const uint w, const uint h)
+shared_ptr<Image> ImageManager::CreateImageFromImage(const string& name, Image* image, const uint x, const uint y, const uint w, const uint h)
 {
-	Image* new_image = new Image(image, x, y, w, h);
-	mImageMap.insert(NamedImageMap::value_type(name, new_image));
-	return new_image;
+	return AddImage(name, new Image(image, x, y, w, h));
 }
 
-Image* ImageManager::GetImageByName(const string& name)
+/** Take ownership of an image created elsewhere, e.g. on a loader thread. */
+shared_ptr<Image> ImageManager::AddImage(const string& name, Image* image)
+{
+	shared_ptr<Image> shared_image(image);
+	mImageMap.insert(NamedImageMap::value_type(name, shared_image));
+	return shared_image;
+}
+
+shared_ptr<Image> ImageManager::GetImageByName(const string& name)
 {
 	NamedImageMap::iterator it = mImageMap.find(name);
-	return (it != mImageMap.end()) ? it->second : 0;
+	return (it != mImageMap.end()) ? it->second : shared_ptr<Image>();
+}
+
+/** Drop the manager's reference to an image. It is freed once nothing else, such as a texture, holds it. */
+void ImageManager::ReleaseImage(const string& name)
+{
+	mImageMap.erase(name);
+}
+
+/** Bytes of pixel data held by all the images the manager references. */
+size_t ImageManager::GetImageBytes() const
+{
+	size_t bytes = 0;
+	for (NamedImageMap::const_iterator it = mImageMap.begin(); it != mImageMap.end(); ++it) {
+		bytes += it->second->GetByteSize();
+	}
+	return bytes;
 }
\ No newline at end of file
@@ -14,15 +14,20 @@ public:
 		return mInstance;
 	}
 
-	Image* CreateImageFromFile(const string& name, const uint width, const uint height, const string& filename);
-	Image* CreateImageFromImage(const string& name, Image* image, const uint x, const uint y, const uint w, const uint h);
-	Image* GetImageByName(const string& name);
+	shared_ptr<Image> CreateImageFromFile(const string& name, const uint width, const uint height, const string& filename);
+	shared_ptr<Image> CreateImageFromImage(const string& name, Image* image, const uint x, const uint y, const uint w, const uint h);
+	shared_ptr<Image> GetImageByName(const string& name);
+	shared_ptr<Image> AddImage(const string& name, Image* image);
+	void ReleaseImage(const string& name);
+
+	uint GetImageCount() const { return (uint)mImageMap.size(); }
+	size_t GetImageBytes() const;
 
 private:
 	ImageManager() {} // Private constructor
 	~ImageManager() {} // Private destructor
 	
-	typedef map< string, Image* > NamedImageMap;
+	typedef map< string, shared_ptr<Image> > NamedImageMap;
 	NamedImageMap mImageMap;
 };
 
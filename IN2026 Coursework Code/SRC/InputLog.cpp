@@ -0,0 +1,101 @@
+#include <string.h>
+#include "InputLog.h"
+
+const char InputLog::MAGIC[4] = { 'I', 'L', 'O', 'G' };
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+InputLog::InputLog()
+{
+	memset(&mHeader, 0, sizeof(mHeader));
+}
+
+/** Destructor. */
+InputLog::~InputLog()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Read a log written by InputRecorder. A log cut short, e.g. by a crash, keeps every event it has. */
+bool InputLog::Load(const string& filename)
+{
+	mEvents.clear();
+	ifstream file(filename.c_str(), ios::in | ios::binary);
+	if (!file) { cerr << "Error opening " << filename << endl; return false; }
+	if (!file.read((char*)&mHeader, sizeof(mHeader)) || 0 != memcmp(mHeader.magic, MAGIC, sizeof(mHeader.magic)) || mHeader.version != VERSION) {
+		cerr << "Invalid input log " << filename << endl;
+		return false;
+	}
+
+	uint step = 0;
+	for (;;) {
+		InputEvent event;
+		uint step_delta, key = 0, width = 0, height = 0;
+		int type;
+		if (!ReadVarint(file, step_delta) || (type = file.get()) == EOF) break;
+		event.type = (uint)type;
+		if (event.type == INPUT_WORLD_RESIZED) {
+			if (!ReadVarint(file, width) || !ReadVarint(file, height)) break;
+		} else if (event.type < INPUT_EVENT_TYPE_COUNT) {
+			if (!ReadVarint(file, key)) break;
+		} else {
+			cerr << "Unknown event in input log " << filename << endl;
+			return false;
+		}
+		step += step_delta;
+		event.step = step;
+		event.key = (int)key;
+		event.width = (int)width;
+		event.height = (int)height;
+		mEvents.push_back(event);
+	}
+	// The end is only brought up to date now and then, so never stop before the last event
+	if (!mEvents.empty()) mHeader.end_step = max(mHeader.end_step, mEvents.back().step);
+	return true;
+}
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+void InputLog::WriteHeader(ostream& stream, const InputLogHeader& header)
+{
+	stream.write((const char*)&header, sizeof(header));
+}
+
+/** Append an event, given the step of the event written before it. */
+void InputLog::WriteEvent(ostream& stream, const InputEvent& event, uint previous_step)
+{
+	WriteVarint(stream, event.step - previous_step);
+	stream.put((char)event.type);
+	if (event.type == INPUT_WORLD_RESIZED) {
+		WriteVarint(stream, (uint)event.width);
+		WriteVarint(stream, (uint)event.height);
+	} else {
+		WriteVarint(stream, (uint)event.key);
+	}
+}
+
+// PRIVATE STATIC METHODS /////////////////////////////////////////////////////
+
+/** Seven bits per byte, lowest first, with the top bit set on all but the last. */
+void InputLog::WriteVarint(ostream& stream, uint value)
+{
+	while (value >= 0x80) {
+		stream.put((char)(value | 0x80));
+		value >>= 7;
+	}
+	stream.put((char)value);
+}
+
+bool InputLog::ReadVarint(istream& stream, uint& value)
+{
+	value = 0;
+	for (uint shift = 0; shift < 35; shift += 7) {
+		int byte = stream.get();
+		if (byte == EOF) return false;
+		value |= (uint)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) return true;
+	}
+	return false;
+}
\ No newline at end of file
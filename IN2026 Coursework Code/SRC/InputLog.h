@@ -0,0 +1,71 @@
+#ifndef __INPUTLOG_H__
+#define __INPUTLOG_H__
+
+#include <vector>
+#include "GameUtil.h"
+
+enum InputEventType
+{
+	INPUT_KEY_PRESSED,
+	INPUT_KEY_RELEASED,
+	INPUT_SPECIAL_KEY_PRESSED,
+	INPUT_SPECIAL_KEY_RELEASED,
+	INPUT_WORLD_RESIZED,
+	INPUT_EVENT_TYPE_COUNT
+};
+
+// Something from outside the game that changes what happens in it, arriving
+// once step simulation steps had been run. Keys use key; a resized world uses
+// width and height.
+struct InputEvent
+{
+	uint step;
+	uint type;
+	int key;
+	int width;
+	int height;
+};
+
+typedef vector<InputEvent> InputEventVector;
+
+// Start of an input log file. Everything needed to play the session again
+// is the seed, the world's starting size and the events that follow.
+struct InputLogHeader
+{
+	char magic[4];
+	uint version;
+	uint seed;
+	uint end_step;
+	int world_width;
+	int world_height;
+};
+
+// A recorded session. After the header, each event is stored as the number
+// of steps since the event before and its values as variable length
+// integers, so a key press usually takes three bytes.
+class InputLog
+{
+public:
+	static const char MAGIC[4];
+	static const uint VERSION = 1;
+
+	InputLog();
+	~InputLog();
+
+	bool Load(const string& filename);
+
+	const InputLogHeader& GetHeader() const { return mHeader; }
+	const InputEventVector& GetEvents() const { return mEvents; }
+
+	static void WriteHeader(ostream& stream, const InputLogHeader& header);
+	static void WriteEvent(ostream& stream, const InputEvent& event, uint previous_step);
+
+private:
+	static void WriteVarint(ostream& stream, uint value);
+	static bool ReadVarint(istream& stream, uint& value);
+
+	InputLogHeader mHeader;
+	InputEventVector mEvents;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include <stddef.h>
+#include <string.h>
+#include "GameWorld.h"
+#include "InputRecorder.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Construct a recorder for the given world, which supplies the steps and the seed. */
+InputRecorder::InputRecorder(GameWorld* world)
+	: mWorld(world),
+	  mLastStep(0)
+{
+	memset(&mHeader, 0, sizeof(mHeader));
+}
+
+/** Destructor. */
+InputRecorder::~InputRecorder()
+{
+	Close();
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Start a new log, taking the seed and size of the world as they are now. */
+bool InputRecorder::Open(const string& filename)
+{
+	Close();
+	mFile.open(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!mFile) { cerr << "Error opening " << filename << endl; return false; }
+	memcpy(mHeader.magic, InputLog::MAGIC, sizeof(mHeader.magic));
+	mHeader.version = InputLog::VERSION;
+	mHeader.seed = mWorld->GetSeed();
+	mHeader.end_step = mWorld->GetClock().GetStepCount();
+	mHeader.world_width = mWorld->GetWidth();
+	mHeader.world_height = mWorld->GetHeight();
+	mLastStep = mHeader.end_step;
+	InputLog::WriteHeader(mFile, mHeader);
+	mFile.flush();
+	return true;
+}
+
+/** Save where the session ended and close the log. */
+void InputRecorder::Close(void)
+{
+	if (!IsOpen()) return;
+	SaveEndStep(mWorld->GetClock().GetStepCount());
+	mFile.close();
+}
+
+// PUBLIC INSTANCE METHODS IMPLEMENTING IGameWorldListener ////////////////////
+
+void InputRecorder::OnWorldUpdated(GameWorld* world)
+{
+	if (!IsOpen()) return;
+	// The step being run has not been counted yet
+	uint step = world->GetClock().GetStepCount();
+	// The window can only be resized between steps, so the new size applied from this one on
+	if (world->GetWidth() != mHeader.world_width || world->GetHeight() != mHeader.world_height) {
+		InputEvent event;
+		memset(&event, 0, sizeof(event));
+		event.type = INPUT_WORLD_RESIZED;
+		event.width = mHeader.world_width = world->GetWidth();
+		event.height = mHeader.world_height = world->GetHeight();
+		event.step = step;
+		Record(event);
+	}
+	if (step + 1 - mHeader.end_step >= END_STEP_INTERVAL) SaveEndStep(step + 1);
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+void InputRecorder::RecordKey(InputEventType type, int key)
+{
+	if (!IsOpen()) return;
+	InputEvent event;
+	memset(&event, 0, sizeof(event));
+	event.type = type;
+	event.key = key;
+	event.step = mWorld->GetClock().GetStepCount();
+	Record(event);
+}
+
+void InputRecorder::Record(InputEvent& event)
+{
+	InputLog::WriteEvent(mFile, event, mLastStep);
+	mLastStep = event.step;
+	mFile.flush();
+}
+
+/** Rewrite the end step in the header, leaving the file positioned to append the next event. */
+void InputRecorder::SaveEndStep(uint step)
+{
+	mHeader.end_step = step;
+	mFile.seekp(offsetof(InputLogHeader, end_step));
+	mFile.write((const char*)&mHeader.end_step, sizeof(mHeader.end_step));
+	mFile.seekp(0, ios::end);
+	mFile.flush();
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef __INPUTRECORDER_H__
+#define __INPUTRECORDER_H__
+
+#include "GameUtil.h"
+#include "IKeyboardListener.h"
+#include "IGameWorldListener.h"
+#include "InputLog.h"
+
+class GameWorld;
+
+// Writes the keys the game receives and changes to the world's size to an
+// InputLog as they happen, each marked with the step it arrived after. It
+// must be listening to both the window and the world. Events are flushed as
+// they are written and the end of the session is saved every second of game
+// time, so little is lost however the game exits.
+class InputRecorder : public IKeyboardListener, public IGameWorldListener
+{
+public:
+	static const uint END_STEP_INTERVAL = 100;
+
+	InputRecorder(GameWorld* world);
+	virtual ~InputRecorder();
+
+	bool Open(const string& filename);
+	void Close(void);
+	bool IsOpen() const { return mFile.is_open(); }
+
+	// Declaration of IKeyboardListener interface ////////////////////////////////
+
+	void OnKeyPressed(uchar key, int x, int y) { RecordKey(INPUT_KEY_PRESSED, key); }
+	void OnKeyReleased(uchar key, int x, int y) { RecordKey(INPUT_KEY_RELEASED, key); }
+	void OnSpecialKeyPressed(int key, int x, int y) { RecordKey(INPUT_SPECIAL_KEY_PRESSED, key); }
+	void OnSpecialKeyReleased(int key, int x, int y) { RecordKey(INPUT_SPECIAL_KEY_RELEASED, key); }
+
+	// Declaration of IGameWorldListener interface //////////////////////////////
+
+	void OnWorldUpdated(GameWorld* world);
+	void OnObjectAdded(GameWorld* world, shared_ptr<GameObject> object) {}
+	void OnObjectRemoved(GameWorld* world, shared_ptr<GameObject> object) {}
+
+private:
+	void RecordKey(InputEventType type, int key);
+	void Record(InputEvent& event);
+	void SaveEndStep(uint step);
+
+	GameWorld* mWorld;
+	ofstream mFile;
+	InputLogHeader mHeader;
+	// Step of the last event written, as events store the steps between them
+	uint mLastStep;
+};
+
+#endif
\ No newline at end of file
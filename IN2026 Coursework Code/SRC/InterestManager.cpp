@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "InterestManager.h"
+#include "NetProtocol.h"
+
+// Given to a client's own object, so it is always sent first
+static const float FOCUS_PRIORITY = 1e30f;
+// Roughly what the id of an object sent as it was, and the start of a new object, add to a delta
+static const uint KEPT_OBJECT_BYTES = 2;
+
+static bool CompareId(const NetObjectState& object, uint id) { return object.id < id; }
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor, sending everything until a view radius or byte budget is set. */
+InterestManager::InterestManager()
+	: mViewRadius(0),
+	  mByteBudget(0)
+{
+}
+
+/** Destructor. */
+InterestManager::~InterestManager()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Index where the objects in a snapshot are, before choosing what to send each client from it. */
+void InterestManager::Index(const NetSnapshot& snapshot)
+{
+	if (mViewRadius <= 0) return;
+	mPoints.resize(snapshot.objects.size());
+	for (uint i = 0; i < mPoints.size(); i++) {
+		mPoints[i].x = (float)snapshot.objects[i].position[0] / NetSnapshot::POSITION_SCALE;
+		mPoints[i].y = (float)snapshot.objects[i].position[1] / NetSnapshot::POSITION_SCALE;
+	}
+	mGrid.Build(snapshot.header.width, snapshot.header.height, (float)CELL_SIZE, mPoints);
+}
+
+/** Choose what of the indexed snapshot to send a client whose last acknowledged snapshot is base.
+	The byte budget is met by an estimate that errs on the large side, as the encoded size is only
+	known once the snapshot has been compressed. */
+void InterestManager::Select(ClientInterest& client, const NetSnapshot& snapshot, const NetSnapshot* base, NetSnapshot& selected)
+{
+	const vector<NetObjectState>& objects = snapshot.objects;
+	vector<NetObjectState>::const_iterator focus = lower_bound(objects.begin(), objects.end(), client.focus_id, CompareId);
+	if (focus != objects.end() && focus->id == client.focus_id) {
+		client.focus.x = (float)focus->position[0] / NetSnapshot::POSITION_SCALE;
+		client.focus.y = (float)focus->position[1] / NetSnapshot::POSITION_SCALE;
+	}
+
+	mRelevant.clear();
+	if (mViewRadius > 0) {
+		mGrid.Query(client.focus.x, client.focus.y, mViewRadius, mRelevant);
+		sort(mRelevant.begin(), mRelevant.end());
+	} else {
+		mRelevant.resize(objects.size());
+		for (uint i = 0; i < objects.size(); i++) mRelevant[i] = i;
+	}
+
+	// The relevant objects, the base and the priorities are all in id order, so they are matched in one pass
+	uint estimate = sizeof(NetMessageHeader) + sizeof(NetSnapshotHeader) + (uint)snapshot.values.size() * sizeof(SnapshotValue);
+	size_t base_count = base ? base->objects.size() : 0;
+	size_t b = 0, p = 0;
+	mBaseStates.resize(mRelevant.size());
+	mUpdated.assign(mRelevant.size(), false);
+	mPriorities.resize(mRelevant.size());
+	mCandidates.clear();
+	for (uint r = 0; r < mRelevant.size(); r++) {
+		const NetObjectState& object = objects[mRelevant[r]];
+		while (b < base_count && base->objects[b].id < object.id) b++;
+		const NetObjectState* base_state = (b < base_count && base->objects[b].id == object.id) ? &base->objects[b] : NULL;
+		while (p < client.priorities.size() && client.priorities[p].id < object.id) p++;
+		float priority = (p < client.priorities.size() && client.priorities[p].id == object.id) ? client.priorities[p].priority : 0;
+		mBaseStates[r] = base_state;
+		mPriorities[r].id = object.id;
+		mPriorities[r].priority = 0;
+		if (base_state) estimate += KEPT_OBJECT_BYTES;
+		// The client already has it as it is
+		if (base_state && 0 == memcmp(base_state, &object, sizeof(object))) {
+			mUpdated[r] = true;
+			continue;
+		}
+		// Nearer and faster objects go wrong on the client sooner
+		float nearness = 1;
+		if (mViewRadius > 0) {
+			GLfloat distance = mGrid.GetDistance(client.focus.x, client.focus.y, mPoints[mRelevant[r]].x, mPoints[mRelevant[r]].y);
+			nearness = max(1 - distance / mViewRadius, 0.0f);
+		}
+		float speed = sqrt((float)object.velocity[0] * object.velocity[0] + (float)object.velocity[1] * object.velocity[1]) / NetSnapshot::POSITION_SCALE;
+		priority += 1 + NEAR_PRIORITY * nearness + speed / SPEED_PRIORITY_DIVISOR;
+		if (object.id == client.focus_id) priority = FOCUS_PRIORITY;
+		mPriorities[r].priority = priority;
+		InterestCandidate candidate = { r, base_state, priority };
+		mCandidates.push_back(candidate);
+	}
+
+	// Update the objects owed the most, as long as they fit
+	stable_sort(mCandidates.begin(), mCandidates.end());
+	for (uint i = 0; i < mCandidates.size(); i++) {
+		uint cost = sizeof(NetObjectState) + (mCandidates[i].base ? 0 : KEPT_OBJECT_BYTES);
+		if (mByteBudget > 0 && estimate + cost > mByteBudget) continue;
+		estimate += cost;
+		mUpdated[mCandidates[i].index] = true;
+		mPriorities[mCandidates[i].index].priority = 0;
+	}
+
+	selected.header = snapshot.header;
+	selected.values = snapshot.values;
+	selected.objects.clear();
+	for (uint r = 0; r < mRelevant.size(); r++) {
+		if (mUpdated[r]) selected.objects.push_back(objects[mRelevant[r]]);
+		else if (mBaseStates[r]) selected.objects.push_back(*mBaseStates[r]);
+	}
+	client.priorities.swap(mPriorities);
+}
\ No newline at end of file
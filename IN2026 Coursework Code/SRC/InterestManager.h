@@ -0,0 +1,73 @@
+#ifndef __INTERESTMANAGER_H__
+#define __INTERESTMANAGER_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "NetSnapshot.h"
+#include "SpatialGrid.h"
+
+// How much an object is owed an update to one client
+struct InterestPriority
+{
+	uint id;
+	float priority;
+};
+
+// What interest management keeps for each client between snapshots
+struct ClientInterest
+{
+	// The object the client sees the world from, usually its ship, and
+	// where it was last seen, which is kept while the client has no ship
+	uint focus_id;
+	GLVector2f focus;
+	// Sorted by id, for the objects that were relevant last time
+	vector<InterestPriority> priorities;
+};
+
+// Decides what each client is sent. Only objects within the view radius of
+// the client's focus are relevant to it. Those that have changed since the
+// client's base snapshot build up priority by how near and how fast they
+// are, and the most owed are updated for as many as fit in the byte budget.
+// The rest are sent as the client last had them, which costs next to nothing
+// as a delta, so nothing disappears while it waits for an update.
+class InterestManager
+{
+public:
+	static const uint CELL_SIZE = 64;
+	// Priority gained in each snapshot by an object at the focus, and for each unit a second of speed
+	static const uint NEAR_PRIORITY = 4;
+	static const uint SPEED_PRIORITY_DIVISOR = 25;
+
+	InterestManager();
+	~InterestManager();
+
+	void SetViewRadius(float radius) { mViewRadius = radius; }
+	float GetViewRadius() const { return mViewRadius; }
+	void SetByteBudget(uint bytes) { mByteBudget = bytes; }
+	uint GetByteBudget() const { return mByteBudget; }
+
+	void Index(const NetSnapshot& snapshot);
+	void Select(ClientInterest& client, const NetSnapshot& snapshot, const NetSnapshot* base, NetSnapshot& selected);
+
+private:
+	// A relevant object that has changed since the client's base
+	struct InterestCandidate
+	{
+		uint index;
+		const NetObjectState* base;
+		float priority;
+		bool operator<(const InterestCandidate& o) const { return priority > o.priority; }
+	};
+
+	float mViewRadius;
+	uint mByteBudget;
+	SpatialGrid mGrid;
+	vector<GLVector2f> mPoints;
+	vector<uint> mRelevant;
+	vector<const NetObjectState*> mBaseStates;
+	vector<InterestCandidate> mCandidates;
+	vector<bool> mUpdated;
+	vector<InterestPriority> mPriorities;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include <string.h>
+#include "GameWorld.h"
+#include "NetClient.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Construct a client that shows what it is sent in the given world. */
+NetClient::NetClient(GameWorld* world)
+	: mWorld(world),
+	  mClientId(0),
+	  mPlayerObjectId(0),
+	  mSendRate(20),
+	  mLastConnectTime(0),
+	  mLastHeard(0),
+	  mLastSendTime(0),
+	  mLastReportTime(0),
+	  mInputChanged(false),
+	  mLatestSequence(0),
+	  mBytesSent(0),
+	  mBytesReceived(0),
+	  mSnapshotsReceived(0),
+	  mSnapshotsDropped(0),
+	  mTotalBytesSent(0),
+	  mTotalBytesReceived(0),
+	  mBuffer(UdpSocket::MAX_PACKET_SIZE)
+{
+	memset(&mServer, 0, sizeof(mServer));
+	memset(&mInput, 0, sizeof(mInput));
+}
+
+/** Destructor. */
+NetClient::~NetClient()
+{
+	Close();
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Open a socket and start asking the server to let us join. */
+bool NetClient::Connect(const NetAddress& server)
+{
+	if (!mSocket.Open(0)) return false;
+	mServer = server;
+	mClientId = 0;
+	// Ask straight away on the next update
+	mLastConnectTime = mWorld->GetClock().GetTime() - CONNECT_RETRY_MILLIS;
+	mLastReportTime = mWorld->GetClock().GetTime();
+	cout << "Connecting to " << UdpSocket::FormatAddress(server) << endl;
+	return true;
+}
+
+/** Tell the server we are leaving, report what was sent and close the socket. */
+void NetClient::Close(void)
+{
+	if (!mSocket.IsOpen()) return;
+	if (IsConnected()) {
+		NetProtocol::WriteHeader(mPacket, NET_MESSAGE_DISCONNECT);
+		mSocket.Send(mServer, mPacket.data(), (uint)mPacket.size());
+	}
+	cout << "Sent " << mTotalBytesSent << " bytes, received " << mTotalBytesReceived << " bytes" << endl;
+	mSocket.Close();
+	mClientId = 0;
+}
+
+/** Set which of the NetInputButtons are held down. */
+void NetClient::SetButtons(uint buttons)
+{
+	if (buttons == mInput.buttons) return;
+	mInput.buttons = buttons;
+	mInputChanged = true;
+}
+
+void NetClient::Shoot(void)
+{
+	mInput.shots++;
+	mInputChanged = true;
+}
+
+/** Apply snapshots that have arrived and send input when it is due. */
+void NetClient::Update(void)
+{
+	if (!mSocket.IsOpen()) return;
+	Receive();
+
+	uint now = mWorld->GetClock().GetTime();
+	if (!IsConnected()) {
+		if (now - mLastConnectTime >= CONNECT_RETRY_MILLIS) {
+			NetProtocol::WriteHeader(mPacket, NET_MESSAGE_CONNECT);
+			SendPacket(mPacket);
+			mLastConnectTime = now;
+		}
+	} else if (now - mLastHeard > TIMEOUT_MILLIS) {
+		cout << "Lost connection to server" << endl;
+		mClientId = 0;
+		mLatestSequence = 0;
+	} else if (mInputChanged || now - mLastSendTime >= 1000 / mSendRate) {
+		SendInput();
+		mLastSendTime = now;
+	}
+	mConditioner.Flush(mSocket);
+
+	if (now - mLastReportTime >= REPORT_INTERVAL_MILLIS) {
+		PrintReport(now - mLastReportTime);
+		mLastReportTime = now;
+	}
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+void NetClient::Receive(void)
+{
+	NetAddress from;
+	int size;
+	while ((size = mSocket.Receive(from, &mBuffer[0], (uint)mBuffer.size())) >= 0) {
+		NetMessageType type;
+		if (from != mServer || !NetProtocol::ReadHeader(&mBuffer[0], (uint)size, type)) continue;
+		mLastHeard = mWorld->GetClock().GetTime();
+		mBytesReceived += size + NetProtocol::PACKET_OVERHEAD;
+		mTotalBytesReceived += size + NetProtocol::PACKET_OVERHEAD;
+		const char* body = &mBuffer[sizeof(NetMessageHeader)];
+		uint body_size = (uint)size - sizeof(NetMessageHeader);
+		switch (type) {
+		case NET_MESSAGE_ACCEPT: HandleAccept(body, body_size); break;
+		case NET_MESSAGE_SNAPSHOT: HandleSnapshot(body, body_size); break;
+		case NET_MESSAGE_DISCONNECT:
+			cout << "Server closed the connection" << endl;
+			mClientId = 0;
+			mLatestSequence = 0;
+			break;
+		default: break;
+		}
+	}
+}
+
+void NetClient::HandleAccept(const char* data, uint size)
+{
+	NetAccept accept;
+	if (IsConnected() || size < sizeof(accept)) return;
+	memcpy(&accept, data, sizeof(accept));
+	mClientId = accept.client_id;
+	mSendRate = (accept.send_rate > 0) ? accept.send_rate : 1;
+	cout << "Joined as client " << mClientId << endl;
+}
+
+/** Decode a snapshot against the one it was encoded from and show it, unless a newer one has been shown. */
+void NetClient::HandleSnapshot(const char* data, uint size)
+{
+	NetSnapshotHeader header;
+	if (!IsConnected() || !NetSnapshot::ReadHeader(data, size, header) || header.sequence <= mLatestSequence) return;
+
+	const NetSnapshot* base = NULL;
+	if (header.base_sequence != 0) {
+		base = &mHistory[header.base_sequence % NetProtocol::SNAPSHOT_HISTORY];
+		if (base->header.sequence != header.base_sequence) { mSnapshotsDropped++; return; }
+	}
+	NetSnapshot decoded;
+	if (!decoded.Decode(base, data, size)) { mSnapshotsDropped++; return; }
+
+	NetSnapshot& snapshot = mHistory[header.sequence % NetProtocol::SNAPSHOT_HISTORY];
+	snapshot.header = decoded.header;
+	snapshot.objects.swap(decoded.objects);
+	snapshot.values.swap(decoded.values);
+	mLatestSequence = header.sequence;
+	mPlayerObjectId = header.player_id;
+	mInput.snapshot_ack = header.sequence;
+	mSnapshotsReceived++;
+
+	snapshot.ToWorldSnapshot(mReplicated);
+	mWorld->ReplicateSnapshot(mReplicated);
+}
+
+void NetClient::SendInput(void)
+{
+	mInput.sequence++;
+	NetProtocol::WriteHeader(mPacket, NET_MESSAGE_INPUT);
+	mPacket.append((const char*)&mInput, sizeof(mInput));
+	SendPacket(mPacket);
+	mInputChanged = false;
+}
+
+void NetClient::SendPacket(const string& packet)
+{
+	mConditioner.Send(mSocket, mServer, packet.data(), (uint)packet.size());
+	mBytesSent += (uint)packet.size() + NetProtocol::PACKET_OVERHEAD;
+	mTotalBytesSent += (uint)packet.size() + NetProtocol::PACKET_OVERHEAD;
+}
+
+/** Print the bandwidth used since the last report, including IP and UDP headers. */
+void NetClient::PrintReport(uint interval_millis)
+{
+	if (interval_millis == 0) return;
+	cout << "Client " << mClientId << ": " << mBytesReceived / (double)interval_millis << " kB/s in, "
+		<< mBytesSent / (double)interval_millis << " kB/s out, " << mSnapshotsReceived << " snapshots, "
+		<< mSnapshotsDropped << " without their base" << endl;
+	mBytesSent = 0;
+	mBytesReceived = 0;
+	mSnapshotsReceived = 0;
+	mSnapshotsDropped = 0;
+}
\ No newline at end of file
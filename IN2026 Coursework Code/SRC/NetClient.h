@@ -0,0 +1,86 @@
+#ifndef __NETCLIENT_H__
+#define __NETCLIENT_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "IGameWorldListener.h"
+#include "NetProtocol.h"
+#include "NetSnapshot.h"
+#include "NetworkConditioner.h"
+#include "UdpSocket.h"
+#include "WorldSnapshot.h"
+
+// Shows a world run by a NetServer. Each world update it applies the newest
+// snapshot to have arrived and sends the player's input, so the world it is
+// given should be replicated rather than simulated.
+class NetClient : public IGameWorldListener
+{
+public:
+	static const uint CONNECT_RETRY_MILLIS = 500;
+	static const uint TIMEOUT_MILLIS = 5000;
+	static const uint REPORT_INTERVAL_MILLIS = 5000;
+
+	NetClient(GameWorld* world);
+	~NetClient();
+
+	bool Connect(const NetAddress& server);
+	void Close(void);
+	bool IsConnected() const { return mClientId != 0; }
+	uint GetClientId() const { return mClientId; }
+	uint GetPlayerObjectId() const { return mPlayerObjectId; }
+
+	void SetButtons(uint buttons);
+	uint GetButtons() const { return mInput.buttons; }
+	void Shoot(void);
+	NetworkConditioner& GetConditioner() { return mConditioner; }
+
+	void Update(void);
+
+	// Declaration of IGameWorldListener interface //////////////////////////////
+
+	void OnWorldUpdated(GameWorld* world) { Update(); }
+	void OnObjectAdded(GameWorld* world, shared_ptr<GameObject> object) {}
+	void OnObjectRemoved(GameWorld* world, shared_ptr<GameObject> object) {}
+
+private:
+	void Receive(void);
+	void HandleAccept(const char* data, uint size);
+	void HandleSnapshot(const char* data, uint size);
+	void SendInput(void);
+	void SendPacket(const string& packet);
+	void PrintReport(uint interval_millis);
+
+	GameWorld* mWorld;
+	UdpSocket mSocket;
+	NetworkConditioner mConditioner;
+	NetAddress mServer;
+
+	uint mClientId;
+	uint mPlayerObjectId;
+	uint mSendRate;
+	uint mLastConnectTime;
+	uint mLastHeard;
+	uint mLastSendTime;
+	uint mLastReportTime;
+
+	NetInput mInput;
+	bool mInputChanged;
+
+	uint mLatestSequence;
+	NetSnapshot mHistory[NetProtocol::SNAPSHOT_HISTORY];
+	// Snapshots are applied to the world through this, to reuse its objects
+	WorldSnapshot mReplicated;
+
+	// Since the last report and in total
+	uint mBytesSent;
+	uint mBytesReceived;
+	uint mSnapshotsReceived;
+	uint mSnapshotsDropped;
+	uint mTotalBytesSent;
+	uint mTotalBytesReceived;
+
+	vector<char> mBuffer;
+	string mPacket;
+};
+
+#endif
\ No newline at end of file
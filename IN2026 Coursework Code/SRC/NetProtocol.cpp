@@ -0,0 +1,27 @@
+#include <string.h>
+#include "NetProtocol.h"
+
+const char NetProtocol::MAGIC[3] = { 'A', 'S', 'T' };
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+/** Start a packet of the given type, replacing anything already in data. */
+void NetProtocol::WriteHeader(string& data, NetMessageType type)
+{
+	NetMessageHeader header;
+	memcpy(header.magic, MAGIC, sizeof(header.magic));
+	header.type = (uchar)type;
+	data.assign((const char*)&header, sizeof(header));
+}
+
+/** Check a packet is one of ours and find its type. Anything else on the port is ignored. */
+bool NetProtocol::ReadHeader(const char* data, uint size, NetMessageType& type)
+{
+	if (size < sizeof(NetMessageHeader)) return false;
+	NetMessageHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (0 != memcmp(header.magic, MAGIC, sizeof(header.magic))) return false;
+	if (header.type < NET_MESSAGE_CONNECT || header.type > NET_MESSAGE_PEER_INPUT) return false;
+	type = (NetMessageType)header.type;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef __NETPROTOCOL_H__
+#define __NETPROTOCOL_H__
+
+#include "GameUtil.h"
+
+// Every packet starts with a NetMessageHeader, followed by what its type
+// says. Clients send CONNECT until they are sent an ACCEPT, then INPUT at the
+// server's snapshot rate and whenever it changes. The server sends SNAPSHOT
+// at its rate. Either end sends DISCONNECT when it stops. Peers playing each
+// other directly send PEER_HELLO until they hear from each other, then
+// PEER_INPUT every frame.
+enum NetMessageType
+{
+	NET_MESSAGE_CONNECT = 1,
+	NET_MESSAGE_ACCEPT,
+	NET_MESSAGE_INPUT,
+	NET_MESSAGE_SNAPSHOT,
+	NET_MESSAGE_DISCONNECT,
+	NET_MESSAGE_PEER_HELLO,
+	NET_MESSAGE_PEER_INPUT,
+};
+
+struct NetMessageHeader
+{
+	char magic[3];
+	uchar type;
+};
+
+// Sent in reply to CONNECT
+struct NetAccept
+{
+	uint client_id;
+	uint send_rate;
+};
+
+enum NetInputButtons
+{
+	NET_INPUT_THRUST = 1,
+	NET_INPUT_LEFT = 2,
+	NET_INPUT_RIGHT = 4,
+	// Pressed since the last frame, for peers that send input for every frame
+	NET_INPUT_FIRE = 8,
+};
+
+// The whole input state rather than key events, so a lost packet is made up
+// for by the next one. Shots are counted, so none are lost either.
+struct NetInput
+{
+	uint sequence;
+	uint snapshot_ack;
+	uint buttons;
+	uint shots;
+};
+
+// Both peers must agree on these before they start, so the second player
+// takes the first player's world size and input delay
+struct NetPeerHello
+{
+	uint player;
+	uint frame;
+	uint checksum;
+	int width;
+	int height;
+	uint input_delay;
+};
+
+// Followed by count bytes of buttons, one for each frame from start_frame.
+// Every input the other peer has not acknowledged is sent again, so a lost
+// packet is made up for by the next one.
+struct NetPeerInput
+{
+	// The frame the sender is on, and the first of ours it has not had
+	uint frame;
+	uint ack_frame;
+	// How many frames the sender thinks it is ahead of us
+	int advantage;
+	// State checksum at a frame whose inputs are all known, to find desyncs
+	uint check_frame;
+	uint checksum;
+	uint start_frame;
+	uint count;
+};
+
+class NetProtocol
+{
+public:
+	static const char MAGIC[3];
+	static const unsigned short DEFAULT_PORT = 7777;
+	// Snapshots each end keeps to encode and decode deltas against
+	static const uint SNAPSHOT_HISTORY = 32;
+	// Bytes added to each packet by the IP and UDP headers
+	static const uint PACKET_OVERHEAD = 28;
+
+	static void WriteHeader(string& data, NetMessageType type);
+	static bool ReadHeader(const char* data, uint size, NetMessageType& type);
+
+private:
+	NetProtocol() {} // Not instantiated
+};
+
+#endif
\ No newline at end of file
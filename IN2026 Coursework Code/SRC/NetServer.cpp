@@ -0,0 +1,241 @@
+#include <string.h>
+#include "GameWorld.h"
+#include "NetServer.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Construct a server for the given world. It does nothing until it is opened. */
+NetServer::NetServer(GameWorld* world)
+	: mWorld(world),
+	  mNextClientId(1),
+	  mSendRate(20),
+	  mLastSendTime(0),
+	  mLastReportTime(0),
+	  mNextSequence(1),
+	  mBuffer(UdpSocket::MAX_PACKET_SIZE),
+	  mWarnedTooLarge(false)
+{
+}
+
+/** Destructor. */
+NetServer::~NetServer()
+{
+	Close();
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+bool NetServer::Open(unsigned short port)
+{
+	if (!mSocket.Open(port)) return false;
+	mLastSendTime = mWorld->GetClock().GetTime();
+	mLastReportTime = mLastSendTime;
+	cout << "Server listening on port " << mSocket.GetPort() << ", sending " << mSendRate << " snapshots a second" << endl;
+	return true;
+}
+
+/** Tell every client the server is going, report what was sent and close the socket. */
+void NetServer::Close(void)
+{
+	if (!mSocket.IsOpen()) return;
+	while (!mClients.empty()) Disconnect((uint)mClients.size() - 1, true);
+	mSocket.Close();
+}
+
+void NetServer::SetSendRate(uint snapshots_per_second)
+{
+	mSendRate = (snapshots_per_second > 0) ? snapshots_per_second : 1;
+}
+
+/** Set the object a client controls, which its snapshots tell it about. */
+void NetServer::SetPlayerObjectId(uint client_id, uint object_id)
+{
+	for (uint i = 0; i < mClients.size(); i++) {
+		if (mClients[i].id == client_id) mClients[i].player_id = mClients[i].interest.focus_id = object_id;
+	}
+}
+
+/** Read from clients, drop those not heard from for a while, and send snapshots when they are due. */
+void NetServer::Update(void)
+{
+	if (!mSocket.IsOpen()) return;
+	Receive();
+
+	uint now = mWorld->GetClock().GetTime();
+	for (uint i = (uint)mClients.size(); i-- > 0;) {
+		if (now - mClients[i].last_heard > TIMEOUT_MILLIS) {
+			cout << "Client " << mClients[i].id << " timed out" << endl;
+			Disconnect(i, false);
+		}
+	}
+
+	uint interval = 1000 / mSendRate;
+	if (now - mLastSendTime >= interval) {
+		SendSnapshots();
+		// Keep to the rate on average, but never send a burst to catch up
+		mLastSendTime = (now - mLastSendTime >= 2 * interval) ? now : mLastSendTime + interval;
+	}
+	mConditioner.Flush(mSocket);
+
+	if (now - mLastReportTime >= REPORT_INTERVAL_MILLIS) {
+		PrintReport(now - mLastReportTime);
+		mLastReportTime = now;
+	}
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+void NetServer::Receive(void)
+{
+	NetAddress from;
+	int size;
+	while ((size = mSocket.Receive(from, &mBuffer[0], (uint)mBuffer.size())) >= 0) {
+		NetMessageType type;
+		if (!NetProtocol::ReadHeader(&mBuffer[0], (uint)size, type)) continue;
+		if (type == NET_MESSAGE_CONNECT) {
+			HandleConnect(from);
+			continue;
+		}
+		NetConnection* client = FindClient(from);
+		if (client == NULL) continue;
+		client->last_heard = mWorld->GetClock().GetTime();
+		client->bytes_received += size + NetProtocol::PACKET_OVERHEAD;
+		client->total_bytes_received += size + NetProtocol::PACKET_OVERHEAD;
+		if (type == NET_MESSAGE_INPUT) {
+			HandleInput(*client, &mBuffer[sizeof(NetMessageHeader)], (uint)size - sizeof(NetMessageHeader));
+		} else if (type == NET_MESSAGE_DISCONNECT) {
+			cout << "Client " << client->id << " left" << endl;
+			Disconnect((uint)(client - &mClients[0]), false);
+		}
+	}
+}
+
+/** Accept a new client, or accept one again whose accept was lost. */
+void NetServer::HandleConnect(const NetAddress& from)
+{
+	NetConnection* client = FindClient(from);
+	if (client == NULL) {
+		if (mClients.size() >= MAX_CLIENTS) return;
+		NetConnection connection = NetConnection();
+		connection.id = mNextClientId++;
+		connection.address = from;
+		connection.history.resize(NetProtocol::SNAPSHOT_HISTORY);
+		mClients.push_back(connection);
+		client = &mClients.back();
+		cout << "Client " << client->id << " connected from " << UdpSocket::FormatAddress(from) << endl;
+		uint id = client->id;
+		for (NetServerListenerList::iterator it = mListeners.begin(); it != mListeners.end(); ++it) {
+			(*it)->OnClientConnected(this, id);
+		}
+		client = FindClient(from);
+	}
+	client->last_heard = mWorld->GetClock().GetTime();
+
+	NetAccept accept;
+	accept.client_id = client->id;
+	accept.send_rate = mSendRate;
+	NetProtocol::WriteHeader(mPacket, NET_MESSAGE_ACCEPT);
+	mPacket.append((const char*)&accept, sizeof(accept));
+	SendPacket(*client, mPacket);
+}
+
+void NetServer::HandleInput(NetConnection& client, const char* data, uint size)
+{
+	NetInput input;
+	if (size < sizeof(input)) return;
+	memcpy(&input, data, sizeof(input));
+	// Acknowledgements can only be for snapshots that have been sent
+	if (input.snapshot_ack > client.acked_sequence && input.snapshot_ack < mNextSequence) client.acked_sequence = input.snapshot_ack;
+	// Inputs arriving late or twice are older than what the client has already sent
+	if (input.sequence <= client.input_sequence) return;
+	client.input_sequence = input.sequence;
+	uint id = client.id;
+	for (NetServerListenerList::iterator it = mListeners.begin(); it != mListeners.end(); ++it) {
+		(*it)->OnClientInput(this, id, input);
+	}
+}
+
+/** Drop a client, telling it so if notify is set, and report what it was sent. */
+void NetServer::Disconnect(uint index, bool notify)
+{
+	NetConnection client = mClients[index];
+	if (notify) {
+		NetProtocol::WriteHeader(mPacket, NET_MESSAGE_DISCONNECT);
+		mSocket.Send(client.address, mPacket.data(), (uint)mPacket.size());
+	}
+	mClients.erase(mClients.begin() + index);
+	cout << "Client " << client.id << " sent " << client.total_bytes_sent << " bytes, received "
+		<< client.total_bytes_received << " bytes" << endl;
+	for (NetServerListenerList::iterator it = mListeners.begin(); it != mListeners.end(); ++it) {
+		(*it)->OnClientDisconnected(this, client.id);
+	}
+}
+
+/** Take and quantize one snapshot of the world, then send it to each client
+	as changes from the last one it acknowledged, or whole if that is too old. */
+void NetServer::SendSnapshots(void)
+{
+	if (mClients.empty()) return;
+	uint sequence = mNextSequence++;
+	mWorld->TakeSnapshot(mWorldSnapshot);
+	mSnapshot.FromWorldSnapshot(mWorldSnapshot);
+	mSnapshot.header.sequence = sequence;
+	mInterest.Index(mSnapshot);
+
+	for (uint i = 0; i < mClients.size(); i++) {
+		NetConnection& client = mClients[i];
+		const NetSnapshot* base = NULL;
+		uint acked = client.acked_sequence;
+		if (acked != 0 && sequence - acked < NetProtocol::SNAPSHOT_HISTORY) {
+			const NetSnapshot& acked_snapshot = client.history[acked % NetProtocol::SNAPSHOT_HISTORY];
+			if (acked_snapshot.header.sequence == acked) base = &acked_snapshot;
+		}
+		NetSnapshot& snapshot = client.history[sequence % NetProtocol::SNAPSHOT_HISTORY];
+		mInterest.Select(client.interest, mSnapshot, base, snapshot);
+		snapshot.header.player_id = client.player_id;
+		NetProtocol::WriteHeader(mPacket, NET_MESSAGE_SNAPSHOT);
+		snapshot.Encode(base, mPacket);
+		if (mPacket.size() > UdpSocket::MAX_PACKET_SIZE) {
+			if (!mWarnedTooLarge) cerr << "Snapshot of " << mPacket.size() << " bytes is too large to send" << endl;
+			mWarnedTooLarge = true;
+			continue;
+		}
+		client.snapshots_sent++;
+		client.snapshot_bytes += (uint)mPacket.size();
+		SendPacket(client, mPacket);
+	}
+}
+
+void NetServer::SendPacket(NetConnection& client, const string& packet)
+{
+	mConditioner.Send(mSocket, client.address, packet.data(), (uint)packet.size());
+	client.bytes_sent += (uint)packet.size() + NetProtocol::PACKET_OVERHEAD;
+	client.total_bytes_sent += (uint)packet.size() + NetProtocol::PACKET_OVERHEAD;
+}
+
+/** Print the bandwidth used by each client since the last report, including IP and UDP headers. */
+void NetServer::PrintReport(uint interval_millis)
+{
+	if (interval_millis == 0) return;
+	for (uint i = 0; i < mClients.size(); i++) {
+		NetConnection& client = mClients[i];
+		cout << "Client " << client.id << ": " << client.bytes_sent / (double)interval_millis << " kB/s out, "
+			<< client.bytes_received / (double)interval_millis << " kB/s in, "
+			<< client.snapshots_sent << " snapshots averaging "
+			<< (client.snapshots_sent ? client.snapshot_bytes / client.snapshots_sent : 0) << " bytes, "
+			<< mNextSequence - 1 - client.acked_sequence << " behind" << endl;
+		client.bytes_sent = 0;
+		client.bytes_received = 0;
+		client.snapshots_sent = 0;
+		client.snapshot_bytes = 0;
+	}
+	if (mConditioner.IsEnabled()) cout << "Dropped " << mConditioner.GetDroppedCount() << " packets to clients" << endl;
+}
+
+NetServer::NetConnection* NetServer::FindClient(const NetAddress& address)
+{
+	for (uint i = 0; i < mClients.size(); i++) {
+		if (mClients[i].address == address) return &mClients[i];
+	}
+	return NULL;
+}
\ No newline at end of file
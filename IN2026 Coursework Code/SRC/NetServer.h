@@ -0,0 +1,105 @@
+#ifndef __NETSERVER_H__
+#define __NETSERVER_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "IGameWorldListener.h"
+#include "INetServerListener.h"
+#include "InterestManager.h"
+#include "NetProtocol.h"
+#include "NetSnapshot.h"
+#include "NetworkConditioner.h"
+#include "UdpSocket.h"
+#include "WorldSnapshot.h"
+
+// Runs a world for clients on other machines. Each world update it reads
+// what clients have sent, and at the send rate it sends each of them a
+// snapshot of the world as changes from the last one they acknowledged.
+// Interest management picks what each client is sent, which by default is
+// everything; with a view radius or byte budget each client gets its own.
+// Listeners decide what connecting, input and leaving mean for the game.
+class NetServer : public IGameWorldListener
+{
+public:
+	static const uint MAX_CLIENTS = 16;
+	static const uint TIMEOUT_MILLIS = 5000;
+	static const uint REPORT_INTERVAL_MILLIS = 5000;
+
+	NetServer(GameWorld* world);
+	~NetServer();
+
+	bool Open(unsigned short port);
+	void Close(void);
+	bool IsOpen() const { return mSocket.IsOpen(); }
+
+	void SetSendRate(uint snapshots_per_second);
+	uint GetSendRate() const { return mSendRate; }
+	NetworkConditioner& GetConditioner() { return mConditioner; }
+	InterestManager& GetInterest() { return mInterest; }
+
+	void AddListener(INetServerListener* listener) { mListeners.push_back(listener); }
+	void SetPlayerObjectId(uint client_id, uint object_id);
+
+	void Update(void);
+
+	// Declaration of IGameWorldListener interface //////////////////////////////
+
+	void OnWorldUpdated(GameWorld* world) { Update(); }
+	void OnObjectAdded(GameWorld* world, shared_ptr<GameObject> object) {}
+	void OnObjectRemoved(GameWorld* world, shared_ptr<GameObject> object) {}
+
+private:
+	struct NetConnection
+	{
+		uint id;
+		NetAddress address;
+		uint last_heard;
+		uint player_id;
+		uint acked_sequence;
+		uint input_sequence;
+		// Since the last report
+		uint bytes_sent;
+		uint bytes_received;
+		uint snapshots_sent;
+		uint snapshot_bytes;
+		// Since connecting
+		uint total_bytes_sent;
+		uint total_bytes_received;
+		// What the client has been sent, by sequence, as each is chosen for it
+		ClientInterest interest;
+		vector<NetSnapshot> history;
+	};
+	typedef vector<NetConnection> NetConnectionVector;
+	typedef list<INetServerListener*> NetServerListenerList;
+
+	void Receive(void);
+	void HandleConnect(const NetAddress& from);
+	void HandleInput(NetConnection& client, const char* data, uint size);
+	void Disconnect(uint index, bool notify);
+	void SendSnapshots(void);
+	void SendPacket(NetConnection& client, const string& packet);
+	void PrintReport(uint interval_millis);
+	NetConnection* FindClient(const NetAddress& address);
+
+	GameWorld* mWorld;
+	UdpSocket mSocket;
+	NetworkConditioner mConditioner;
+	NetServerListenerList mListeners;
+	NetConnectionVector mClients;
+	uint mNextClientId;
+
+	uint mSendRate;
+	uint mLastSendTime;
+	uint mLastReportTime;
+	uint mNextSequence;
+	// Taken at each send, then quantized and indexed once for every client
+	WorldSnapshot mWorldSnapshot;
+	NetSnapshot mSnapshot;
+	InterestManager mInterest;
+
+	vector<char> mBuffer;
+	string mPacket;
+	bool mWarnedTooLarge;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include <string.h>
+#include "DeltaEncoding.h"
+#include "NetSnapshot.h"
+
+static short Quantize(GLfloat value, int scale)
+{
+	GLfloat scaled = floor(value * scale + 0.5f);
+	if (scaled < -32768.0f) return -32768;
+	if (scaled > 32767.0f) return 32767;
+	return (short)scaled;
+}
+
+static unsigned short QuantizeAngle(GLfloat degrees)
+{
+	GLfloat turns = degrees / 360.0f;
+	turns -= floor(turns);
+	return (unsigned short)(uint)(turns * 65536.0f + 0.5f);
+}
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+NetSnapshot::NetSnapshot()
+{
+	memset(&header, 0, sizeof(header));
+}
+
+/** Destructor. */
+NetSnapshot::~NetSnapshot()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Quantize the objects in a world snapshot, keeping its game values as they are. */
+void NetSnapshot::FromWorldSnapshot(const WorldSnapshot& snapshot)
+{
+	header.step = snapshot.header.step_count;
+	header.width = snapshot.header.width;
+	header.height = snapshot.header.height;
+	objects.resize(snapshot.objects.size());
+	for (uint i = 0; i < objects.size(); i++) {
+		const GameObjectState& state = snapshot.objects[i];
+		NetObjectState& object = objects[i];
+		object.id = state.id;
+		object.type = state.type;
+		object.position[0] = Quantize(state.position.x, POSITION_SCALE);
+		object.position[1] = Quantize(state.position.y, POSITION_SCALE);
+		object.velocity[0] = Quantize(state.velocity.x, POSITION_SCALE);
+		object.velocity[1] = Quantize(state.velocity.y, POSITION_SCALE);
+		object.angle = QuantizeAngle(state.angle);
+		object.scale = (unsigned short)Quantize(state.scale, SCALE_SCALE);
+		object.sprite_frame = (unsigned short)state.sprite_frame;
+		object.render_layer = (uchar)state.render_layer;
+		object.flags = 0;
+		if (state.flags & GAME_OBJECT_STATE_HAS_SPRITE) object.flags |= NET_OBJECT_STATE_HAS_SPRITE;
+		if (state.flags & GAME_OBJECT_STATE_ANIMATING) object.flags |= NET_OBJECT_STATE_ANIMATING;
+		if (state.user_float != 0) object.flags |= NET_OBJECT_STATE_USER_FLAG;
+	}
+	values = snapshot.values;
+}
+
+/** Fill in the objects and values of a world snapshot, for a world that shows this one. */
+void NetSnapshot::ToWorldSnapshot(WorldSnapshot& snapshot) const
+{
+	snapshot.header.step_count = header.step;
+	snapshot.header.width = header.width;
+	snapshot.header.height = header.height;
+	snapshot.objects.resize(objects.size());
+	for (uint i = 0; i < objects.size(); i++) {
+		const NetObjectState& object = objects[i];
+		GameObjectState& state = snapshot.objects[i];
+		state.id = object.id;
+		state.type = object.type;
+		state.position = GLVector3f((GLfloat)object.position[0] / POSITION_SCALE, (GLfloat)object.position[1] / POSITION_SCALE, 0);
+		state.velocity = GLVector3f((GLfloat)object.velocity[0] / POSITION_SCALE, (GLfloat)object.velocity[1] / POSITION_SCALE, 0);
+		state.acceleration = GLVector3f(0, 0, 0);
+		state.angle = object.angle * (360.0f / 65536.0f);
+		state.rotation = 0;
+		state.scale = (GLfloat)(short)object.scale / SCALE_SCALE;
+		state.render_layer = object.render_layer;
+		state.flags = 0;
+		if (object.flags & NET_OBJECT_STATE_HAS_SPRITE) state.flags |= GAME_OBJECT_STATE_HAS_SPRITE;
+		if (object.flags & NET_OBJECT_STATE_ANIMATING) state.flags |= GAME_OBJECT_STATE_ANIMATING;
+		state.sprite_frame = object.sprite_frame;
+		state.sprite_millis = 0;
+		state.user_int = 0;
+		state.user_float = (object.flags & NET_OBJECT_STATE_USER_FLAG) ? 1.0f : 0.0f;
+	}
+	snapshot.values = values;
+	snapshot.header.num_objects = (uint)snapshot.objects.size();
+	snapshot.header.num_values = (uint)snapshot.values.size();
+}
+
+/** Append the snapshot to data, as changes from base if there is one. The
+	header is sent as it is, so the receiver can find the base. */
+void NetSnapshot::Encode(const NetSnapshot* base, string& data) const
+{
+	static const vector<NetObjectState> no_objects;
+
+	NetSnapshotHeader encoded_header = header;
+	encoded_header.base_sequence = base ? base->header.sequence : 0;
+	encoded_header.num_objects = (uint)objects.size();
+	encoded_header.num_values = (uint)values.size();
+	data.append((const char*)&encoded_header, sizeof(encoded_header));
+
+	string raw;
+	raw.reserve(objects.size() * (sizeof(NetObjectState) + 1) + values.size() * sizeof(SnapshotValue));
+	DeltaEncoding::AppendRecords(objects, base ? base->objects : no_objects, raw);
+	if (!values.empty()) raw.append((const char*)&values[0], values.size() * sizeof(SnapshotValue));
+	string compressed;
+	DeltaEncoding::CompressZeroRuns(raw.data(), raw.size(), compressed);
+	data.append(compressed);
+}
+
+/** Decode a snapshot encoded against base, which must be the one named in its header. */
+bool NetSnapshot::Decode(const NetSnapshot* base, const char* data, size_t size)
+{
+	static const vector<NetObjectState> no_objects;
+
+	NetSnapshotHeader decoded_header;
+	if (!ReadHeader(data, size, decoded_header)) return false;
+	if (decoded_header.base_sequence != (base ? base->header.sequence : 0)) return false;
+
+	string raw;
+	if (!DeltaEncoding::ExpandZeroRuns(data + sizeof(decoded_header), size - sizeof(decoded_header), MAX_RAW_SIZE, raw)) return false;
+	size_t offset = 0;
+	vector<NetObjectState> decoded_objects;
+	if (!DeltaEncoding::ReadRecords(raw.data(), raw.size(), offset, decoded_header.num_objects, base ? base->objects : no_objects, decoded_objects)) return false;
+	// Divided rather than multiplied, as a 32 bit size_t can overflow to match no bytes at all
+	size_t values_size = raw.size() - offset;
+	if (values_size % sizeof(SnapshotValue) != 0 || values_size / sizeof(SnapshotValue) != decoded_header.num_values) return false;
+
+	header = decoded_header;
+	objects.swap(decoded_objects);
+	values.resize(header.num_values);
+	if (!values.empty()) memcpy(&values[0], raw.data() + offset, values.size() * sizeof(SnapshotValue));
+	return true;
+}
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+bool NetSnapshot::ReadHeader(const char* data, size_t size, NetSnapshotHeader& header)
+{
+	if (size < sizeof(header)) return false;
+	memcpy(&header, data, sizeof(header));
+	return true;
+}
\ No newline at end of file
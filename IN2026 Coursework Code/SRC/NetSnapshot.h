@@ -0,0 +1,71 @@
+#ifndef __NETSNAPSHOT_H__
+#define __NETSNAPSHOT_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "WorldSnapshot.h"
+
+// What a client needs to draw one object, quantized to fit in 24 bytes
+struct NetObjectState
+{
+	uint id;
+	uint type;
+	short position[2];
+	short velocity[2];
+	unsigned short angle;
+	unsigned short scale;
+	unsigned short sprite_frame;
+	uchar render_layer;
+	uchar flags;
+};
+
+enum NetObjectStateFlags
+{
+	NET_OBJECT_STATE_HAS_SPRITE = 1,
+	NET_OBJECT_STATE_ANIMATING = 2,
+	// Set when the user float is not zero, e.g. a ship that is thrusting
+	NET_OBJECT_STATE_USER_FLAG = 4,
+};
+
+struct NetSnapshotHeader
+{
+	uint sequence;
+	// The snapshot this one is a delta from, 0 if it is complete in itself
+	uint base_sequence;
+	uint step;
+	int width;
+	int height;
+	uint num_objects;
+	uint num_values;
+	// The object controlled by the client the snapshot is sent to
+	uint player_id;
+};
+
+// The part of a world snapshot that is sent to clients. Objects keep what is
+// needed to draw them, with positions and speeds to a sixteenth of a unit,
+// angles to 1/65536 of a turn and scales to 1/4096. Sent as changes from a
+// snapshot the client has acknowledged, unchanged objects cost a few bytes.
+class NetSnapshot
+{
+public:
+	static const int POSITION_SCALE = 16;
+	static const int SCALE_SCALE = 4096;
+	// Largest a snapshot may expand to when decoded, about 40,000 objects
+	static const uint MAX_RAW_SIZE = 1 << 20;
+
+	NetSnapshot();
+	~NetSnapshot();
+
+	void FromWorldSnapshot(const WorldSnapshot& snapshot);
+	void ToWorldSnapshot(WorldSnapshot& snapshot) const;
+
+	void Encode(const NetSnapshot* base, string& data) const;
+	bool Decode(const NetSnapshot* base, const char* data, size_t size);
+	static bool ReadHeader(const char* data, size_t size, NetSnapshotHeader& header);
+
+	NetSnapshotHeader header;
+	vector<NetObjectState> objects;
+	vector<SnapshotValue> values;
+};
+
+#endif
\ No newline at end of file
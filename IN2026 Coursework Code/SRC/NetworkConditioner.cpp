@@ -0,0 +1,60 @@
+#include <chrono>
+#include "NetworkConditioner.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+NetworkConditioner::NetworkConditioner()
+	: mLatency(0),
+	  mJitter(0),
+	  mLoss(0),
+	  mRandom((uint)chrono::steady_clock::now().time_since_epoch().count()),
+	  mDroppedCount(0)
+{
+}
+
+/** Destructor. */
+NetworkConditioner::~NetworkConditioner()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Send a packet, or hold it back to be sent by Flush() once its delay is up. */
+void NetworkConditioner::Send(UdpSocket& socket, const NetAddress& to, const char* data, uint size)
+{
+	if (!IsEnabled()) { socket.Send(to, data, size); return; }
+	if (mLoss > 0 && mRandom.NextFloat() < mLoss) { mDroppedCount++; return; }
+
+	DelayedPacket packet;
+	packet.send_time = GetMillis() + mLatency + (mJitter > 0 ? mRandom.NextInt(mJitter + 1) : 0);
+	packet.to = to;
+	packet.data.assign(data, size);
+	// Keep packets in the order they are due, which with jitter is not always the order they were sent in
+	DelayedPacketList::iterator it = mPackets.end();
+	while (it != mPackets.begin()) {
+		DelayedPacketList::iterator previous = it;
+		--previous;
+		if ((int)(packet.send_time - previous->send_time) >= 0) break;
+		it = previous;
+	}
+	mPackets.insert(it, packet);
+}
+
+/** Send every held back packet whose delay is up. Call often, e.g. every step. */
+void NetworkConditioner::Flush(UdpSocket& socket)
+{
+	uint now = GetMillis();
+	while (!mPackets.empty() && (int)(now - mPackets.front().send_time) >= 0) {
+		const DelayedPacket& packet = mPackets.front();
+		socket.Send(packet.to, packet.data.data(), (uint)packet.data.size());
+		mPackets.pop_front();
+	}
+}
+
+// PRIVATE STATIC METHODS /////////////////////////////////////////////////////
+
+uint NetworkConditioner::GetMillis(void)
+{
+	return (uint)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef __NETWORKCONDITIONER_H__
+#define __NETWORKCONDITIONER_H__
+
+#include <list>
+#include "GameUtil.h"
+#include "RandomStream.h"
+#include "UdpSocket.h"
+
+// Sends packets as if over a worse network than the one there is, holding
+// each back by the latency plus up to the jitter and dropping some of them,
+// so a game can be tested over loopback. With everything at 0, packets go
+// straight to the socket.
+class NetworkConditioner
+{
+public:
+	NetworkConditioner();
+	~NetworkConditioner();
+
+	void SetLatency(uint msecs) { mLatency = msecs; }
+	uint GetLatency() const { return mLatency; }
+	void SetJitter(uint msecs) { mJitter = msecs; }
+	uint GetJitter() const { return mJitter; }
+	void SetLoss(float fraction) { mLoss = fraction; }
+	float GetLoss() const { return mLoss; }
+	bool IsEnabled() const { return mLatency > 0 || mJitter > 0 || mLoss > 0; }
+
+	void Send(UdpSocket& socket, const NetAddress& to, const char* data, uint size);
+	void Flush(UdpSocket& socket);
+
+	uint GetDroppedCount() const { return mDroppedCount; }
+
+private:
+	struct DelayedPacket
+	{
+		uint send_time;
+		NetAddress to;
+		string data;
+	};
+	typedef list<DelayedPacket> DelayedPacketList;
+
+	static uint GetMillis(void);
+
+	uint mLatency;
+	uint mJitter;
+	float mLoss;
+	// Separate from the game's streams, so the network does not change the game
+	RandomStream mRandom;
+	DelayedPacketList mPackets;
+	uint mDroppedCount;
+};
+
+#endif
\ No newline at end of file
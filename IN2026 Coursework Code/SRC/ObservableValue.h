@@ -0,0 +1,49 @@
+#ifndef __OBSERVABLEVALUE_H__
+#define __OBSERVABLEVALUE_H__
+
+#include <functional>
+#include <vector>
+#include "GameUtil.h"
+
+// A value whose listeners are told about changes only when it is published,
+// with the latest value, however many times it was set in between. Owners
+// publish once per frame, so a HUD showing many counters updates each of
+// them at most once a frame.
+template <class T>
+class ObservableValue
+{
+public:
+	typedef function<void (const T&)> Listener;
+
+	ObservableValue(const T& value = T()) : mValue(value), mPublished(value), mChanged(false) {}
+
+	const T& Get() const { return mValue; }
+	void Set(const T& value) { mValue = value; mChanged = !(mValue == mPublished); }
+
+	/** Make the next Publish() notify listeners even if the value is unchanged. */
+	void Invalidate() { mChanged = true; }
+	bool HasChanged() const { return mChanged; }
+
+	void AddListener(const Listener& listener) { mListeners.push_back(listener); }
+
+	/** Notify every listener of the value if it has changed since it was last published. */
+	void Publish()
+	{
+		if (!mChanged) return;
+		mPublished = mValue;
+		mChanged = false;
+		for (typename ListenerVector::iterator it = mListeners.begin(); it != mListeners.end(); ++it) {
+			(*it)(mValue);
+		}
+	}
+
+private:
+	typedef vector<Listener> ListenerVector;
+
+	T mValue;
+	T mPublished;
+	bool mChanged;
+	ListenerVector mListeners;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef __PIXELFORMAT_H__
+#define __PIXELFORMAT_H__
+
+#include "GameUtil.h"
+
+// Layouts pixel data can be stored and uploaded in. The compact formats are
+// 16 bits per pixel, so they halve memory and upload time where they fit.
+enum PixelFormat
+{
+	PIXEL_FORMAT_BGRA8,		// 8 bits per channel
+	PIXEL_FORMAT_LA8,		// 8 bit grey and alpha, for sprites with no colour
+	PIXEL_FORMAT_BGR5_A1,	// 5 bits per colour and 1 bit alpha, for cut-out sprites
+	PIXEL_FORMAT_BGRA4,		// 4 bits per channel
+	PIXEL_FORMAT_COUNT,
+};
+
+inline uint GetPixelSize(PixelFormat format)
+{
+	return (format == PIXEL_FORMAT_BGRA8) ? 4 : 2;
+}
+
+// Formats uploaded with the packed 16 bit pixel types, which need GL 1.2
+inline bool IsPackedPixelFormat(PixelFormat format)
+{
+	return format == PIXEL_FORMAT_BGR5_A1 || format == PIXEL_FORMAT_BGRA4;
+}
+
+inline const char* GetPixelFormatName(PixelFormat format)
+{
+	switch (format)
+	{
+	case PIXEL_FORMAT_LA8: return "LA8";
+	case PIXEL_FORMAT_BGR5_A1: return "BGR5_A1";
+	case PIXEL_FORMAT_BGRA4: return "BGRA4";
+	default: return "BGRA8";
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,426 @@
+#include <string.h>
+#include <vector>
+#include "PixelKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXEL_KERNELS_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need to be told per function which instruction sets it may
+// use, MSVC allows the intrinsics anywhere
+#if defined(PIXEL_KERNELS_X86) && defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+PixelKernelLevel PixelKernels::mLevel = PixelKernels::GetSupportedLevel();
+
+// SCALAR KERNELS /////////////////////////////////////////////////////////////
+
+static void ExpandBGRToBGRAScalar(const uchar* src, uchar* dst, uint count, bool reverse)
+{
+	for (uint i = 0; i < count; i++) {
+		const uchar* s = src + 3 * (reverse ? count - 1 - i : i);
+		dst[4*i + 0] = s[0];
+		dst[4*i + 1] = s[1];
+		dst[4*i + 2] = s[2];
+		dst[4*i + 3] = 255;
+	}
+}
+
+static void CopyBGRAScalar(const uchar* src, uchar* dst, uint count, bool reverse)
+{
+	if (!reverse) {
+		memcpy(dst, src, 4 * count);
+		return;
+	}
+	for (uint i = 0; i < count; i++) {
+		memcpy(dst + 4*i, src + 4*(count - 1 - i), 4);
+	}
+}
+
+static void ApplyColourKeyScalar(uchar* pixels, uint count, uchar c0, uchar c1, uchar c2)
+{
+	for (uint i = 0; i < 4*count; i += 4) {
+		bool keyed = (pixels[i] == c0 && pixels[i+1] == c1 && pixels[i+2] == c2);
+		pixels[i+3] = keyed ? 0 : 255;
+	}
+}
+
+static void PremultiplyAlphaScalar(uchar* pixels, uint count)
+{
+	// Exact round(c*a/255) without a divide, the same sum the SIMD kernels use
+	for (uint i = 0; i < 4*count; i += 4) {
+		uint a = pixels[i+3];
+		for (uint c = 0; c < 3; c++) {
+			uint t = pixels[i+c] * a + 128;
+			pixels[i+c] = (uchar)((t + (t >> 8)) >> 8);
+		}
+	}
+}
+
+static void Downsample2x2Scalar(const uchar* src, uint src_stride, uchar* dst, uint dst_width, uint dst_height, uint first_column)
+{
+	for (uint j = 0; j < dst_height; j++) {
+		const uchar* a = src + 2*j*src_stride;
+		const uchar* b = a + src_stride;
+		uchar* d = dst + 4*j*dst_width;
+		for (uint i = 4*first_column; i < 4*dst_width; i++) {
+			// Channel c of pixel i/4 averages the 2x2 block below it, rounding to nearest
+			uint s = i + (i & ~3u);
+			d[i] = (uchar)((a[s] + a[s+4] + b[s] + b[s+4] + 2) >> 2);
+		}
+	}
+}
+
+#ifdef PIXEL_KERNELS_X86
+
+// SSE2 KERNELS ///////////////////////////////////////////////////////////////
+
+TARGET_SSE2 static void CopyBGRAReversedSSE2(const uchar* src, uchar* dst, uint count)
+{
+	uint i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(src + 4*(count - 4 - i)));
+		_mm_storeu_si128((__m128i*)(dst + 4*i), _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+	}
+	for (; i < count; i++) {
+		memcpy(dst + 4*i, src + 4*(count - 1 - i), 4);
+	}
+}
+
+TARGET_SSE2 static void ApplyColourKeySSE2(uchar* pixels, uint count, uchar c0, uchar c1, uchar c2)
+{
+	const __m128i key = _mm_set1_epi32(c0 | (c1 << 8) | (c2 << 16));
+	const __m128i colour_mask = _mm_set1_epi32(0x00FFFFFF);
+	const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+	uint i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i colour = _mm_and_si128(_mm_loadu_si128((const __m128i*)(pixels + 4*i)), colour_mask);
+		__m128i keyed = _mm_cmpeq_epi32(colour, key);
+		_mm_storeu_si128((__m128i*)(pixels + 4*i), _mm_or_si128(colour, _mm_andnot_si128(keyed, opaque)));
+	}
+	ApplyColourKeyScalar(pixels + 4*i, count - i, c0, c1, c2);
+}
+
+TARGET_SSE2 static __m128i PremultiplyPairSSE2(__m128i pixels)
+{
+	// Multiply each colour by its pixel's alpha and alpha by 255, so alpha is unchanged
+	const __m128i colour_mask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+	const __m128i alpha_one = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+	__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm_or_si128(_mm_and_si128(alpha, colour_mask), alpha_one);
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(pixels, alpha), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+TARGET_SSE2 static void PremultiplyAlphaSSE2(uchar* pixels, uint count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	uint i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(pixels + 4*i));
+		__m128i lo = PremultiplyPairSSE2(_mm_unpacklo_epi8(v, zero));
+		__m128i hi = PremultiplyPairSSE2(_mm_unpackhi_epi8(v, zero));
+		_mm_storeu_si128((__m128i*)(pixels + 4*i), _mm_packus_epi16(lo, hi));
+	}
+	PremultiplyAlphaScalar(pixels + 4*i, count - i);
+}
+
+TARGET_SSE2 static __m128i SumPairsSSE2(__m128i a, __m128i b)
+{
+	// a and b are four pixels from two neighbouring rows. Returns the sums of
+	// pixels 0 and 1 and of pixels 2 and 3 down both rows, as 16 bit channels.
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+	__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+	return _mm_unpacklo_epi64(_mm_add_epi16(lo, _mm_srli_si128(lo, 8)), _mm_add_epi16(hi, _mm_srli_si128(hi, 8)));
+}
+
+TARGET_SSE2 static void Downsample2x2SSE2(const uchar* src, uint src_stride, uchar* dst, uint dst_width, uint dst_height)
+{
+	const __m128i round = _mm_set1_epi16(2);
+	uint columns = dst_width & ~3u;
+	for (uint j = 0; j < dst_height; j++) {
+		const uchar* a = src + 2*j*src_stride;
+		const uchar* b = a + src_stride;
+		uchar* d = dst + 4*j*dst_width;
+		for (uint i = 0; i < columns; i += 4) {
+			__m128i lo = SumPairsSSE2(_mm_loadu_si128((const __m128i*)(a + 8*i)), _mm_loadu_si128((const __m128i*)(b + 8*i)));
+			__m128i hi = SumPairsSSE2(_mm_loadu_si128((const __m128i*)(a + 8*i + 16)), _mm_loadu_si128((const __m128i*)(b + 8*i + 16)));
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 2);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 2);
+			_mm_storeu_si128((__m128i*)(d + 4*i), _mm_packus_epi16(lo, hi));
+		}
+	}
+	Downsample2x2Scalar(src, src_stride, dst, dst_width, dst_height, columns);
+}
+
+// AVX2 KERNELS ///////////////////////////////////////////////////////////////
+
+TARGET_AVX2 static void ExpandBGRToBGRAAVX2(const uchar* src, uchar* dst, uint count, bool reverse)
+{
+	// Each 128 bit lane expands four 3 byte pixels. The upper lane is loaded
+	// 8 bytes in so the 24 bytes read never run past the end of the source.
+	const __m256i expand = _mm256_setr_epi8(
+		0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+		4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1);
+	const __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+	const __m256i reversed = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	uint i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const uchar* s = src + 3 * (reverse ? count - 8 - i : i);
+		__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)s)),
+			_mm_loadu_si128((const __m128i*)(s + 8)), 1);
+		v = _mm256_or_si256(_mm256_shuffle_epi8(v, expand), opaque);
+		if (reverse) v = _mm256_permutevar8x32_epi32(v, reversed);
+		_mm256_storeu_si256((__m256i*)(dst + 4*i), v);
+	}
+	// The remaining pixels are the last of dst, taken from the start of src when reversed
+	ExpandBGRToBGRAScalar(reverse ? src : src + 3*i, dst + 4*i, count - i, reverse);
+}
+
+TARGET_AVX2 static void CopyBGRAReversedAVX2(const uchar* src, uchar* dst, uint count)
+{
+	const __m256i reversed = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	uint i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(src + 4*(count - 8 - i)));
+		_mm256_storeu_si256((__m256i*)(dst + 4*i), _mm256_permutevar8x32_epi32(v, reversed));
+	}
+	CopyBGRAScalar(src, dst + 4*i, count - i, true);
+}
+
+TARGET_AVX2 static void ApplyColourKeyAVX2(uchar* pixels, uint count, uchar c0, uchar c1, uchar c2)
+{
+	const __m256i key = _mm256_set1_epi32(c0 | (c1 << 8) | (c2 << 16));
+	const __m256i colour_mask = _mm256_set1_epi32(0x00FFFFFF);
+	const __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+	uint i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i colour = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(pixels + 4*i)), colour_mask);
+		__m256i keyed = _mm256_cmpeq_epi32(colour, key);
+		_mm256_storeu_si256((__m256i*)(pixels + 4*i), _mm256_or_si256(colour, _mm256_andnot_si256(keyed, opaque)));
+	}
+	ApplyColourKeyScalar(pixels + 4*i, count - i, c0, c1, c2);
+}
+
+TARGET_AVX2 static __m256i PremultiplyPairAVX2(__m256i pixels)
+{
+	const __m256i colour_mask = _mm256_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0);
+	const __m256i alpha_one = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+	__m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm256_or_si256(_mm256_and_si256(alpha, colour_mask), alpha_one);
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(pixels, alpha), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+TARGET_AVX2 static void PremultiplyAlphaAVX2(uchar* pixels, uint count)
+{
+	// Unpack and pack both work within 128 bit lanes, so pixel order is kept
+	const __m256i zero = _mm256_setzero_si256();
+	uint i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(pixels + 4*i));
+		__m256i lo = PremultiplyPairAVX2(_mm256_unpacklo_epi8(v, zero));
+		__m256i hi = PremultiplyPairAVX2(_mm256_unpackhi_epi8(v, zero));
+		_mm256_storeu_si256((__m256i*)(pixels + 4*i), _mm256_packus_epi16(lo, hi));
+	}
+	PremultiplyAlphaScalar(pixels + 4*i, count - i);
+}
+
+#endif
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+/** The widest instruction set both the CPU and the OS support. */
+PixelKernelLevel PixelKernels::GetSupportedLevel(void)
+{
+#ifdef PIXEL_KERNELS_X86
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	int max_leaf = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+	bool avx2 = false;
+	// AVX2 also needs the OS to save the upper halves of the registers
+	if (avx && max_leaf >= 7 && (_xgetbv(0) & 6) == 6) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+#else
+	__builtin_cpu_init();
+	bool sse2 = __builtin_cpu_supports("sse2") != 0;
+	bool avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+	if (avx2) return PIXEL_KERNELS_AVX2;
+	if (sse2) return PIXEL_KERNELS_SSE2;
+#endif
+	return PIXEL_KERNELS_SCALAR;
+}
+
+/** Restrict the kernels to a narrower instruction set, e.g. to compare them. */
+void PixelKernels::SetLevel(PixelKernelLevel level)
+{
+	PixelKernelLevel supported = GetSupportedLevel();
+	mLevel = (level > supported) ? supported : level;
+}
+
+const char* PixelKernels::GetLevelName(PixelKernelLevel level)
+{
+	switch (level)
+	{
+	case PIXEL_KERNELS_SSE2: return "SSE2";
+	case PIXEL_KERNELS_AVX2: return "AVX2";
+	default: return "scalar";
+	}
+}
+
+/** Expand 3 byte pixels to 4 bytes with opaque alpha, optionally reversing their order. */
+void PixelKernels::ExpandBGRToBGRA(const uchar* src, uchar* dst, uint count, bool reverse)
+{
+#ifdef PIXEL_KERNELS_X86
+	// SSE2 has no byte shuffle, so only AVX2 improves on the scalar loop here
+	if (mLevel >= PIXEL_KERNELS_AVX2) { ExpandBGRToBGRAAVX2(src, dst, count, reverse); return; }
+#endif
+	ExpandBGRToBGRAScalar(src, dst, count, reverse);
+}
+
+/** Copy 4 byte pixels, optionally reversing their order. */
+void PixelKernels::CopyBGRA(const uchar* src, uchar* dst, uint count, bool reverse)
+{
+#ifdef PIXEL_KERNELS_X86
+	if (reverse && mLevel >= PIXEL_KERNELS_AVX2) { CopyBGRAReversedAVX2(src, dst, count); return; }
+	if (reverse && mLevel >= PIXEL_KERNELS_SSE2) { CopyBGRAReversedSSE2(src, dst, count); return; }
+#endif
+	CopyBGRAScalar(src, dst, count, reverse);
+}
+
+/** Copy a 24 or 32 bit image with padded rows into tightly packed BGRA, reorienting it on the way. */
+void PixelKernels::ConvertToBGRA(const uchar* src, uint src_pitch, uint src_bpp, uchar* dst, uint width, uint height, PixelOrientation orientation)
+{
+	bool flip_rows = (orientation == PIXEL_ORIENTATION_FLIP_VERTICAL || orientation == PIXEL_ORIENTATION_ROTATE_180);
+	bool reverse = (orientation == PIXEL_ORIENTATION_FLIP_HORIZONTAL || orientation == PIXEL_ORIENTATION_ROTATE_180);
+	for (uint j = 0; j < height; j++) {
+		const uchar* src_row = src + (flip_rows ? height - 1 - j : j) * src_pitch;
+		uchar* dst_row = dst + 4 * width * j;
+		if (src_bpp == 24) {
+			ExpandBGRToBGRA(src_row, dst_row, width, reverse);
+		} else {
+			CopyBGRA(src_row, dst_row, width, reverse);
+		}
+	}
+}
+
+/** Make pixels whose first three bytes match the key transparent and all others opaque. */
+void PixelKernels::ApplyColourKey(uchar* pixels, uint count, uchar c0, uchar c1, uchar c2)
+{
+#ifdef PIXEL_KERNELS_X86
+	if (mLevel >= PIXEL_KERNELS_AVX2) { ApplyColourKeyAVX2(pixels, count, c0, c1, c2); return; }
+	if (mLevel >= PIXEL_KERNELS_SSE2) { ApplyColourKeySSE2(pixels, count, c0, c1, c2); return; }
+#endif
+	ApplyColourKeyScalar(pixels, count, c0, c1, c2);
+}
+
+/** Multiply each pixel's colour by its alpha, for use with GL_ONE, GL_ONE_MINUS_SRC_ALPHA blending. */
+void PixelKernels::PremultiplyAlpha(uchar* pixels, uint count)
+{
+#ifdef PIXEL_KERNELS_X86
+	if (mLevel >= PIXEL_KERNELS_AVX2) { PremultiplyAlphaAVX2(pixels, count); return; }
+	if (mLevel >= PIXEL_KERNELS_SSE2) { PremultiplyAlphaSSE2(pixels, count); return; }
+#endif
+	PremultiplyAlphaScalar(pixels, count);
+}
+
+/** Halve an image in both directions, averaging each 2x2 block of pixels. */
+void PixelKernels::Downsample2x2(const uchar* src, uint src_stride, uchar* dst, uint dst_width, uint dst_height)
+{
+#ifdef PIXEL_KERNELS_X86
+	if (mLevel >= PIXEL_KERNELS_SSE2) { Downsample2x2SSE2(src, src_stride, dst, dst_width, dst_height); return; }
+#endif
+	Downsample2x2Scalar(src, src_stride, dst, dst_width, dst_height, 0);
+}
+
+// Round an 8 bit channel to the given number of bits and expand it back, as GL does
+static inline uint Quantize(uint value, uint bits)
+{
+	uint max = (1u << bits) - 1;
+	return (value * max + 127) / 255;
+}
+
+static inline uint Expand(uint quantized, uint bits)
+{
+	uint max = (1u << bits) - 1;
+	return (quantized * 255 + max / 2) / max;
+}
+
+static inline uint ChannelError(uint value, uint bits)
+{
+	int difference = (int)value - (int)Expand(Quantize(value, bits), bits);
+	return (uint)(difference < 0 ? -difference : difference);
+}
+
+/** Find the largest error any channel would have in each format. The colour
+	of fully transparent pixels is never seen, so only their alpha counts. */
+void PixelKernels::MeasureFormatErrors(const uchar* src, uint src_stride, uint width, uint height, uint errors[PIXEL_FORMAT_COUNT])
+{
+	for (uint f = 0; f < PIXEL_FORMAT_COUNT; f++) errors[f] = 0;
+	for (uint j = 0; j < height; j++) {
+		const uchar* p = src + j*src_stride;
+		for (uint i = 0; i < width; i++, p += 4) {
+			uint b = p[0], g = p[1], r = p[2], a = p[3];
+			uint la = 0, bgr5_a1 = (a < 128) ? a : 255 - a, bgra4 = ChannelError(a, 4);
+			if (a != 0) {
+				uint grey = (r + g + b + 1) / 3;
+				la = max(max((uint)abs((int)r - (int)grey), (uint)abs((int)g - (int)grey)), (uint)abs((int)b - (int)grey));
+				bgr5_a1 = max(bgr5_a1, max(max(ChannelError(b, 5), ChannelError(g, 5)), ChannelError(r, 5)));
+				bgra4 = max(bgra4, max(max(ChannelError(b, 4), ChannelError(g, 4)), ChannelError(r, 4)));
+			}
+			errors[PIXEL_FORMAT_LA8] = max(errors[PIXEL_FORMAT_LA8], la);
+			errors[PIXEL_FORMAT_BGR5_A1] = max(errors[PIXEL_FORMAT_BGR5_A1], bgr5_a1);
+			errors[PIXEL_FORMAT_BGRA4] = max(errors[PIXEL_FORMAT_BGRA4], bgra4);
+		}
+	}
+}
+
+/** Pack BGRA pixels into a compact format. 16 bit formats are stored in the
+	order GL reads them with the _REV packed types and GL_BGRA. */
+void PixelKernels::ConvertFromBGRA(const uchar* src, uint src_stride, uint width, uint height, PixelFormat format, uchar* dst)
+{
+	for (uint j = 0; j < height; j++) {
+		const uchar* p = src + j*src_stride;
+		if (format == PIXEL_FORMAT_BGRA8) {
+			memcpy(dst, p, 4 * width);
+			dst += 4 * width;
+			continue;
+		}
+		for (uint i = 0; i < width; i++, p += 4, dst += 2) {
+			uint b = p[0], g = p[1], r = p[2], a = p[3];
+			unsigned short packed = 0;
+			switch (format)
+			{
+			case PIXEL_FORMAT_LA8:
+				dst[0] = (uchar)((r + g + b + 1) / 3);
+				dst[1] = (uchar)a;
+				continue;
+			case PIXEL_FORMAT_BGR5_A1:
+				packed = (unsigned short)(Quantize(b, 5) | (Quantize(g, 5) << 5) | (Quantize(r, 5) << 10) | ((a >= 128) ? 0x8000 : 0));
+				break;
+			default:
+				packed = (unsigned short)(Quantize(b, 4) | (Quantize(g, 4) << 4) | (Quantize(r, 4) << 8) | (Quantize(a, 4) << 12));
+				break;
+			}
+			memcpy(dst, &packed, 2);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef __PIXELKERNELS_H__
+#define __PIXELKERNELS_H__
+
+#include "GameUtil.h"
+#include "PixelFormat.h"
+
+// Instruction sets the kernels can use, in increasing order of width
+enum PixelKernelLevel
+{
+	PIXEL_KERNELS_SCALAR,
+	PIXEL_KERNELS_SSE2,
+	PIXEL_KERNELS_AVX2,
+};
+
+// How rows and pixels are rearranged while an image is copied
+enum PixelOrientation
+{
+	PIXEL_ORIENTATION_NONE,
+	PIXEL_ORIENTATION_FLIP_VERTICAL,
+	PIXEL_ORIENTATION_FLIP_HORIZONTAL,
+	PIXEL_ORIENTATION_ROTATE_180,
+};
+
+// Bulk operations on 8 bit per channel BGR and BGRA pixels. Each kernel has
+// a scalar version and uses SSE2 or AVX2 where the CPU supports them, with
+// identical results at every level.
+class PixelKernels
+{
+public:
+	static PixelKernelLevel GetSupportedLevel(void);
+	static PixelKernelLevel GetLevel(void) { return mLevel; }
+	static void SetLevel(PixelKernelLevel level);
+	static const char* GetLevelName(PixelKernelLevel level);
+
+	static void ExpandBGRToBGRA(const uchar* src, uchar* dst, uint count, bool reverse);
+	static void CopyBGRA(const uchar* src, uchar* dst, uint count, bool reverse);
+	static void ConvertToBGRA(const uchar* src, uint src_pitch, uint src_bpp, uchar* dst, uint width, uint height, PixelOrientation orientation);
+	static void ApplyColourKey(uchar* pixels, uint count, uchar c0, uchar c1, uchar c2);
+	static void PremultiplyAlpha(uchar* pixels, uint count);
+	static void Downsample2x2(const uchar* src, uint src_stride, uchar* dst, uint dst_width, uint dst_height);
+
+	// Compact formats, scalar only as they run offline or on a loader thread
+	static void MeasureFormatErrors(const uchar* src, uint src_stride, uint width, uint height, uint errors[PIXEL_FORMAT_COUNT]);
+	static void ConvertFromBGRA(const uchar* src, uint src_stride, uint width, uint height, PixelFormat format, uchar* dst);
+
+private:
+	PixelKernels() {} // Not instantiated
+
+	static PixelKernelLevel mLevel;
+};
+
+#endif
\ No newline at end of file
@@ -5,13 +5,14 @@
 
 #include "GameObject.h"
 #include "GameObjectType.h"
+#include "ObservableValue.h"
 #include "IPlayerListener.h"
 #include "IGameWorldListener.h"
 
 class Player : public IGameWorldListener
 {
 public:
-	Player() { mLives = 3; }
+	Player() : mLives(3) {}
 	virtual ~Player() {}
 
 	void OnWorldUpdated(GameWorld* world) {}
@@ -21,7 +22,7 @@ public:
 	void OnObjectRemoved(GameWorld* world, shared_ptr<GameObject> object)
 	{
 		if (object->GetType() == GameObjectType("Spaceship")) {
-			mLives -= 1;
+			mLives.Set(mLives.Get() - 1);
 			FirePlayerKilled();
 		}
 	}
@@ -36,11 +37,12 @@ public:
 		// Send message to all listeners
 		for (PlayerListenerList::iterator lit = mListeners.begin();
 			lit != mListeners.end(); ++lit) {
-			(*lit)->OnPlayerKilled(mLives);
+			(*lit)->OnPlayerKilled(mLives.Get());
 		}
 	}
 	
-	int mLives;
+	// Published once per frame by the session, for the HUD
+	ObservableValue<int> mLives;
 
 private:
 
@@ -0,0 +1,87 @@
+#include "RandomStream.h"
+
+static inline uint RotateLeft(uint x, int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. Gives stream 0 of seed 0. */
+RandomStream::RandomStream()
+{
+	Seed(0, 0);
+}
+
+/** Construct the given stream of a seed. */
+RandomStream::RandomStream(uint seed, uint stream)
+{
+	Seed(seed, stream);
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Restart the sequence. The state is filled from the seed and stream number with
+	splitmix64, which never leaves it all zero and spreads nearby seeds far apart. */
+void RandomStream::Seed(uint seed, uint stream)
+{
+	unsigned long long x = ((unsigned long long)stream << 32) | seed;
+	for (uint i = 0; i < 4; i += 2) {
+		x += 0x9E3779B97F4A7C15ULL;
+		unsigned long long z = x;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z = z ^ (z >> 31);
+		mState[i] = (uint)z;
+		mState[i + 1] = (uint)(z >> 32);
+	}
+}
+
+void RandomStream::GetState(uint state[4]) const
+{
+	for (uint i = 0; i < 4; i++) state[i] = mState[i];
+}
+
+void RandomStream::SetState(const uint state[4])
+{
+	for (uint i = 0; i < 4; i++) mState[i] = state[i];
+}
+
+/** The next 32 random bits. */
+uint RandomStream::Next(void)
+{
+	uint result = RotateLeft(mState[1] * 5, 7) * 9;
+	uint t = mState[1] << 9;
+	mState[2] ^= mState[0];
+	mState[3] ^= mState[1];
+	mState[1] ^= mState[2];
+	mState[0] ^= mState[3];
+	mState[2] ^= t;
+	mState[3] = RotateLeft(mState[3], 11);
+	return result;
+}
+
+/** A number from 0 to n-1, using the high bits rather than the modulo so small ranges stay even. */
+uint RandomStream::NextInt(uint n)
+{
+	return (uint)(((unsigned long long)Next() * n) >> 32);
+}
+
+/** A number from min to max inclusive. */
+int RandomStream::NextInt(int min, int max)
+{
+	return min + (int)NextInt((uint)(max - min) + 1);
+}
+
+/** A number from 0 up to but not including 1. */
+float RandomStream::NextFloat(void)
+{
+	// The top 24 bits fill a float's mantissa exactly
+	return (Next() >> 8) * (1.0f / 16777216.0f);
+}
+
+/** A number from min up to but not including max. */
+float RandomStream::NextFloat(float min, float max)
+{
+	return min + (max - min) * NextFloat();
+}
\ No newline at end of file
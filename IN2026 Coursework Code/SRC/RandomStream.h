@@ -0,0 +1,32 @@
+#ifndef __RANDOMSTREAM_H__
+#define __RANDOMSTREAM_H__
+
+#include "GameUtil.h"
+
+// A small, fast pseudo random number generator (xoshiro128**) with its own
+// state, so each user can have a stream that nothing else draws from. The same
+// seed and stream number always give the same sequence on every platform.
+// Different stream numbers for one seed give unrelated sequences.
+class RandomStream
+{
+public:
+	RandomStream();
+	RandomStream(uint seed, uint stream = 0);
+
+	void Seed(uint seed, uint stream = 0);
+
+	uint Next(void);
+	uint NextInt(uint n);
+	int NextInt(int min, int max);
+	float NextFloat(void);
+	float NextFloat(float min, float max);
+
+	// The whole state, for saving a stream and restoring it to the same point
+	void GetState(uint state[4]) const;
+	void SetState(const uint state[4]);
+
+private:
+	uint mState[4];
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include "GameUtil.h"
+#include "GameObject.h"
+#include "Shape.h"
+#include "Sprite.h"
+#include "SpriteBatch.h"
+#include "RenderState.h"
+#include "RenderQueue.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+RenderQueue::RenderQueue()
+{
+}
+
+/** Destructor. */
+RenderQueue::~RenderQueue()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Remove all commands ready for the next frame. */
+void RenderQueue::Clear(void)
+{
+	mCommands.clear();
+}
+
+/** Queue a line shape drawn with the given object's transform. */
+void RenderQueue::SubmitShape(uint layer, GameObject* object, Shape* shape)
+{
+	RenderCommand command;
+	// Sort copies of the same shape together so they can be instanced
+	command.key = MakeSortKey(layer, RENDER_MATERIAL_LINES, shape->GetShapeID());
+	command.material = RENDER_MATERIAL_LINES;
+	command.texture_id = 0;
+	command.object = object;
+	command.shape = shape;
+	command.sprite = NULL;
+	mCommands.push_back(command);
+}
+
+/** Queue a textured sprite drawn with the given object's transform. */
+void RenderQueue::SubmitSprite(uint layer, GameObject* object, Sprite* sprite)
+{
+	RenderCommand command;
+	command.texture_id = sprite->GetTextureID();
+	command.key = MakeSortKey(layer, RENDER_MATERIAL_SPRITE, command.texture_id);
+	command.material = RENDER_MATERIAL_SPRITE;
+	command.object = object;
+	command.shape = NULL;
+	command.sprite = sprite;
+	mCommands.push_back(command);
+}
+
+/** Sort all queued commands and draw them, changing GL state only when needed. */
+void RenderQueue::Execute(SpriteBatch& batch)
+{
+	// Commands with equal keys keep the order they were submitted in
+	stable_sort(mCommands.begin(), mCommands.end(), CompareCommands);
+
+	batch.Begin();
+	uint i = 0;
+	while (i < mCommands.size()) {
+		const RenderCommand& command = mCommands[i];
+		// Draw any batched sprites before state changes to another material, or
+		// before a later layer, as the batch only keeps texture order
+		if (i > 0 && (mCommands[i-1].material != command.material || GetLayer(mCommands[i-1].key) != GetLayer(command.key))) batch.Flush();
+		if (command.shape != NULL) {
+			// Find the run of commands drawing this shape on the same layer
+			uint last = i + 1;
+			while (last < mCommands.size() && mCommands[last].key == command.key && mCommands[last].shape == command.shape) last++;
+			if (last - i >= INSTANCING_THRESHOLD) {
+				ExecuteShapeInstances(i, last);
+				i = last;
+				continue;
+			}
+		}
+		ExecuteCommand(command, batch);
+		i++;
+	}
+	batch.End();
+}
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+/** Pack a layer, material and texture into a single sortable key. */
+RenderSortKey RenderQueue::MakeSortKey(uint layer, RenderMaterial material, uint texture_id)
+{
+	return ((RenderSortKey)(layer & 0xFFFF) << 48) | ((RenderSortKey)(material & 0xFFFF) << 32) | (RenderSortKey)texture_id;
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+/** Draw a single command. */
+void RenderQueue::ExecuteCommand(const RenderCommand& command, SpriteBatch& batch)
+{
+	if (command.shape != NULL) {
+		RenderState::GetInstance().ApplyMaterial(command.material);
+		command.object->PreRender();
+		command.shape->Draw();
+		command.object->PostRender();
+	}
+	if (command.sprite != NULL) {
+		if (batch.IsActive()) {
+			command.sprite->Render(batch, command.object->GetPosition(), command.object->GetAngle(), command.object->GetScale());
+		} else {
+			command.object->PreRender();
+			command.sprite->Render();
+			command.object->PostRender();
+		}
+	}
+}
+
+/** Draw a run of commands sharing one shape with a single instanced call. */
+void RenderQueue::ExecuteShapeInstances(uint first, uint last)
+{
+	mShapeInstances.resize(last - first);
+	for (uint i = first; i < last; i++) {
+		GameObject* object = mCommands[i].object;
+		ShapeInstance& instance = mShapeInstances[i - first];
+		instance.position = object->GetPosition();
+		instance.angle = object->GetAngle();
+		instance.scale = object->GetScale();
+	}
+	RenderState::GetInstance().ApplyMaterial(mCommands[first].material);
+	mCommands[first].shape->DrawInstances(&mShapeInstances[0], last - first);
+}
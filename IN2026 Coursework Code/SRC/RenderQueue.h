@@ -0,0 +1,56 @@
+#ifndef __RENDERQUEUE_H__
+#define __RENDERQUEUE_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "RenderState.h"
+#include "Shape.h"
+
+class GameObject;
+class Sprite;
+class SpriteBatch;
+
+// Sort keys are made of layer, then material, then texture
+typedef unsigned long long RenderSortKey;
+
+struct RenderCommand
+{
+	RenderSortKey key;
+	RenderMaterial material;
+	uint texture_id;
+	GameObject* object;
+	Shape* shape;
+	Sprite* sprite;
+};
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	void Clear(void);
+	void SubmitShape(uint layer, GameObject* object, Shape* shape);
+	void SubmitSprite(uint layer, GameObject* object, Sprite* sprite);
+	void Execute(SpriteBatch& batch);
+
+	uint GetCommandCount() const { return (uint)mCommands.size(); }
+
+	static RenderSortKey MakeSortKey(uint layer, RenderMaterial material, uint texture_id);
+
+private:
+	static bool CompareCommands(const RenderCommand& a, const RenderCommand& b) { return a.key < b.key; }
+	static uint GetLayer(RenderSortKey key) { return (uint)(key >> 48); }
+
+	void ExecuteCommand(const RenderCommand& command, SpriteBatch& batch);
+	void ExecuteShapeInstances(uint first, uint last);
+
+	// Runs of at least this many copies of a shape are drawn in one call
+	static const uint INSTANCING_THRESHOLD = 2;
+
+	typedef vector<RenderCommand> RenderCommandVector;
+	RenderCommandVector mCommands;
+	vector<ShapeInstance> mShapeInstances;
+};
+
+#endif
\ No newline at end of file
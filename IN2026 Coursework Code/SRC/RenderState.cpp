@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include "GameUtil.h"
+#include "RenderState.h"
+
+// PRIVATE INSTANCE CONSTRUCTORS //////////////////////////////////////////////
+
+/** Constructor. Nothing is known about the GL state until it is first set. */
+RenderState::RenderState()
+	: mStateChanges(0),
+	  mTextureBinds(0),
+	  mDrawCalls(0),
+	  mLastFrameStateChanges(0),
+	  mLastFrameTextureBinds(0),
+	  mLastFrameDrawCalls(0),
+	  mVersionMajor(-1),
+	  mVersionMinor(-1)
+{
+	Invalidate();
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Start a new frame, keeping the previous frame's counters for reporting. */
+void RenderState::BeginFrame(void)
+{
+	mLastFrameStateChanges = mStateChanges;
+	mLastFrameTextureBinds = mTextureBinds;
+	mLastFrameDrawCalls = mDrawCalls;
+	mStateChanges = 0;
+	mTextureBinds = 0;
+	mDrawCalls = 0;
+	Invalidate();
+}
+
+/** Forget cached state, e.g. after code outside the cache has changed it. */
+void RenderState::Invalidate(void)
+{
+	mLighting = -1;
+	mBlending = -1;
+	mPremultiplied = -1;
+	mTexturing = -1;
+	mTextureKnown = false;
+	mTextureID = 0;
+}
+
+/** Set all the state required by a material, skipping anything already set. */
+void RenderState::ApplyMaterial(RenderMaterial material)
+{
+	switch (material)
+	{
+	case RENDER_MATERIAL_LINES:
+		SetLighting(false);
+		SetBlending(false);
+		SetTexturing(false);
+		break;
+	case RENDER_MATERIAL_SPRITE:
+		// Sprites are lit by the ambient light set up by the game
+		SetLighting(true);
+		SetBlending(true);
+		SetTexturing(true);
+		break;
+	case RENDER_MATERIAL_TEXT:
+		SetLighting(false);
+		SetBlending(false);
+		SetTexturing(false);
+		break;
+	case RENDER_MATERIAL_GLYPHS:
+		// Glyphs are tinted by glColor
+		SetLighting(false);
+		SetBlending(true);
+		SetTexturing(true);
+		break;
+	case RENDER_MATERIAL_OVERLAY:
+		// The cached display overlay was drawn over a transparent background,
+		// so its colours are already multiplied by its alpha
+		SetLighting(false);
+		SetBlending(true, true);
+		SetTexturing(true);
+		break;
+	}
+}
+
+/** Enable or disable alpha blending, of colours either not yet multiplied by their alpha or already multiplied. */
+void RenderState::SetBlending(bool enabled, bool premultiplied)
+{
+	int value = premultiplied ? 1 : 0;
+	if (enabled && mPremultiplied != value) {
+		glBlendFunc(premultiplied ? GL_ONE : GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		mPremultiplied = value;
+		mStateChanges++;
+	}
+	SetCapability(GL_BLEND, enabled, mBlending);
+}
+
+/** Bind a 2D texture if it is not already bound. */
+void RenderState::BindTexture(uint texture_id)
+{
+	if (mTextureKnown && mTextureID == texture_id) return;
+	glBindTexture(GL_TEXTURE_2D, texture_id);
+	mTextureKnown = true;
+	mTextureID = texture_id;
+	mTextureBinds++;
+}
+
+/** Stop treating a deleted texture as bound, as GL may reuse its id. */
+void RenderState::ForgetTexture(uint texture_id)
+{
+	if (mTextureKnown && mTextureID == texture_id) mTextureKnown = false;
+}
+
+/** Whether the context is at least the given GL version. Windows' generic GDI
+	renderer is only 1.1, so features from later versions must be checked for. */
+bool RenderState::IsVersionAtLeast(int major, int minor)
+{
+	if (mVersionMajor < 0) {
+		// Starts "major.minor", then anything the vendor adds
+		const char* version = (const char*)glGetString(GL_VERSION);
+		if (version == NULL || sscanf(version, "%d.%d", &mVersionMajor, &mVersionMinor) != 2) {
+			// No context yet, so ask again next time
+			mVersionMajor = mVersionMinor = -1;
+			return false;
+		}
+	}
+	return mVersionMajor > major || (mVersionMajor == major && mVersionMinor >= minor);
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+/** Enable or disable a GL capability if it differs from the cached value. */
+void RenderState::SetCapability(GLenum capability, bool enabled, int& current)
+{
+	int value = enabled ? 1 : 0;
+	if (current == value) return;
+	if (enabled) { glEnable(capability); } else { glDisable(capability); }
+	current = value;
+	mStateChanges++;
+}
@@ -0,0 +1,72 @@
+#ifndef __RENDERSTATE_H__
+#define __RENDERSTATE_H__
+
+#include "GameUtil.h"
+
+// Fixed combinations of GL state used by the different kinds of draw command
+enum RenderMaterial
+{
+	RENDER_MATERIAL_LINES,
+	RENDER_MATERIAL_SPRITE,
+	RENDER_MATERIAL_TEXT,
+	RENDER_MATERIAL_GLYPHS,
+	RENDER_MATERIAL_OVERLAY,
+};
+
+class RenderState
+{
+public:
+	inline static RenderState& GetInstance(void)
+	{
+		static RenderState mInstance;
+		return mInstance;
+	}
+
+	void BeginFrame(void);
+	void Invalidate(void);
+
+	void ApplyMaterial(RenderMaterial material);
+	void SetLighting(bool enabled) { SetCapability(GL_LIGHTING, enabled, mLighting); }
+	void SetBlending(bool enabled, bool premultiplied = false);
+	void SetTexturing(bool enabled) { SetCapability(GL_TEXTURE_2D, enabled, mTexturing); }
+	void BindTexture(uint texture_id);
+	void ForgetTexture(uint texture_id);
+	void CountDrawCall(void) { mDrawCalls++; }
+
+	// The version of the current context, read from GL_VERSION on first use
+	bool IsVersionAtLeast(int major, int minor);
+
+	uint GetStateChanges() const { return mStateChanges; }
+	uint GetTextureBinds() const { return mTextureBinds; }
+	uint GetBoundTexture() const { return mTextureKnown ? mTextureID : 0; }
+	uint GetDrawCalls() const { return mDrawCalls; }
+	uint GetLastFrameStateChanges() const { return mLastFrameStateChanges; }
+	uint GetLastFrameTextureBinds() const { return mLastFrameTextureBinds; }
+	uint GetLastFrameDrawCalls() const { return mLastFrameDrawCalls; }
+
+private:
+	RenderState();
+	~RenderState() {}
+
+	void SetCapability(GLenum capability, bool enabled, int& current);
+
+	// Cached values are -1 when unknown, otherwise 0 or 1
+	int mLighting;
+	int mBlending;
+	int mPremultiplied;
+	int mTexturing;
+	bool mTextureKnown;
+	uint mTextureID;
+	// -1 until a context has been asked for its version
+	int mVersionMajor;
+	int mVersionMinor;
+
+	uint mStateChanges;
+	uint mTextureBinds;
+	uint mDrawCalls;
+	uint mLastFrameStateChanges;
+	uint mLastFrameTextureBinds;
+	uint mLastFrameDrawCalls;
+};
+
+#endif
\ No newline at end of file
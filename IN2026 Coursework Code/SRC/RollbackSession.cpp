@@ -0,0 +1,406 @@
+#include <chrono>
+#include <string.h>
+#include "GameWorld.h"
+#include "IRollbackListener.h"
+#include "RollbackSession.h"
+
+static const uint NO_FRAME = 0xFFFFFFFF;
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Construct a session that steps the given world in time with a peer. */
+RollbackSession::RollbackSession(GameWorld* world)
+	: mWorld(world),
+	  mListener(NULL),
+	  mLocalPlayer(0),
+	  mInputDelay(DEFAULT_INPUT_DELAY),
+	  mSynced(false),
+	  mPeerStarted(false),
+	  mPeerLost(false),
+	  mStartFrame(0),
+	  mStartChecksum(0),
+	  mWidth(0),
+	  mHeight(0),
+	  mFirstMispredicted(NO_FRAME),
+	  mPeerAck(0),
+	  mRemoteFrame(0),
+	  mRemoteAdvantage(0),
+	  mLastStallFrame(NO_FRAME),
+	  mLastSyncWaitFrame(NO_FRAME),
+	  mButtons(0),
+	  mFire(false),
+	  mNextChecksumFrame(0),
+	  mLastComparedFrame(NO_FRAME),
+	  mChecksumsMatched(0),
+	  mDesynced(false),
+	  mLastHelloTime(0),
+	  mLastSendTime(0),
+	  mLastHeard(0),
+	  mLastReportTime(0),
+	  mTotalBytesSent(0),
+	  mTotalBytesReceived(0),
+	  mBuffer(UdpSocket::MAX_PACKET_SIZE)
+{
+	memset(&mPeer, 0, sizeof(mPeer));
+	memset(mInputs, 0, sizeof(mInputs));
+	memset(mConfirmed, 0, sizeof(mConfirmed));
+	memset(mPredicted, 0, sizeof(mPredicted));
+	memset(mChecksums, 0xFF, sizeof(mChecksums));
+	memset(&mReportStats, 0, sizeof(mReportStats));
+	memset(&mTotalStats, 0, sizeof(mTotalStats));
+}
+
+/** Destructor. */
+RollbackSession::~RollbackSession()
+{
+	Close();
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Open a socket on the given port and start looking for the peer, playing as player 0 or 1.
+	The world is held still until the two of them have agreed to start. */
+bool RollbackSession::Open(unsigned short port, const NetAddress& peer, uint player)
+{
+	if (player >= NUM_PLAYERS) { cerr << "There is no player " << player + 1 << endl; return false; }
+	if (!mSocket.Open(port)) return false;
+	mPeer = peer;
+	mLocalPlayer = player;
+	mWorld->SetStepListener(this);
+	mLastReportTime = GetMillis();
+	cout << "Playing as player " << player + 1 << " on port " << mSocket.GetPort()
+		<< ", waiting for " << UdpSocket::FormatAddress(peer) << endl;
+	return true;
+}
+
+/** Tell the peer we are leaving, report how rollbacks went and close the socket. */
+void RollbackSession::Close(void)
+{
+	if (!mSocket.IsOpen()) return;
+	if (mSynced && !mPeerLost) {
+		NetProtocol::WriteHeader(mPacket, NET_MESSAGE_DISCONNECT);
+		mSocket.Send(mPeer, mPacket.data(), (uint)mPacket.size());
+	}
+	PrintStats("In total", mTotalStats);
+	cout << "Checksums matched the peer's at " << mChecksumsMatched << " frames"
+		<< (mDesynced ? ", then went out of sync" : "") << endl;
+	cout << "Sent " << mTotalBytesSent << " bytes, received " << mTotalBytesReceived << " bytes" << endl;
+	mSocket.Close();
+}
+
+/** Roll back if the peer's input shows a guess was wrong, then decide whether the next step
+	can go ahead. It is held back while the peer is too far behind to roll back to. */
+bool RollbackSession::OnStepStarting(GameWorld* world)
+{
+	if (!mSocket.IsOpen()) return true;
+	uint now = GetMillis();
+	Receive(now);
+	if (!mSynced) {
+		// Carry on alone if the peer will not play this game
+		if (mPeerLost) return true;
+		if (now - mLastHelloTime >= HELLO_INTERVAL_MILLIS) SendHello(now);
+		mConditioner.Flush(mSocket);
+		return false;
+	}
+	if (!mPeerStarted && now - mLastHelloTime >= HELLO_INTERVAL_MILLIS) SendHello(now);
+	if (!mPeerLost && now - mLastHeard > TIMEOUT_MILLIS) {
+		cout << "Lost connection to peer" << endl;
+		mPeerLost = true;
+	}
+
+	uint frame = mWorld->GetClock().GetStepCount();
+	uint local = mLocalPlayer;
+	uint remote = 1 - mLocalPlayer;
+	// Without a peer, carry on as if it had let go of everything
+	if (mPeerLost) {
+		while (mConfirmed[remote] <= frame) mInputs[remote][mConfirmed[remote]++ % INPUT_HISTORY] = 0;
+	} else if (mFirstMispredicted < frame) {
+		Rollback(frame);
+	}
+	mFirstMispredicted = NO_FRAME;
+
+	// Local input is used a few frames after it is taken, so it has time to reach the peer first
+	if (mConfirmed[local] <= frame + mInputDelay) {
+		if (mListener) mListener->OnRollbackFrame(this, frame);
+		mInputs[local][mConfirmed[local]++ % INPUT_HISTORY] = (uchar)(mButtons | (mFire ? NET_INPUT_FIRE : 0));
+		mFire = false;
+		SendInput(now);
+	} else if (now - mLastSendTime >= RESEND_INTERVAL_MILLIS) {
+		SendInput(now);
+	}
+	mConditioner.Flush(mSocket);
+
+	if (now - mLastReportTime >= REPORT_INTERVAL_MILLIS) {
+		PrintStats("Rollback", mReportStats);
+		memset(&mReportStats, 0, sizeof(mReportStats));
+		mLastReportTime = now;
+	}
+
+	// The oldest snapshot kept is as far back as a wrong guess can be put right
+	if (frame >= mConfirmed[remote] + MAX_ROLLBACK_FRAMES) {
+		if (mLastStallFrame != frame) {
+			mReportStats.stalled_frames++;
+			mTotalStats.stalled_frames++;
+			mLastStallFrame = frame;
+		}
+		return false;
+	}
+	// Both peers see the other as ahead by the time a packet takes to arrive, so half the
+	// difference is how far ahead this one really is. If it is, let the peer catch up.
+	int lead = ((int)(frame - mRemoteFrame) - mRemoteAdvantage) / 2;
+	if (!mPeerLost && frame % SYNC_WAIT_FRAMES == 0 && mLastSyncWaitFrame != frame && lead >= 1) {
+		mLastSyncWaitFrame = frame;
+		mReportStats.sync_waits++;
+		mTotalStats.sync_waits++;
+		return false;
+	}
+
+	// The world is the same size for both, whatever size their windows are
+	mWorld->SetWidth(mWidth);
+	mWorld->SetHeight(mHeight);
+	mWorld->TakeSnapshot(mSnapshots[frame % (MAX_ROLLBACK_FRAMES + 1)]);
+	RecordChecksums(frame);
+	ApplyInputs(frame);
+	return true;
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+void RollbackSession::Receive(uint now)
+{
+	NetAddress from;
+	int size;
+	while ((size = mSocket.Receive(from, &mBuffer[0], (uint)mBuffer.size())) >= 0) {
+		NetMessageType type;
+		if (from != mPeer || !NetProtocol::ReadHeader(&mBuffer[0], (uint)size, type)) continue;
+		mLastHeard = now;
+		mTotalBytesReceived += size + NetProtocol::PACKET_OVERHEAD;
+		const char* body = &mBuffer[sizeof(NetMessageHeader)];
+		uint body_size = (uint)size - sizeof(NetMessageHeader);
+		switch (type) {
+		case NET_MESSAGE_PEER_HELLO: HandleHello(body, body_size); break;
+		case NET_MESSAGE_PEER_INPUT: HandleInput(body, body_size); break;
+		case NET_MESSAGE_DISCONNECT:
+			if (mSynced && !mPeerLost) cout << "Peer left" << endl;
+			mPeerLost = true;
+			break;
+		default: break;
+		}
+	}
+}
+
+/** Start once the peer is known to be playing the same game as the other player. */
+void RollbackSession::HandleHello(const char* data, uint size)
+{
+	NetPeerHello hello;
+	if (mSynced || mPeerLost || size < sizeof(hello)) return;
+	memcpy(&hello, data, sizeof(hello));
+	uint frame = mWorld->GetClock().GetStepCount();
+	if (hello.player == mLocalPlayer) {
+		cerr << "Both peers are player " << mLocalPlayer + 1 << ", give one of them --player " << 2 - mLocalPlayer << endl;
+		mPeerLost = true;
+		return;
+	}
+	if (hello.frame != frame || hello.checksum != mWorld->GetStateChecksum()) {
+		cerr << "Peer is playing a different game, both need the same --seed" << endl;
+		mPeerLost = true;
+		return;
+	}
+	// The second player plays in the first player's world
+	mWidth = mWorld->GetWidth();
+	mHeight = mWorld->GetHeight();
+	if (mLocalPlayer == 1) {
+		mWidth = hello.width;
+		mHeight = hello.height;
+		mInputDelay = min(hello.input_delay, MAX_INPUTS_PER_PACKET / 2);
+	}
+	Start(frame);
+}
+
+/** Take the peer's inputs in order, noting the first that differs from what was guessed for a frame already simulated. */
+void RollbackSession::HandleInput(const char* data, uint size)
+{
+	NetPeerInput input;
+	if (!mSynced || mPeerLost || size < sizeof(input)) return;
+	memcpy(&input, data, sizeof(input));
+	if (size - sizeof(input) < input.count) return;
+	mPeerStarted = true;
+
+	const uchar* buttons = (const uchar*)data + sizeof(input);
+	uint remote = 1 - mLocalPlayer;
+	uint simulated = mWorld->GetClock().GetStepCount();
+	for (uint i = 0; i < input.count; i++) {
+		uint frame = input.start_frame + i;
+		if (frame < mConfirmed[remote]) continue;
+		if (frame > mConfirmed[remote]) break;
+		mInputs[remote][frame % INPUT_HISTORY] = buttons[i];
+		if (frame < simulated && buttons[i] != mPredicted[frame % INPUT_HISTORY]) mFirstMispredicted = min(mFirstMispredicted, frame);
+		mConfirmed[remote]++;
+	}
+	if (input.ack_frame > mPeerAck) mPeerAck = input.ack_frame;
+	if ((int)(input.frame - mRemoteFrame) >= 0) {
+		mRemoteFrame = input.frame;
+		mRemoteAdvantage = input.advantage;
+	}
+	if (input.check_frame != NO_FRAME) CompareChecksum(input.check_frame, input.checksum);
+}
+
+/** Start both players at the given frame with nothing pressed for the first input delay frames. */
+void RollbackSession::Start(uint frame)
+{
+	mSynced = true;
+	mStartFrame = frame;
+	mStartChecksum = mWorld->GetStateChecksum();
+	for (uint player = 0; player < NUM_PLAYERS; player++) {
+		mConfirmed[player] = frame;
+		while (mConfirmed[player] < frame + mInputDelay) mInputs[player][mConfirmed[player]++ % INPUT_HISTORY] = 0;
+	}
+	mPeerAck = mConfirmed[mLocalPlayer];
+	mRemoteFrame = frame;
+	mNextChecksumFrame = frame;
+	mLastHeard = GetMillis();
+	cout << "Playing against " << UdpSocket::FormatAddress(mPeer) << " with " << mInputDelay << " frames of input delay" << endl;
+}
+
+/** Go back to the first frame simulated with a wrong guess and simulate up to frame again with what is now known. */
+void RollbackSession::Rollback(uint frame)
+{
+	uint from = mFirstMispredicted;
+	if (frame - from > MAX_ROLLBACK_FRAMES) {
+		cerr << "Unable to roll back " << frame - from << " frames" << endl;
+		return;
+	}
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	mWorld->RestoreSnapshot(mSnapshots[from % (MAX_ROLLBACK_FRAMES + 1)]);
+	for (uint f = from; f < frame; f++) {
+		if (f > from) mWorld->TakeSnapshot(mSnapshots[f % (MAX_ROLLBACK_FRAMES + 1)]);
+		ApplyInputs(f);
+		mWorld->Step();
+	}
+	double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+	RollbackStats* stats[] = { &mReportStats, &mTotalStats };
+	for (uint i = 0; i < 2; i++) {
+		stats[i]->rollbacks++;
+		stats[i]->frames += frame - from;
+		stats[i]->millis += millis;
+		stats[i]->max_frames = max(stats[i]->max_frames, frame - from);
+		stats[i]->max_millis = max(stats[i]->max_millis, millis);
+	}
+}
+
+/** Give the listener each player's buttons for a frame, guessing any not yet known. */
+void RollbackSession::ApplyInputs(uint frame)
+{
+	for (uint player = 0; player < NUM_PLAYERS; player++) {
+		uint buttons;
+		if (frame < mConfirmed[player]) {
+			buttons = mInputs[player][frame % INPUT_HISTORY];
+		} else {
+			buttons = PredictInput(player);
+			mPredicted[frame % INPUT_HISTORY] = (uchar)buttons;
+		}
+		if (mListener) mListener->OnRollbackInput(this, player, buttons);
+	}
+}
+
+/** Players mostly hold buttons down for many frames, so guess the last buttons are still held. Shots are one frame long. */
+uint RollbackSession::PredictInput(uint player) const
+{
+	if (mConfirmed[player] == mStartFrame) return 0;
+	return mInputs[player][(mConfirmed[player] - 1) % INPUT_HISTORY] & ~NET_INPUT_FIRE;
+}
+
+/** Keep checksums of the world at frames both peers have all the inputs for, which must match theirs. */
+void RollbackSession::RecordChecksums(uint frame)
+{
+	uint remote = 1 - mLocalPlayer;
+	while (mNextChecksumFrame <= frame && mNextChecksumFrame <= mConfirmed[remote]) {
+		const WorldSnapshot& snapshot = mSnapshots[mNextChecksumFrame % (MAX_ROLLBACK_FRAMES + 1)];
+		if (snapshot.header.step_count == mNextChecksumFrame) {
+			FrameChecksum& checksum = mChecksums[(mNextChecksumFrame / SYNC_CHECK_FRAMES) % CHECKSUM_HISTORY];
+			checksum.frame = mNextChecksumFrame;
+			checksum.checksum = snapshot.GetChecksum();
+		}
+		mNextChecksumFrame += SYNC_CHECK_FRAMES;
+	}
+}
+
+void RollbackSession::CompareChecksum(uint frame, uint checksum)
+{
+	if (mLastComparedFrame != NO_FRAME && frame <= mLastComparedFrame) return;
+	const FrameChecksum& local = mChecksums[(frame / SYNC_CHECK_FRAMES) % CHECKSUM_HISTORY];
+	if (local.frame != frame) return;
+	mLastComparedFrame = frame;
+	if (local.checksum == checksum) {
+		if (!mDesynced) mChecksumsMatched++;
+	} else if (!mDesynced) {
+		cerr << "Out of sync with peer at frame " << frame << endl;
+		mDesynced = true;
+	}
+}
+
+void RollbackSession::SendHello(uint now)
+{
+	NetPeerHello hello;
+	hello.player = mLocalPlayer;
+	hello.frame = mSynced ? mStartFrame : mWorld->GetClock().GetStepCount();
+	hello.checksum = mSynced ? mStartChecksum : mWorld->GetStateChecksum();
+	hello.width = mSynced ? mWidth : mWorld->GetWidth();
+	hello.height = mSynced ? mHeight : mWorld->GetHeight();
+	hello.input_delay = mInputDelay;
+	NetProtocol::WriteHeader(mPacket, NET_MESSAGE_PEER_HELLO);
+	mPacket.append((const char*)&hello, sizeof(hello));
+	SendPacket(mPacket);
+	mLastHelloTime = now;
+}
+
+/** Send every local input the peer has not acknowledged, up to a packet's worth. */
+void RollbackSession::SendInput(uint now)
+{
+	uint local = mLocalPlayer;
+	uint frame = mWorld->GetClock().GetStepCount();
+	NetPeerInput input;
+	input.frame = frame;
+	input.ack_frame = mConfirmed[1 - local];
+	input.advantage = (int)(frame - mRemoteFrame);
+	input.start_frame = max(mPeerAck, mConfirmed[local] - min(mConfirmed[local] - mStartFrame, MAX_INPUTS_PER_PACKET));
+	input.count = mConfirmed[local] - input.start_frame;
+	// The latest checksum recorded
+	input.check_frame = NO_FRAME;
+	input.checksum = 0;
+	if (mNextChecksumFrame > mStartFrame) {
+		const FrameChecksum& checksum = mChecksums[((mNextChecksumFrame - SYNC_CHECK_FRAMES) / SYNC_CHECK_FRAMES) % CHECKSUM_HISTORY];
+		input.check_frame = checksum.frame;
+		input.checksum = checksum.checksum;
+	}
+	NetProtocol::WriteHeader(mPacket, NET_MESSAGE_PEER_INPUT);
+	mPacket.append((const char*)&input, sizeof(input));
+	for (uint f = input.start_frame; f < mConfirmed[local]; f++) mPacket.push_back((char)mInputs[local][f % INPUT_HISTORY]);
+	SendPacket(mPacket);
+	mLastSendTime = now;
+}
+
+void RollbackSession::SendPacket(const string& packet)
+{
+	mConditioner.Send(mSocket, mPeer, packet.data(), (uint)packet.size());
+	mTotalBytesSent += (uint)packet.size() + NetProtocol::PACKET_OVERHEAD;
+}
+
+/** Print how often the world was rolled back and what simulating it again cost, against the time there is to draw a frame. */
+void RollbackSession::PrintStats(const char* label, const RollbackStats& stats) const
+{
+	double frame_millis = stats.frames ? stats.millis / stats.frames : 0;
+	cout << label << ": " << stats.rollbacks << " rollbacks of " << (stats.rollbacks ? (double)stats.frames / stats.rollbacks : 0)
+		<< " frames on average (" << stats.max_frames << " at most, taking " << stats.max_millis << " ms), "
+		<< frame_millis << " ms a frame, so " << MAX_ROLLBACK_FRAMES << " frames take " << frame_millis * MAX_ROLLBACK_FRAMES
+		<< " ms of the " << 1000.0 / DISPLAY_RATE << " ms frame budget; " << stats.stalled_frames << " frames stalled, "
+		<< stats.sync_waits << " waits for the peer to catch up" << endl;
+}
+
+// PRIVATE STATIC METHODS /////////////////////////////////////////////////////
+
+uint RollbackSession::GetMillis(void)
+{
+	return (uint)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
\ No newline at end of file
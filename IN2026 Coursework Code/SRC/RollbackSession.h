@@ -0,0 +1,149 @@
+#ifndef __ROLLBACKSESSION_H__
+#define __ROLLBACKSESSION_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "IStepListener.h"
+#include "NetProtocol.h"
+#include "NetworkConditioner.h"
+#include "UdpSocket.h"
+#include "WorldSnapshot.h"
+
+class IRollbackListener;
+
+// Plays a two player game directly against another peer running the same
+// world. Each step goes ahead with the other player's input predicted from
+// the last it sent, so neither waits on the network. When the real input
+// arrives and differs, the world is put back to the snapshot taken before
+// the first wrong step and those steps are simulated again.
+class RollbackSession : public IStepListener
+{
+public:
+	static const uint NUM_PLAYERS = 2;
+	static const uint MAX_ROLLBACK_FRAMES = 8;
+	static const uint DEFAULT_INPUT_DELAY = 2;
+	static const uint INPUT_HISTORY = 128;
+	static const uint MAX_INPUTS_PER_PACKET = 64;
+	static const uint HELLO_INTERVAL_MILLIS = 500;
+	static const uint RESEND_INTERVAL_MILLIS = 20;
+	static const uint TIMEOUT_MILLIS = 5000;
+	static const uint REPORT_INTERVAL_MILLIS = 5000;
+	// How often the peers compare checksums, and check which of them is ahead
+	static const uint SYNC_CHECK_FRAMES = 100;
+	static const uint SYNC_WAIT_FRAMES = 10;
+	static const uint CHECKSUM_HISTORY = 8;
+	// Rollbacks should fit in a frame drawn at this rate
+	static const uint DISPLAY_RATE = 60;
+
+	RollbackSession(GameWorld* world);
+	~RollbackSession();
+
+	bool Open(unsigned short port, const NetAddress& peer, uint player);
+	void Close(void);
+	bool IsOpen() const { return mSocket.IsOpen(); }
+	bool IsSynced() const { return mSynced; }
+	uint GetLocalPlayer() const { return mLocalPlayer; }
+	uint GetChecksumsMatched() const { return mChecksumsMatched; }
+	bool IsDesynced() const { return mDesynced; }
+	uint GetRollbackCount() const { return mTotalStats.rollbacks; }
+
+	void SetInputDelay(uint frames) { mInputDelay = min(frames, MAX_INPUTS_PER_PACKET / 2); }
+	uint GetInputDelay() const { return mInputDelay; }
+	void SetListener(IRollbackListener* listener) { mListener = listener; }
+	NetworkConditioner& GetConditioner() { return mConditioner; }
+
+	void SetButtons(uint buttons) { mButtons = buttons; }
+	uint GetButtons() const { return mButtons; }
+	void Fire(void) { mFire = true; }
+
+	// Declaration of IStepListener interface ///////////////////////////////////
+
+	bool OnStepStarting(GameWorld* world);
+
+private:
+	struct RollbackStats
+	{
+		uint rollbacks;
+		uint frames;
+		double millis;
+		uint max_frames;
+		double max_millis;
+		uint stalled_frames;
+		uint sync_waits;
+	};
+	struct FrameChecksum
+	{
+		uint frame;
+		uint checksum;
+	};
+
+	void Receive(uint now);
+	void HandleHello(const char* data, uint size);
+	void HandleInput(const char* data, uint size);
+	void Start(uint frame);
+	void Rollback(uint frame);
+	void ApplyInputs(uint frame);
+	uint PredictInput(uint player) const;
+	void RecordChecksums(uint frame);
+	void CompareChecksum(uint frame, uint checksum);
+	void SendHello(uint now);
+	void SendInput(uint now);
+	void SendPacket(const string& packet);
+	void PrintStats(const char* label, const RollbackStats& stats) const;
+
+	static uint GetMillis(void);
+
+	GameWorld* mWorld;
+	IRollbackListener* mListener;
+	UdpSocket mSocket;
+	NetworkConditioner mConditioner;
+	NetAddress mPeer;
+	uint mLocalPlayer;
+	uint mInputDelay;
+
+	bool mSynced;
+	bool mPeerStarted;
+	bool mPeerLost;
+	uint mStartFrame;
+	uint mStartChecksum;
+	int mWidth;
+	int mHeight;
+
+	// Inputs are known for each player's frames before mConfirmed
+	uchar mInputs[NUM_PLAYERS][INPUT_HISTORY];
+	uint mConfirmed[NUM_PLAYERS];
+	// What the other player's input was guessed to be for each frame
+	uchar mPredicted[INPUT_HISTORY];
+	uint mFirstMispredicted;
+	// The first of our frames the peer has not had
+	uint mPeerAck;
+	uint mRemoteFrame;
+	int mRemoteAdvantage;
+	uint mLastStallFrame;
+	uint mLastSyncWaitFrame;
+
+	uint mButtons;
+	bool mFire;
+
+	// The world before each frame that could still be rolled back
+	WorldSnapshot mSnapshots[MAX_ROLLBACK_FRAMES + 1];
+	FrameChecksum mChecksums[CHECKSUM_HISTORY];
+	uint mNextChecksumFrame;
+	uint mLastComparedFrame;
+	uint mChecksumsMatched;
+	bool mDesynced;
+
+	uint mLastHelloTime;
+	uint mLastSendTime;
+	uint mLastHeard;
+	uint mLastReportTime;
+	RollbackStats mReportStats;
+	RollbackStats mTotalStats;
+	uint mTotalBytesSent;
+	uint mTotalBytesReceived;
+
+	vector<char> mBuffer;
+	string mPacket;
+};
+
+#endif
\ No newline at end of file
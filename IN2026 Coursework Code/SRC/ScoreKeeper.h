@@ -5,13 +5,14 @@
 
 #include "GameObject.h"
 #include "GameObjectType.h"
+#include "ObservableValue.h"
 #include "IScoreListener.h"
 #include "IGameWorldListener.h"
 
 class ScoreKeeper : public IGameWorldListener
 {
 public:
-	ScoreKeeper() { mScore = 0; }
+	ScoreKeeper() : mScore(0) {}
 	virtual ~ScoreKeeper() {}
 
 	void OnWorldUpdated(GameWorld* world) {}
@@ -20,31 +21,23 @@ public:
 	void OnObjectRemoved(GameWorld* world, shared_ptr<GameObject> object)
 	{
 		if (object->GetType() == GameObjectType("Asteroid")) {
- 			mScore += 10;
-			FireScoreChanged();
+ 			mScore.Set(mScore.Get() + 10);
 		}
 	}
 
 	void AddListener(shared_ptr<IScoreListener> listener)
 	{
-		mListeners.push_back(listener);
+		mScore.AddListener([listener](const int& score) { listener->OnScoreChanged(score); });
 	}
 
+	// Listeners hear the final score once per frame, however many asteroids were destroyed
 	void FireScoreChanged()
 	{
-		// Send message to all listeners
-		for (ScoreListenerList::iterator lit = mListeners.begin(); lit != mListeners.end(); ++lit) {
-			(*lit)->OnScoreChanged(mScore);
-		}
+		// Send message to all listeners if the score has changed
+		mScore.Publish();
 	}
 
-	int mScore;
-
-private:
-
-	typedef std::list< shared_ptr<IScoreListener> > ScoreListenerList;
-
-	ScoreListenerList mListeners;
+	ObservableValue<int> mScore;
 };
 
 #endif
@@ -1,61 +1,212 @@
 #include "GameUtil.h"
 #include "Shape.h"
+#include "RenderState.h"
 
 using namespace std;
 
+uint Shape::mNextShapeID = 1;
+
+const char Shape::COMPILED_SHAPE_MAGIC[4] = { 'S', 'H', 'P', 'B' };
+
 Shape::Shape()
+	: mShapeID(mNextShapeID++), mLoop(false), mRGB(1, 1, 1), mSourceHash(0), mDisplayList(0)
 {
 }
 
 Shape::Shape(const string& shape_filename)
+	: mShapeID(mNextShapeID++), mLoop(false), mRGB(1, 1, 1), mSourceHash(0), mDisplayList(0)
 {
 	LoadShape(shape_filename);
 }
 
 Shape::~Shape()
 {
+	ReleaseDisplayList();
 }
 
 void Shape::Render(void)
 {
 	// Disable lighting for solid colour lines
-	glDisable(GL_LIGHTING);
-	// Start drawing lines
-	if (mLoop) { glBegin(GL_LINE_LOOP); }
-	else { glBegin(GL_LINE_STRIP); }
-	// Set rgb colour
-	glColor3f(mRGB[0], mRGB[1], mRGB[2]);
-	// Add vertices to draw shape
-	for (GLVector2fList::iterator it = mPoints.begin(); it != mPoints.end(); ++it) {
-		shared_ptr<GLVector2f> vec = (*it);
-		glVertex2f(vec->x, vec->y);
+	RenderState::GetInstance().ApplyMaterial(RENDER_MATERIAL_LINES);
+	Draw();
+}
+
+void Shape::Draw(void)
+{
+	// Geometry is compiled once and replayed with a single call
+	if (mDisplayList == 0) CompileDisplayList();
+	glCallList(mDisplayList);
+	RenderState::GetInstance().CountDrawCall();
+}
+
+void Shape::DrawInstances(const ShapeInstance* instances, uint count)
+{
+	uint num_points = (uint)mPoints.size();
+	if (count == 0 || num_points < 2) return;
+
+	// Lines strips and loops cannot be joined, so draw every copy as separate segments
+	uint num_segments = mLoop ? num_points : num_points - 1;
+	mInstanceVertices.resize(count * num_segments * 6);
+	GLfloat* out = &mInstanceVertices[0];
+
+	for (uint i = 0; i < count; i++) {
+		// Same transform as GameObject::PreRender: translate, rotate about z, then scale
+		const ShapeInstance& instance = instances[i];
+		GLfloat c = (GLfloat)cos(DEG2RAD*instance.angle) * instance.scale;
+		GLfloat s = (GLfloat)sin(DEG2RAD*instance.angle) * instance.scale;
+		for (uint j = 0; j < num_segments; j++) {
+			const GLVector2f& p1 = mPoints[j];
+			const GLVector2f& p2 = mPoints[(j + 1) % num_points];
+			*out++ = instance.position.x + c*p1.x - s*p1.y;
+			*out++ = instance.position.y + s*p1.x + c*p1.y;
+			*out++ = instance.position.z;
+			*out++ = instance.position.x + c*p2.x - s*p2.y;
+			*out++ = instance.position.y + s*p2.x + c*p2.y;
+			*out++ = instance.position.z;
+		}
 	}
-	// Finish drawing lines
-	glEnd();
-	// Enable lighting
-	glEnable(GL_LIGHTING);
 
+	glColor3f(mRGB[0], mRGB[1], mRGB[2]);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, &mInstanceVertices[0]);
+	glDrawArrays(GL_LINES, 0, count * num_segments * 2);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	RenderState::GetInstance().CountDrawCall();
 }
 
-void Shape::LoadShape(const string& shape_filename)
+bool Shape::LoadShape(const string& shape_filename)
 {
 	string filename = "";
 	filename += shape_filename;
 	ifstream shape_file(filename.c_str(), ios::in | ios::binary);
 
-	if (!shape_file) { cerr << "Error opening " << shape_filename; exit(1); }
+	if (!shape_file) { cerr << "Error opening " << shape_filename << endl; return false; }
+
+	// Compiled shapes are read into memory with a single read
+	char magic[4] = { 0, 0, 0, 0 };
+	shape_file.read(magic, sizeof(magic));
+	if (0 == memcmp(magic, COMPILED_SHAPE_MAGIC, sizeof(magic))) {
+		shape_file.seekg(0, ios::end);
+		size_t size = (size_t)shape_file.tellg();
+		vector<char> data(size);
+		shape_file.seekg(0, ios::beg);
+		shape_file.read(&data[0], size);
+		if (shape_file && LoadCompiledShape(&data[0], size)) return true;
+		cerr << "Error reading compiled shape " << shape_filename << endl;
+		return false;
+	}
+
+	// Text shapes are hashed as they are read, so a compiled copy can be checked against them
+	shape_file.clear();
+	shape_file.seekg(0, ios::beg);
+	string source((istreambuf_iterator<char>(shape_file)), istreambuf_iterator<char>());
+	mSourceHash = HashSource(source.data(), source.size());
+	istringstream source_stream(source);
+	if (ParseShape(source_stream)) return true;
+	cerr << "Error parsing " << shape_filename << endl;
+	return false;
+}
+
+bool Shape::LoadCompiledShape(const char* data, size_t size)
+{
+	if (size < sizeof(CompiledShapeHeader)) return false;
+	CompiledShapeHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (0 != memcmp(header.magic, COMPILED_SHAPE_MAGIC, sizeof(header.magic))) return false;
+	if (header.version != COMPILED_SHAPE_VERSION) return false;
+	if (header.num_points > (size - sizeof(header)) / (2 * sizeof(GLfloat))) return false;
+
+	mSourceHash = header.source_hash;
+	mLoop = (header.loop != 0);
+	mRGB = GLVector3f(header.rgb[0], header.rgb[1], header.rgb[2]);
+	mPoints.resize(header.num_points);
+	const char* point_data = data + sizeof(header);
+	for (uint i = 0; i < header.num_points; i++) {
+		GLfloat xy[2];
+		memcpy(xy, point_data + i * sizeof(xy), sizeof(xy));
+		mPoints[i] = GLVector2f(xy[0], xy[1]);
+	}
+
+	// Geometry has changed so any compiled copy is out of date
+	ReleaseDisplayList();
+	return true;
+}
+
+bool Shape::SaveCompiledShape(const string& compiled_filename)
+{
+	ofstream compiled_file(compiled_filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!compiled_file) { cerr << "Error opening " << compiled_filename << endl; return false; }
+	return SaveCompiledShape(compiled_file);
+}
+
+bool Shape::SaveCompiledShape(ostream& compiled_stream)
+{
+	CompiledShapeHeader header;
+	memcpy(header.magic, COMPILED_SHAPE_MAGIC, sizeof(header.magic));
+	header.version = COMPILED_SHAPE_VERSION;
+	header.source_hash = mSourceHash;
+	header.loop = mLoop ? 1 : 0;
+	header.rgb[0] = mRGB[0];
+	header.rgb[1] = mRGB[1];
+	header.rgb[2] = mRGB[2];
+	header.num_points = (uint)mPoints.size();
+	compiled_stream.write((const char*)&header, sizeof(header));
+	for (uint i = 0; i < mPoints.size(); i++) {
+		GLfloat xy[2] = { mPoints[i].x, mPoints[i].y };
+		compiled_stream.write((const char*)xy, sizeof(xy));
+	}
+	return compiled_stream.good();
+}
+
+/** FNV-1a hash of a text shape file's bytes. */
+uint Shape::HashSource(const char* data, size_t size)
+{
+	uint hash = 2166136261u;
+	for (size_t i = 0; i < size; i++) hash = (hash ^ (uchar)data[i]) * 16777619u;
+	return hash;
+}
 
+bool Shape::ParseShape(istream& shape_stream)
+{
 	string s;
-	shape_file >> s;
+	if (!(shape_stream >> s)) return false;
 	if (0 == s.compare("loop")) { mLoop = true; }
 	else { mLoop = false; }
 
-	shape_file >> mRGB;
-	while (!shape_file.eof()) {
-		float x, y;
-		shape_file >> x >> y;
-		shared_ptr<GLVector2f> vec(new GLVector2f(x, y));
-		mPoints.push_back(vec);
+	if (!(shape_stream >> mRGB)) return false;
+	mPoints.clear();
+	// Only keep complete coordinate pairs, so a missing newline at the end of
+	// the file no longer repeats the final vertex
+	float x, y;
+	while (shape_stream >> x >> y) {
+		mPoints.push_back(GLVector2f(x, y));
 	}
 
+	// Geometry has changed so any compiled copy is out of date
+	ReleaseDisplayList();
+	return true;
 }
+
+void Shape::CompileDisplayList(void)
+{
+	mDisplayList = glGenLists(1);
+	glNewList(mDisplayList, GL_COMPILE);
+	// Start drawing lines
+	if (mLoop) { glBegin(GL_LINE_LOOP); }
+	else { glBegin(GL_LINE_STRIP); }
+	// Set rgb colour
+	glColor3f(mRGB[0], mRGB[1], mRGB[2]);
+	// Add vertices to draw shape
+	for (GLVector2fVector::const_iterator it = mPoints.begin(); it != mPoints.end(); ++it) {
+		glVertex2f(it->x, it->y);
+	}
+	// Finish drawing lines
+	glEnd();
+	glEndList();
+}
+
+void Shape::ReleaseDisplayList(void)
+{
+	if (mDisplayList != 0) glDeleteLists(mDisplayList, 1);
+	mDisplayList = 0;
+}
\ No newline at end of file
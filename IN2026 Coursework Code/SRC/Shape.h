@@ -1,30 +1,78 @@
 #ifndef __SHAPE_H__
 #define __SHAPE_H__
 
+#include <vector>
 #include "GameUtil.h"
 
 using namespace std;
 
-typedef list< shared_ptr<GLVector2f> > GLVector2fList;
+typedef vector<GLVector2f> GLVector2fVector;
+
+// Header of the compiled binary shape format, followed by 2*num_points floats
+struct CompiledShapeHeader
+{
+	char magic[4];
+	uint version;
+	// Hash of the text file it was compiled from, to tell when that has changed
+	uint source_hash;
+	uint loop;
+	GLfloat rgb[3];
+	uint num_points;
+};
+
+// Transform of one copy of a shape drawn by Shape::DrawInstances
+struct ShapeInstance
+{
+	GLVector3f position;
+	GLfloat angle;
+	GLfloat scale;
+};
 	
 class Shape
 {
 public:
+	static const char COMPILED_SHAPE_MAGIC[4];
+	static const uint COMPILED_SHAPE_VERSION = 2;
+
 	Shape();
 	Shape(const string& shape_filename);
 	virtual ~Shape();
 	
 	void Render(void);
+	void Draw(void);
+	void DrawInstances(const ShapeInstance* instances, uint count);
 
-	void LoadShape(const string& shape_filename);
+	bool LoadShape(const string& shape_filename);
+	bool LoadCompiledShape(const char* data, size_t size);
+	bool SaveCompiledShape(const string& compiled_filename);
+	bool SaveCompiledShape(ostream& compiled_stream);
 
+	uint GetShapeID() const { return mShapeID; }
 	const GLVector3f& GetRGBColour() { return mRGB; }
-	const GLVector2fList& GetPoints() { return mPoints; } 
+	const GLVector2fVector& GetPoints() { return mPoints; } 
+	uint GetSourceHash() const { return mSourceHash; }
+
+	static uint HashSource(const char* data, size_t size);
 
 private:
+	// Not copied, as each shape owns its display list
+	Shape(const Shape&);
+	Shape& operator=(const Shape&);
+
+	bool ParseShape(istream& shape_stream);
+	void CompileDisplayList(void);
+	void ReleaseDisplayList(void);
+
+	uint mShapeID;
 	bool mLoop;
 	GLVector3f mRGB;
-	GLVector2fList mPoints;
+	GLVector2fVector mPoints;
+	uint mSourceHash;
+
+	GLuint mDisplayList;
+	vector<GLfloat> mInstanceVertices;
+
+	static uint mNextShapeID;
 };
 
 #endif
\ No newline at end of file
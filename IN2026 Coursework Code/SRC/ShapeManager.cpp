@@ -0,0 +1,72 @@
+#include "AssetBundle.h"
+#include "Shape.h"
+#include "ShapeManager.h"
+
+/** Load a shape once, sharing the same geometry with every later request for the name. */
+shared_ptr<Shape> ShapeManager::CreateShapeFromFile(const string& name, const string& filename)
+{
+	shared_ptr<Shape> shape = GetShapeByName(name);
+	if (shape.get() != NULL) return shape;
+
+	// Prefer the compiled binary version of the shape if one has been built from
+	// the text file as it is now. Without the text file it is used as it is.
+	shape = make_shared<Shape>();
+	string compiled_filename = GetCompiledFilename(filename);
+	ifstream compiled_file(compiled_filename.c_str(), ios::in | ios::binary);
+	bool compiled = compiled_file.good();
+	compiled_file.close();
+	if (compiled && shape->LoadShape(compiled_filename)) {
+		ifstream source_file(filename.c_str(), ios::in | ios::binary);
+		if (source_file) {
+			string source((istreambuf_iterator<char>(source_file)), istreambuf_iterator<char>());
+			compiled = (shape->GetSourceHash() == Shape::HashSource(source.data(), source.size()));
+			if (!compiled) cerr << compiled_filename << " is out of date, reading " << filename << endl;
+		}
+	} else {
+		compiled = false;
+	}
+	if (!compiled && !shape->LoadShape(filename)) return shared_ptr<Shape>();
+
+	mShapeMap.insert(NamedShapeMap::value_type(name, shape));
+	return shape;
+}
+
+shared_ptr<Shape> ShapeManager::GetShapeByName(const string& name)
+{
+	NamedShapeMap::iterator it = mShapeMap.find(name);
+	return (it == mShapeMap.end()) ? shared_ptr<Shape>() : it->second;
+}
+
+/** Register every compiled shape in a bundle under its bundled name. Returns how many were created. */
+uint ShapeManager::CreateShapesFromBundle(const AssetBundle& bundle)
+{
+	uint created = 0;
+	for (uint i = 0; i < bundle.GetEntryCount(); i++) {
+		const AssetBundleEntry& entry = bundle.GetEntry(i);
+		if (entry.type != ASSET_BUNDLE_SHAPE || GetShapeByName(entry.name).get() != NULL) continue;
+		shared_ptr<Shape> shape = make_shared<Shape>();
+		if (!shape->LoadCompiledShape(bundle.GetData(entry), entry.size)) {
+			cerr << "Error reading bundled shape " << entry.name << endl;
+			continue;
+		}
+		mShapeMap.insert(NamedShapeMap::value_type(entry.name, shape));
+		created++;
+	}
+	return created;
+}
+
+/** Name of the compiled binary file built from a text shape file. */
+string ShapeManager::GetCompiledFilename(const string& filename)
+{
+	return filename + ".bin";
+}
+
+/** Offline step: parse a text shape file and write its compiled binary version. */
+bool ShapeManager::CompileShapeFile(const string& filename)
+{
+	Shape shape;
+	if (!shape.LoadShape(filename)) return false;
+	if (!shape.SaveCompiledShape(GetCompiledFilename(filename))) return false;
+	cout << "Compiled " << filename << " (" << shape.GetPoints().size() << " points)" << endl;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef __SHAPEMANAGER_H__
+#define __SHAPEMANAGER_H__
+
+#include "GameUtil.h"
+
+class Shape;
+class AssetBundle;
+
+class ShapeManager
+{
+public:
+	inline static ShapeManager& GetInstance(void)
+	{
+		static ShapeManager mInstance;
+		return mInstance;
+	}
+
+	shared_ptr<Shape> CreateShapeFromFile(const string& name, const string& filename);
+	shared_ptr<Shape> GetShapeByName(const string& name);
+	uint CreateShapesFromBundle(const AssetBundle& bundle);
+
+	static string GetCompiledFilename(const string& filename);
+	static bool CompileShapeFile(const string& filename);
+
+private:
+	ShapeManager() {} // Private constructor
+	~ShapeManager() {} // Private destructor
+
+	typedef map< string, shared_ptr<Shape> > NamedShapeMap;
+	NamedShapeMap mShapeMap;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "SimulationClock.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+SimulationClock::SimulationClock()
+	: mPaused(false),
+	  mFastForward(false),
+	  mTimeScale(1.0f),
+	  mAccumulator(0),
+	  mTime(0),
+	  mStepCount(0)
+{
+}
+
+/** Destructor. */
+SimulationClock::~SimulationClock()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Add some wall clock time and return how many steps are now due. After a long stall
+	only MAX_STEPS_PER_ADVANCE are returned and the rest is dropped, so the game slows
+	down rather than falling further behind trying to catch up. */
+uint SimulationClock::Advance(int real_msecs)
+{
+	if (mPaused || mFastForward || real_msecs <= 0) return 0;
+	mAccumulator += real_msecs * (double)mTimeScale;
+	uint steps = (uint)(mAccumulator / STEP_MILLIS);
+	if (steps > MAX_STEPS_PER_ADVANCE) {
+		mAccumulator = 0;
+		return MAX_STEPS_PER_ADVANCE;
+	}
+	mAccumulator -= steps * (double)STEP_MILLIS;
+	return steps;
+}
+
+/** Record that the world has been stepped on by STEP_MILLIS. */
+void SimulationClock::CountStep(void)
+{
+	mTime += STEP_MILLIS;
+	mStepCount++;
+}
+
+/** Go back or forward to a saved point in game time. */
+void SimulationClock::Restore(uint time, uint step_count)
+{
+	mTime = time;
+	mStepCount = step_count;
+	mAccumulator = 0;
+}
+
+void SimulationClock::SetPaused(bool paused)
+{
+	mPaused = paused;
+	// Don't make up for the time spent paused
+	mAccumulator = 0;
+}
+
+/** Set how fast game time runs compared to the wall clock, e.g. 0.25 for quarter speed. */
+void SimulationClock::SetTimeScale(float scale)
+{
+	mTimeScale = (scale > 0.0f) ? scale : 0.0f;
+}
+
+void SimulationClock::SetFastForward(bool enabled)
+{
+	mFastForward = enabled;
+	mAccumulator = 0;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef __SIMULATIONCLOCK_H__
+#define __SIMULATIONCLOCK_H__
+
+#include "GameUtil.h"
+
+// Turns wall clock time into a whole number of fixed simulation steps, so the
+// world runs the same however fast it is drawn. Game time can be paused or
+// scaled for slow motion. In fast-forward the caller steps the world as often
+// as it can instead, and the time scale no longer applies.
+class SimulationClock
+{
+public:
+	static const uint STEP_MILLIS = 10;
+	static const uint MAX_STEPS_PER_ADVANCE = 25;
+
+	SimulationClock();
+	~SimulationClock();
+
+	uint Advance(int real_msecs);
+	void CountStep(void);
+	void Restore(uint time, uint step_count);
+
+	void SetPaused(bool paused);
+	bool IsPaused() const { return mPaused; }
+	void TogglePause(void) { SetPaused(!mPaused); }
+
+	void SetTimeScale(float scale);
+	float GetTimeScale() const { return mTimeScale; }
+
+	void SetFastForward(bool enabled);
+	bool IsFastForward() const { return mFastForward; }
+	void ToggleFastForward(void) { SetFastForward(!mFastForward); }
+
+	uint GetTime() const { return mTime; }
+	uint GetStepCount() const { return mStepCount; }
+
+private:
+	bool mPaused;
+	bool mFastForward;
+	float mTimeScale;
+	// Scaled wall time not yet used up by a step
+	double mAccumulator;
+	uint mTime;
+	uint mStepCount;
+};
+
+#endif
\ No newline at end of file
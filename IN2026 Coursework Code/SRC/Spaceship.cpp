@@ -3,6 +3,8 @@
 #include "Bullet.h"
 #include "Spaceship.h"
 #include "BoundingSphere.h"
+#include "RenderQueue.h"
+#include "WorldSnapshot.h"
 
 using namespace std;
 
@@ -40,6 +42,19 @@ void Spaceship::Update(int t)
 	GameObject::Update(t);
 }
 
+/** Save this spaceship's thrust, which decides whether the thruster is drawn. */
+void Spaceship::SaveState(GameObjectState& state)
+{
+	GameObject::SaveState(state);
+	state.user_float = mThrust;
+}
+
+void Spaceship::RestoreState(const GameObjectState& state)
+{
+	GameObject::RestoreState(state);
+	mThrust = state.user_float;
+}
+
 /** Render this spaceship. */
 void Spaceship::Render(void)
 {
@@ -53,6 +68,19 @@ void Spaceship::Render(void)
 	GameObject::Render();
 }
 
+/** Submit this spaceship's shapes for rendering. */
+void Spaceship::Submit(RenderQueue& queue)
+{
+	if (mSpaceshipShape.get() != NULL) queue.SubmitShape(mRenderLayer, this, mSpaceshipShape.get());
+
+	// If ship is thrusting
+	if ((mThrust > 0) && (mThrusterShape.get() != NULL)) {
+		queue.SubmitShape(mRenderLayer, this, mThrusterShape.get());
+	}
+
+	GameObject::Submit(queue);
+}
+
 /** Fire the rockets. */
 void Spaceship::Thrust(float t)
 {
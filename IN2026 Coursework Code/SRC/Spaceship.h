@@ -15,6 +15,10 @@ public:
 
 	virtual void Update(int t);
 	virtual void Render(void);
+	virtual void Submit(RenderQueue& queue);
+
+	virtual void SaveState(GameObjectState& state);
+	virtual void RestoreState(const GameObjectState& state);
 
 	virtual void Thrust(float t);
 	virtual void Rotate(float r);
@@ -0,0 +1,93 @@
+#include <math.h>
+#include "SpatialGrid.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+SpatialGrid::SpatialGrid()
+	: mWidth(0),
+	  mHeight(0),
+	  mCellWidth(1.0f),
+	  mCellHeight(1.0f),
+	  mColumns(1),
+	  mRows(1)
+{
+}
+
+/** Destructor. */
+SpatialGrid::~SpatialGrid()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Index points in a world of the given size centred on the origin, replacing any indexed before. */
+void SpatialGrid::Build(int width, int height, float cell_size, const vector<GLVector2f>& points)
+{
+	mWidth = max(width, 1);
+	mHeight = max(height, 1);
+	cell_size = max(cell_size, 1.0f);
+	mColumns = max((int)(mWidth / cell_size), 1);
+	mRows = max((int)(mHeight / cell_size), 1);
+	mCellWidth = (float)mWidth / mColumns;
+	mCellHeight = (float)mHeight / mRows;
+	mPoints = points;
+
+	// Count the points in each cell, then place each one after those in the cells before it
+	mCellStart.assign(mColumns * mRows + 1, 0);
+	vector<uint> cells(points.size());
+	for (uint i = 0; i < points.size(); i++) {
+		cells[i] = GetRow(points[i].y) * mColumns + GetColumn(points[i].x);
+		mCellStart[cells[i] + 1]++;
+	}
+	for (uint c = 0; c + 1 < mCellStart.size(); c++) mCellStart[c + 1] += mCellStart[c];
+	mIndices.resize(points.size());
+	vector<uint> next(mCellStart.begin(), mCellStart.end() - 1);
+	for (uint i = 0; i < points.size(); i++) mIndices[next[cells[i]]++] = i;
+}
+
+/** Append the indices of the points within radius of (x, y), measured across the edges of the world where that is nearer. */
+void SpatialGrid::Query(float x, float y, float radius, vector<uint>& indices) const
+{
+	if (mPoints.empty()) return;
+	int column_reach = (int)ceil(radius / mCellWidth);
+	int row_reach = (int)ceil(radius / mCellHeight);
+	int columns = min(2 * column_reach + 1, mColumns);
+	int rows = min(2 * row_reach + 1, mRows);
+	int first_column = GetColumn(x) - min(column_reach, (mColumns - 1) / 2);
+	int first_row = GetRow(y) - min(row_reach, (mRows - 1) / 2);
+	for (int r = 0; r < rows; r++) {
+		int row = ((first_row + r) % mRows + mRows) % mRows;
+		for (int c = 0; c < columns; c++) {
+			int cell = row * mColumns + ((first_column + c) % mColumns + mColumns) % mColumns;
+			for (uint i = mCellStart[cell]; i < mCellStart[cell + 1]; i++) {
+				const GLVector2f& point = mPoints[mIndices[i]];
+				if (GetDistance(x, y, point.x, point.y) <= radius) indices.push_back(mIndices[i]);
+			}
+		}
+	}
+}
+
+/** The distance between two points, going the short way round the wrapped world. */
+float SpatialGrid::GetDistance(float x1, float y1, float x2, float y2) const
+{
+	float dx = fabs(x1 - x2);
+	float dy = fabs(y1 - y2);
+	if (dx > mWidth * 0.5f) dx = mWidth - dx;
+	if (dy > mHeight * 0.5f) dy = mHeight - dy;
+	return sqrt(dx * dx + dy * dy);
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+int SpatialGrid::GetColumn(float x) const
+{
+	int column = (int)floor((x + mWidth * 0.5f) / mCellWidth);
+	return ((column % mColumns) + mColumns) % mColumns;
+}
+
+int SpatialGrid::GetRow(float y) const
+{
+	int row = (int)floor((y + mHeight * 0.5f) / mCellHeight);
+	return ((row % mRows) + mRows) % mRows;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef __SPATIALGRID_H__
+#define __SPATIALGRID_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "GLVector.h"
+
+// Sorts points into square cells over a world that wraps at its edges, as
+// the game world does, so the points near a position can be found without
+// looking at every one. The points are indexed all at once, and each cell's
+// points are kept together in one array. Cells are stretched from the size
+// asked for so a whole number of them fit the world, as a part-filled cell
+// at the edge would leave gaps in searches that wrap across it.
+class SpatialGrid
+{
+public:
+	SpatialGrid();
+	~SpatialGrid();
+
+	void Build(int width, int height, float cell_size, const vector<GLVector2f>& points);
+	void Query(float x, float y, float radius, vector<uint>& indices) const;
+
+	float GetDistance(float x1, float y1, float x2, float y2) const;
+
+private:
+	int GetColumn(float x) const;
+	int GetRow(float y) const;
+
+	int mWidth;
+	int mHeight;
+	float mCellWidth;
+	float mCellHeight;
+	int mColumns;
+	int mRows;
+	vector<GLVector2f> mPoints;
+	// Points in cell c are mIndices[mCellStart[c]] up to mIndices[mCellStart[c + 1]]
+	vector<uint> mCellStart;
+	vector<uint> mIndices;
+};
+
+#endif
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "Texture.h"
 #include "Animation.h"
 #include "Sprite.h"
+#include "SpriteBatch.h"
+#include "RenderState.h"
+#include "TextureManager.h"
 
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
@@ -63,6 +66,13 @@ void Sprite::Update(int t)
 	}
 }
 
+void Sprite::SetAnimationState(int frame, int frame_millis, bool animating)
+{
+	mCurrentFrame = frame % mFrames;
+	mFrameMillis = frame_millis;
+	mAnimating = animating;
+}
+
 /*
 void Sprite::Render()
 {
@@ -95,16 +105,33 @@ void Sprite::Render()
 	float x2 = (float)(mWidth - mOffsetX);
 	float y2 = (float)(mHeight - mOffsetY);
 
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable(GL_BLEND);
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, mAnimation->GetFrameTextureID(mCurrentFrame));
+	const AnimationFrame& frame = mAnimation->GetFrame(mCurrentFrame);
+	RenderState::GetInstance().ApplyMaterial(RENDER_MATERIAL_SPRITE);
+	RenderState::GetInstance().BindTexture(TextureManager::GetInstance().UseTexture(frame.texture));
 	glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 0.0f); glVertex3f(x1, y1, 0.0f);
-		glTexCoord2f(1.0f, 0.0f); glVertex3f(x2, y1, 0.0f);
-		glTexCoord2f(1.0f, 1.0f); glVertex3f(x2, y2, 0.0f);
-		glTexCoord2f(0.0f, 1.0f); glVertex3f(x1, y2, 0.0f);
+		glTexCoord2f(frame.u1, frame.v1); glVertex3f(x1, y1, 0.0f);
+		glTexCoord2f(frame.u2, frame.v1); glVertex3f(x2, y1, 0.0f);
+		glTexCoord2f(frame.u2, frame.v2); glVertex3f(x2, y2, 0.0f);
+		glTexCoord2f(frame.u1, frame.v2); glVertex3f(x1, y2, 0.0f);
 	glEnd();
-	glDisable(GL_BLEND);
-	glDisable(GL_TEXTURE_2D);
+	RenderState::GetInstance().CountDrawCall();
+}
+
+/** Get the texture holding the current frame. */
+uint Sprite::GetTextureID() const
+{
+	return TextureManager::GetInstance().UseTexture(mAnimation->GetFrame(mCurrentFrame).texture);
+}
+
+/** Add this sprite to a batch instead of drawing it immediately. */
+void Sprite::Render(SpriteBatch& batch, const GLVector3f& position, GLfloat angle, GLfloat scale)
+{
+	float x1 = (float)(-mOffsetX);
+	float y1 = (float)(-mOffsetY);
+	float x2 = (float)(mWidth - mOffsetX);
+	float y2 = (float)(mHeight - mOffsetY);
+
+	const AnimationFrame& frame = mAnimation->GetFrame(mCurrentFrame);
+	batch.AddSprite(TextureManager::GetInstance().UseTexture(frame.texture), position, angle, scale,
+		x1, y1, x2, y2, frame.u1, frame.v1, frame.u2, frame.v2);
 }
\ No newline at end of file
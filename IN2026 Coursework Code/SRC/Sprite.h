@@ -5,6 +5,7 @@
 
 // class Texture;
 class Animation;
+class SpriteBatch;
 
 class Sprite
 {
@@ -15,15 +16,21 @@ public:
 
 	virtual void Update(int t);
 	virtual void Render(void);
+	virtual void Render(SpriteBatch& batch, const GLVector3f& position, GLfloat angle, GLfloat scale);
 
 	void SetCurrentFrame(int f) { mCurrentFrame = f % mFrames; }
 	int GetCurrentFrame() { return mCurrentFrame; }
+	virtual uint GetTextureID() const;
 
 	void SetLoopAnimation(bool loop) { mLoopAnimation = loop; }
 	bool GetLoopAnimation() { return mLoopAnimation; }
 
 	bool IsAnimating() { return mAnimating; }
 
+	// Where the animation has got to, for saving and restoring it
+	int GetFrameMillis() { return mFrameMillis; }
+	void SetAnimationState(int frame, int frame_millis, bool animating);
+
 private:
 	int mWidth;
 	int mHeight;
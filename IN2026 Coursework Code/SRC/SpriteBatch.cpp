@@ -0,0 +1,114 @@
+#include <algorithm>
+#include "GameUtil.h"
+#include "RenderState.h"
+#include "SpriteBatch.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+SpriteBatch::SpriteBatch()
+	: mEnabled(true),
+	  mActive(false),
+	  mSpriteCount(0),
+	  mDrawCallCount(0)
+{
+}
+
+/** Destructor. */
+SpriteBatch::~SpriteBatch()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Start collecting sprites for a new frame. */
+void SpriteBatch::Begin(void)
+{
+	mQuads.clear();
+	mSpriteCount = 0;
+	mDrawCallCount = 0;
+	mActive = true;
+}
+
+/** Stop collecting sprites and draw everything collected since Begin(). */
+void SpriteBatch::End(void)
+{
+	if (!mActive) return;
+	Flush();
+	mActive = false;
+}
+
+/** Add a sprite quad, transforming its corners into world space on the CPU. */
+void SpriteBatch::AddSprite(uint texture_id, const GLVector3f& position, GLfloat angle, GLfloat scale,
+	GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2,
+	GLfloat u1, GLfloat v1, GLfloat u2, GLfloat v2)
+{
+	// Same transform as GameObject::PreRender: translate, rotate about z, then scale
+	GLfloat c = (GLfloat)cos(DEG2RAD*angle) * scale;
+	GLfloat s = (GLfloat)sin(DEG2RAD*angle) * scale;
+
+	const GLfloat corners[4][4] = {
+		{ x1, y1, u1, v1 },
+		{ x2, y1, u2, v1 },
+		{ x2, y2, u2, v2 },
+		{ x1, y2, u1, v2 },
+	};
+
+	mQuads.push_back(SpriteQuad());
+	SpriteQuad& quad = mQuads.back();
+	quad.texture_id = texture_id;
+	for (uint i = 0; i < 4; i++) {
+		SpriteVertex& vertex = quad.vertices[i];
+		vertex.x = position.x + c*corners[i][0] - s*corners[i][1];
+		vertex.y = position.y + s*corners[i][0] + c*corners[i][1];
+		vertex.z = position.z;
+		vertex.u = corners[i][2];
+		vertex.v = corners[i][3];
+	}
+	mSpriteCount++;
+}
+
+/** Sort collected quads by texture and submit one draw call per texture. */
+void SpriteBatch::Flush(void)
+{
+	if (mQuads.empty()) return;
+
+	// Group quads by texture, keeping submission order within each group
+	mSortedQuads.clear();
+	for (SpriteQuadVector::const_iterator it = mQuads.begin(); it != mQuads.end(); ++it) {
+		mSortedQuads.push_back(&(*it));
+	}
+	stable_sort(mSortedQuads.begin(), mSortedQuads.end(), CompareQuads);
+
+	// Copy the grouped quads into a single vertex array
+	mVertices.resize(4 * mSortedQuads.size());
+	for (uint i = 0; i < mSortedQuads.size(); i++) {
+		memcpy(&mVertices[4*i], mSortedQuads[i]->vertices, sizeof(mSortedQuads[i]->vertices));
+	}
+
+	// Client-side vertex arrays are core in OpenGL 1.1, so this path works
+	// on every driver including Mesa's software rasterizers
+	RenderState::GetInstance().ApplyMaterial(RENDER_MATERIAL_SPRITE);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(SpriteVertex), &mVertices[0].u);
+	glVertexPointer(3, GL_FLOAT, sizeof(SpriteVertex), &mVertices[0].x);
+
+	// Issue one draw call for each run of quads sharing a texture
+	uint first = 0;
+	while (first < mSortedQuads.size()) {
+		uint texture_id = mSortedQuads[first]->texture_id;
+		uint last = first + 1;
+		while (last < mSortedQuads.size() && mSortedQuads[last]->texture_id == texture_id) last++;
+		RenderState::GetInstance().BindTexture(texture_id);
+		glDrawArrays(GL_QUADS, 4*first, 4*(last - first));
+		RenderState::GetInstance().CountDrawCall();
+		mDrawCallCount++;
+		first = last;
+	}
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	mQuads.clear();
+}
@@ -0,0 +1,54 @@
+#ifndef __SPRITEBATCH_H__
+#define __SPRITEBATCH_H__
+
+#include <vector>
+#include "GameUtil.h"
+
+class SpriteBatch
+{
+public:
+	SpriteBatch();
+	~SpriteBatch();
+
+	void Begin(void);
+	void Flush(void);
+	void End(void);
+
+	void AddSprite(uint texture_id, const GLVector3f& position, GLfloat angle, GLfloat scale,
+		GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2,
+		GLfloat u1, GLfloat v1, GLfloat u2, GLfloat v2);
+
+	void SetEnabled(bool enabled) { mEnabled = enabled; }
+	bool IsEnabled() const { return mEnabled; }
+	bool IsActive() const { return mEnabled && mActive; }
+
+	uint GetSpriteCount() const { return mSpriteCount; }
+	uint GetDrawCallCount() const { return mDrawCallCount; }
+
+private:
+	struct SpriteVertex
+	{
+		GLfloat u, v;
+		GLfloat x, y, z;
+	};
+
+	struct SpriteQuad
+	{
+		uint texture_id;
+		SpriteVertex vertices[4];
+	};
+
+	static bool CompareQuads(const SpriteQuad* a, const SpriteQuad* b) { return a->texture_id < b->texture_id; }
+
+	typedef vector<SpriteQuad> SpriteQuadVector;
+	SpriteQuadVector mQuads;
+	vector<const SpriteQuad*> mSortedQuads;
+	vector<SpriteVertex> mVertices;
+
+	bool mEnabled;
+	bool mActive;
+	uint mSpriteCount;
+	uint mDrawCallCount;
+};
+
+#endif
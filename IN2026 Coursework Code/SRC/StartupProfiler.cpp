@@ -0,0 +1,40 @@
+#include "ImageManager.h"
+#include "StartupProfiler.h"
+#include "TextureManager.h"
+
+/** Reset the time that startup is measured from, ideally first thing in main. */
+void StartupProfiler::Start(void)
+{
+	mStartTime = chrono::steady_clock::now();
+}
+
+/** Milliseconds since startup began. */
+double StartupProfiler::GetElapsedMillis(void) const
+{
+	return MillisBetween(mStartTime, chrono::steady_clock::now());
+}
+
+/** Record how long a stage took. Safe to call from worker threads. */
+void StartupProfiler::RecordStage(const string& stage, double millis)
+{
+	lock_guard<mutex> lock(mStagesMutex);
+	mStages.push_back(make_pair(stage, millis));
+}
+
+/** Print every recorded stage, the time to first frame and the pixels still held, once only. */
+void StartupProfiler::ReportFirstFrame(void)
+{
+	if (mFirstFrameReported) return;
+	mFirstFrameReported = true;
+
+	lock_guard<mutex> lock(mStagesMutex);
+	for (StageTimeVector::iterator it = mStages.begin(); it != mStages.end(); ++it) {
+		cout << "Startup: " << it->first << " " << it->second << " ms" << endl;
+	}
+	cout << "Startup: time to first frame " << GetElapsedMillis() << " ms" << endl;
+	// Images whose pixels were not released after uploading are still held here
+	ImageManager& images = ImageManager::GetInstance();
+	TextureManager& textures = TextureManager::GetInstance();
+	cout << "Startup: " << images.GetImageCount() << " images holding " << images.GetImageBytes() / 1024 << " KB, "
+		<< textures.GetTextureCount() << " textures using " << (textures.GetResidentBytes() + textures.GetPinnedBytes()) / 1024 << " KB" << endl;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef __STARTUPPROFILER_H__
+#define __STARTUPPROFILER_H__
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include "GameUtil.h"
+
+class StartupProfiler
+{
+public:
+	inline static StartupProfiler& GetInstance(void)
+	{
+		static StartupProfiler mInstance;
+		return mInstance;
+	}
+
+	void Start(void);
+	double GetElapsedMillis(void) const;
+
+	void RecordStage(const string& stage, double millis);
+	void ReportFirstFrame(void);
+
+	// Milliseconds between two points from a steady clock
+	static double MillisBetween(chrono::steady_clock::time_point start, chrono::steady_clock::time_point end)
+	{
+		return chrono::duration<double, milli>(end - start).count();
+	}
+
+private:
+	StartupProfiler() : mStartTime(chrono::steady_clock::now()), mFirstFrameReported(false) {} // Private constructor
+	~StartupProfiler() {} // Private destructor
+
+	typedef vector< pair<string, double> > StageTimeVector;
+	StageTimeVector mStages;
+	mutex mStagesMutex;
+
+	chrono::steady_clock::time_point mStartTime;
+	bool mFirstFrameReported;
+};
+
+#endif
\ No newline at end of file
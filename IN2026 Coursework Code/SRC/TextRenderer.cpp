@@ -0,0 +1,190 @@
+#include "GameUtil.h"
+#include "RenderState.h"
+#include "TextRenderer.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+TextRenderer::TextRenderer()
+	: mTextureID(0),
+	  mActive(false),
+	  mDrawCallCount(0)
+{
+	memset(mGlyphs, 0, sizeof(mGlyphs));
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Build the glyph atlas by drawing the font into the back buffer and reading
+	it back. Must be called on the GL thread before the frame is drawn, as it
+	overwrites part of the back buffer. Returns false if the viewport is too
+	small to hold the glyphs, in which case text should be drawn as bitmaps. */
+bool TextRenderer::Create(void)
+{
+	if (IsCreated()) return true;
+
+	const int height = ((LAST_CHAR - FIRST_CHAR) / CELL_COLUMNS + 1) * CELL_HEIGHT;
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (viewport[2] < ATLAS_SIZE || viewport[3] < height) return false;
+
+	vector<uchar> pixels(ATLAS_SIZE * ATLAS_SIZE, 0);
+	CaptureGlyphs(pixels, viewport[0], viewport[1], height);
+	for (int c = FIRST_CHAR; c <= LAST_CHAR; c++) FindGlyphBounds(pixels, c);
+
+	// Alpha only, so the label colour comes from glColor. Nearest filtering
+	// keeps each texel on exactly one pixel, as the bitmaps were.
+	GLuint textures[1];
+	glGenTextures(1, &textures[0]);
+	mTextureID = textures[0];
+	RenderState::GetInstance().BindTexture(mTextureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA8, ATLAS_SIZE, ATLAS_SIZE, 0, GL_ALPHA, GL_UNSIGNED_BYTE, &pixels[0]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	return true;
+}
+
+/** Lay out a line of text with its pen starting at (x, y), exactly where
+	glutBitmapCharacter would draw it. Characters outside printable ASCII
+	advance the pen but draw nothing. */
+void TextRenderer::LayoutText(const string& text, int x, int y, TextVertexVector& vertices) const
+{
+	vertices.clear();
+	for (uint i = 0; i < text.length(); i++, x += FONT_WIDTH) {
+		int c = (uchar)text[i];
+		if (c < FIRST_CHAR || c > LAST_CHAR) continue;
+		const Glyph& glyph = mGlyphs[c - FIRST_CHAR];
+		if (glyph.width == 0) continue;
+
+		GLfloat x1 = (GLfloat)(x + glyph.x), y1 = (GLfloat)(y + glyph.y);
+		GLfloat x2 = x1 + glyph.width, y2 = y1 + glyph.height;
+		const TextVertex corners[4] = {
+			{ glyph.u1, glyph.v1, x1, y1 },
+			{ glyph.u2, glyph.v1, x2, y1 },
+			{ glyph.u2, glyph.v2, x2, y2 },
+			{ glyph.u1, glyph.v2, x1, y2 },
+		};
+		vertices.insert(vertices.end(), corners, corners + 4);
+	}
+}
+
+/** Start collecting text for the display. */
+void TextRenderer::Begin(void)
+{
+	mVertices.clear();
+	mRuns.clear();
+	mDrawCallCount = 0;
+	mActive = true;
+}
+
+/** Add laid out text in the given colour. Outside Begin() and End() it is drawn straight away. */
+void TextRenderer::AddText(const TextVertexVector& vertices, const GLVector3f& color)
+{
+	if (vertices.empty()) return;
+	if (mRuns.empty() || mRuns.back().color.x != color.x || mRuns.back().color.y != color.y || mRuns.back().color.z != color.z) {
+		TextRun run = { color, (uint)mVertices.size(), 0 };
+		mRuns.push_back(run);
+	}
+	mVertices.insert(mVertices.end(), vertices.begin(), vertices.end());
+	mRuns.back().count += (uint)vertices.size();
+	if (!mActive) Flush();
+}
+
+/** Draw everything added since Begin(). */
+void TextRenderer::End(void)
+{
+	Flush();
+	mActive = false;
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+/** Draw every glyph in white on black into its cell, and read the cells back. */
+void TextRenderer::CaptureGlyphs(vector<uchar>& pixels, int x, int y, int height)
+{
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT | GL_TRANSFORM_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_BLEND);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0, ATLAS_SIZE, 0, height, -1, 1);
+	glViewport(x, y, ATLAS_SIZE, height);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glColor3f(1.0f, 1.0f, 1.0f);
+	for (int c = FIRST_CHAR; c <= LAST_CHAR; c++) {
+		int cell = c - FIRST_CHAR;
+		glRasterPos2i((cell % CELL_COLUMNS) * CELL_WIDTH + PEN_X, (cell / CELL_COLUMNS) * CELL_HEIGHT + PEN_Y);
+		glutBitmapCharacter(GLUT_BITMAP_9_BY_15, c);
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(x, y, ATLAS_SIZE, height, GL_RED, GL_UNSIGNED_BYTE, &pixels[0]);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopAttrib();
+}
+
+/** Shrink a glyph's quad to the pixels it actually covers, so blank space costs nothing to draw. */
+void TextRenderer::FindGlyphBounds(const vector<uchar>& pixels, int c)
+{
+	int cell = c - FIRST_CHAR;
+	int cell_x = (cell % CELL_COLUMNS) * CELL_WIDTH;
+	int cell_y = (cell / CELL_COLUMNS) * CELL_HEIGHT;
+	int x1 = CELL_WIDTH, y1 = CELL_HEIGHT, x2 = 0, y2 = 0;
+	for (int j = 0; j < CELL_HEIGHT; j++) {
+		for (int i = 0; i < CELL_WIDTH; i++) {
+			if (pixels[(cell_y + j) * ATLAS_SIZE + cell_x + i] == 0) continue;
+			x1 = min(x1, i);
+			y1 = min(y1, j);
+			x2 = max(x2, i + 1);
+			y2 = max(y2, j + 1);
+		}
+	}
+
+	Glyph& glyph = mGlyphs[cell];
+	if (x2 <= x1) return;
+	glyph.x = x1 - PEN_X;
+	glyph.y = y1 - PEN_Y;
+	glyph.width = x2 - x1;
+	glyph.height = y2 - y1;
+	glyph.u1 = (GLfloat)(cell_x + x1) / ATLAS_SIZE;
+	glyph.v1 = (GLfloat)(cell_y + y1) / ATLAS_SIZE;
+	glyph.u2 = (GLfloat)(cell_x + x2) / ATLAS_SIZE;
+	glyph.v2 = (GLfloat)(cell_y + y2) / ATLAS_SIZE;
+}
+
+/** Draw the collected text, one call for each run of a single colour. */
+void TextRenderer::Flush(void)
+{
+	if (mVertices.empty()) return;
+
+	RenderState::GetInstance().ApplyMaterial(RENDER_MATERIAL_GLYPHS);
+	RenderState::GetInstance().BindTexture(mTextureID);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &mVertices[0].u);
+	glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &mVertices[0].x);
+	for (uint i = 0; i < mRuns.size(); i++) {
+		glColor3f(mRuns[i].color[0], mRuns[i].color[1], mRuns[i].color[2]);
+		glDrawArrays(GL_QUADS, mRuns[i].first, mRuns[i].count);
+		RenderState::GetInstance().CountDrawCall();
+		mDrawCallCount++;
+	}
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	mVertices.clear();
+	mRuns.clear();
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef __TEXTRENDERER_H__
+#define __TEXTRENDERER_H__
+
+#include <vector>
+#include "GameUtil.h"
+
+// Corner of a glyph quad in window coordinates
+struct TextVertex
+{
+	GLfloat u, v;
+	GLfloat x, y;
+};
+
+typedef vector<TextVertex> TextVertexVector;
+
+// Draws text in the GLUT 9x15 bitmap font as textured quads. The glyphs are
+// captured into an atlas texture once, text is laid out into vertices only
+// when it changes, and everything added between Begin() and End() is drawn
+// with one call per colour.
+class TextRenderer
+{
+public:
+	inline static TextRenderer& GetInstance(void)
+	{
+		static TextRenderer mInstance;
+		return mInstance;
+	}
+
+	static const int FONT_WIDTH = 9;
+	static const int FONT_HEIGHT = 15;
+
+	bool Create(void);
+	bool IsCreated() const { return mTextureID != 0; }
+
+	void LayoutText(const string& text, int x, int y, TextVertexVector& vertices) const;
+
+	void Begin(void);
+	void AddText(const TextVertexVector& vertices, const GLVector3f& color);
+	void End(void);
+
+	uint GetDrawCallCount() const { return mDrawCallCount; }
+
+private:
+	TextRenderer();
+	~TextRenderer() {}
+
+	// Printable ASCII is captured, in cells big enough for any glyph
+	static const int FIRST_CHAR = 32;
+	static const int LAST_CHAR = 126;
+	static const int CELL_WIDTH = 16;
+	static const int CELL_HEIGHT = 24;
+	static const int CELL_COLUMNS = 16;
+	static const int PEN_X = 4;
+	static const int PEN_Y = 6;
+	static const int ATLAS_SIZE = 256;
+
+	// Where a glyph's pixels lie relative to the pen, and in the atlas
+	struct Glyph
+	{
+		int x, y;
+		int width, height;
+		GLfloat u1, v1, u2, v2;
+	};
+
+	// Vertices sharing a colour, drawn in one call
+	struct TextRun
+	{
+		GLVector3f color;
+		uint first;
+		uint count;
+	};
+
+	void CaptureGlyphs(vector<uchar>& pixels, int x, int y, int height);
+	void FindGlyphBounds(const vector<uchar>& pixels, int c);
+	void Flush(void);
+
+	uint mTextureID;
+	Glyph mGlyphs[LAST_CHAR - FIRST_CHAR + 1];
+
+	bool mActive;
+	TextVertexVector mVertices;
+	vector<TextRun> mRuns;
+	uint mDrawCallCount;
+};
+
+#endif
\ No newline at end of file
@@ -1,27 +1,133 @@
 #include "GameUtil.h"
 #include "Image.h"
+#include "RenderState.h"
 #include "Texture.h"
 
 using namespace std;
 
+// Core since OpenGL 1.2, which the Windows headers predate
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+#ifndef GL_UNSIGNED_SHORT_4_4_4_4_REV
+#define GL_UNSIGNED_SHORT_4_4_4_4_REV 0x8365
+#endif
+#ifndef GL_UNSIGNED_SHORT_1_5_5_5_REV
+#define GL_UNSIGNED_SHORT_1_5_5_5_REV 0x8366
+#endif
+
+// How pixels of each format are described to glTexImage2D
+struct PixelTransfer
+{
+	GLint internal_format;
+	GLenum format;
+	GLenum type;
+};
+
+static const PixelTransfer PIXEL_TRANSFERS[PIXEL_FORMAT_COUNT] = {
+	{ GL_RGBA8, GL_BGRA_EXT, GL_UNSIGNED_BYTE },
+	{ GL_LUMINANCE8_ALPHA8, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE },
+	{ GL_RGB5_A1, GL_BGRA_EXT, GL_UNSIGNED_SHORT_1_5_5_5_REV },
+	{ GL_RGBA4, GL_BGRA_EXT, GL_UNSIGNED_SHORT_4_4_4_4_REV },
+};
+
 // PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
 
-Texture::Texture(Image* image)
+Texture::Texture(shared_ptr<Image> image)
+	: mOwner(image),
+	  mTextureID(0),
+	  mLastUsedFrame(0)
+{
+	SetLevels(image->GetLevelViews());
+	Upload();
+}
+
+Texture::Texture(const ImageView& view)
+	: mTextureID(0),
+	  mLastUsedFrame(0)
+{
+	SetLevels(ImageViewVector(1, view));
+	Upload();
+}
+
+Texture::Texture(const ImageViewVector& levels, shared_ptr<Image> owner)
+	: mOwner(owner),
+	  mTextureID(0),
+	  mLastUsedFrame(0)
+{
+	SetLevels(levels);
+	Upload();
+}
+
+Texture::~Texture()
 {
+	Release();
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Upload the source pixels to a new GL texture, unless already resident. */
+void Texture::Upload(void)
+{
+	if (IsResident() || !HasSource()) return;
+
 	// Get a texture id from OpenGL
 	GLuint textures[1];
 	glGenTextures(1, &textures[0]);
 	mTextureID = textures[0];
-	mImageWidth = image->GetWidth();
-	mImageHeight = image->GetHeight();
 
-	// Bind a texture to an image using id
-	glBindTexture(GL_TEXTURE_2D, mTextureID);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mImageWidth, mImageHeight, 0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, image->GetPixelData());
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	// Bind a texture to an image using id, reading rows straight out of each level
+	RenderState::GetInstance().BindTexture(mTextureID);
+	// Compact formats are sized internal formats, so the driver keeps them at 16 bits
+	const PixelTransfer& transfer = PIXEL_TRANSFERS[mFormat];
+	uint pixel_size = GetPixelSize(mFormat);
+	// A chain that stops before 1x1 needs GL_TEXTURE_MAX_LEVEL, without which
+	// a 1.1 context treats the texture as incomplete and draws it untextured
+	uint num_levels = RenderState::GetInstance().IsVersionAtLeast(1, 2) ? (uint)mLevels.size() : 1;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, pixel_size);
+	for (uint level = 0; level < num_levels; level++) {
+		const ImageView& view = mLevels[level];
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, view.stride / pixel_size);
+		glTexImage2D(GL_TEXTURE_2D, level, transfer.internal_format, view.width, view.height, 0, transfer.format, transfer.type, view.data);
+	}
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// Let GL pick between the precomputed levels for sprites drawn scaled down.
+	// The chain may stop before 1x1, so tell GL where it ends.
+	if (num_levels > 1) glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)num_levels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, num_levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
-Texture::~Texture()
+/** Free the GL texture. The source pixels are kept so it can be uploaded again. */
+void Texture::Release(void)
 {
+	if (!IsResident()) return;
+	GLuint textures[1] = { mTextureID };
+	glDeleteTextures(1, &textures[0]);
+	RenderState::GetInstance().ForgetTexture(mTextureID);
+	mTextureID = 0;
 }
+
+/** Forget the source pixels, freeing the image if nothing else uses it. The
+	texture can no longer be uploaded again, so it must not be released. */
+void Texture::DiscardSource(void)
+{
+	mLevels.clear();
+	mOwner.reset();
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+void Texture::SetLevels(const ImageViewVector& levels)
+{
+	mLevels = levels;
+	mImageWidth = levels[0].width;
+	mImageHeight = levels[0].height;
+	mFormat = levels[0].format;
+	mByteSize = 0;
+	for (uint level = 0; level < levels.size(); level++) {
+		mByteSize += GetPixelSize(levels[level].format) * levels[level].width * levels[level].height;
+	}
+}
\ No newline at end of file
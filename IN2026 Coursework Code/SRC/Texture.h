@@ -1,20 +1,45 @@
 #ifndef __TEXTURE_H__
 #define __TEXTURE_H__
 
-class Image;
+#include "Image.h"
 
 class Texture
 {
 public:
-	Texture(Image* image);
+	Texture(shared_ptr<Image> image);
+	Texture(const ImageView& view);
+	Texture(const ImageViewVector& levels, shared_ptr<Image> owner = shared_ptr<Image>());
 	~Texture();
 	uint GetTextureID() const { return mTextureID; }
 	uint GetImageWidth() const { return mImageWidth; }
 	uint GetImageHeight() const { return mImageHeight; }
+
+	// A texture can be released and uploaded again from its source pixels,
+	// which must stay valid for as long as the texture exists. An image the
+	// source belongs to is kept alive by the texture until DiscardSource().
+	void Upload(void);
+	void Release(void);
+	void DiscardSource(void);
+	bool IsResident() const { return mTextureID != 0; }
+	bool HasSource() const { return !mLevels.empty(); }
+	uint GetByteSize() const { return mByteSize; }
+	uint GetNumLevels() const { return (uint)mLevels.size(); }
+	PixelFormat GetFormat() const { return mFormat; }
+
+	uint GetLastUsedFrame() const { return mLastUsedFrame; }
+	void SetLastUsedFrame(uint frame) { mLastUsedFrame = frame; }
+
 private:
+	void SetLevels(const ImageViewVector& levels);
+
+	ImageViewVector mLevels;
+	shared_ptr<Image> mOwner;
 	uint mTextureID;
 	uint mImageWidth;
 	uint mImageHeight;
+	uint mByteSize;
+	PixelFormat mFormat;
+	uint mLastUsedFrame;
 };
 
 #endif
\ No newline at end of file
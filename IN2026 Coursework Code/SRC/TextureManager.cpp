@@ -5,19 +5,110 @@
 
 Texture* TextureManager::CreateTextureFromFile(const string& name, const uint width, const uint height, const string& filename)
 {
-	Image* image = ImageManager::GetInstance().CreateImageFromFile(name, width, height, filename);
+	shared_ptr<Image> image = ImageManager::GetInstance().CreateImageFromFile(name, width, height, filename);
 	return CreateTextureFromImage(name, image);
 }
 
-Texture* TextureManager::CreateTextureFromImage(const string& name, Image* image)
+/** Upload a texture from an image, which the texture keeps alive so it can be re-uploaded. */
+Texture* TextureManager::CreateTextureFromImage(const string& name, shared_ptr<Image> image)
 {
-	Texture* texture = new Texture(image);
-	mTextureMap.insert(NamedTextureMap::value_type(name, texture));
-	return texture;
+	return AddTexture(name, new Texture(image));
+}
+
+/** Upload a texture from a view of another image's pixels, without copying them. */
+Texture* TextureManager::CreateTextureFromView(const string& name, const ImageView& view)
+{
+	return AddTexture(name, new Texture(view));
+}
+
+/** Upload a texture and its mipmaps from views of pixels owned elsewhere, keeping the owner alive. */
+Texture* TextureManager::CreateTextureFromLevels(const string& name, const ImageViewVector& levels, shared_ptr<Image> owner)
+{
+	return AddTexture(name, new Texture(levels, owner));
 }
 
 Texture* TextureManager::GetTextureByName(const string& name)
 {
 	NamedTextureMap::iterator it = mTextureMap.find(name);
 	return (it == mTextureMap.end()) ? 0 : it->second;
+}
+
+/** Start a new frame, releasing anything the last frame needed beyond the budget. */
+void TextureManager::BeginFrame(void)
+{
+	mFrame++;
+	EnforceBudget();
+}
+
+/** Get the GL id to draw a texture with, uploading it again if it was evicted. */
+uint TextureManager::UseTexture(Texture* texture)
+{
+	// Only the first use in a frame needs to touch the LRU list
+	if (texture->GetLastUsedFrame() == mFrame && texture->IsResident()) return texture->GetTextureID();
+	texture->SetLastUsedFrame(mFrame);
+	// Pinned textures are always resident and not in the LRU list
+	if (!texture->HasSource()) return texture->GetTextureID();
+
+	if (!texture->IsResident()) {
+		texture->Upload();
+		mUploadCount++;
+		MarkResident(texture);
+		EnforceBudget();
+	} else {
+		mResidentTextures.splice(mResidentTextures.begin(), mResidentTextures, mResidentPositions[texture]);
+	}
+	return texture->GetTextureID();
+}
+
+/** Free a texture's source pixels and pin it. Its bytes move from the resident total to the
+	pinned total, as only textures that can be evicted count against the budget. */
+void TextureManager::DiscardSource(Texture* texture)
+{
+	if (!texture->HasSource() || !texture->IsResident()) return;
+	texture->DiscardSource();
+	mResidentTextures.erase(mResidentPositions[texture]);
+	mResidentPositions.erase(texture);
+	mResidentBytes -= texture->GetByteSize();
+	mPinnedBytes += texture->GetByteSize();
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+/** Take ownership of a new texture. A name that is already in use keeps its texture, which
+	may be drawn with already, so the new one is deleted and the existing one returned. */
+Texture* TextureManager::AddTexture(const string& name, Texture* texture)
+{
+	NamedTextureMap::iterator it = mTextureMap.find(name);
+	if (it != mTextureMap.end()) {
+		delete texture;
+		return it->second;
+	}
+	mTextureMap.insert(NamedTextureMap::value_type(name, texture));
+	texture->SetLastUsedFrame(mFrame);
+	mUploadCount++;
+	MarkResident(texture);
+	EnforceBudget();
+	return texture;
+}
+
+void TextureManager::MarkResident(Texture* texture)
+{
+	mResidentTextures.push_front(texture);
+	mResidentPositions[texture] = mResidentTextures.begin();
+	mResidentBytes += texture->GetByteSize();
+}
+
+/** Release least recently used textures until under budget. Textures used this
+	frame are never released, as they may already be queued for drawing. */
+void TextureManager::EnforceBudget(void)
+{
+	while (mResidentBytes > mBudgetBytes && !mResidentTextures.empty()) {
+		Texture* texture = mResidentTextures.back();
+		if (texture->GetLastUsedFrame() == mFrame) break;
+		mResidentTextures.pop_back();
+		mResidentPositions.erase(texture);
+		mResidentBytes -= texture->GetByteSize();
+		texture->Release();
+		mEvictionCount++;
+	}
 }
\ No newline at end of file
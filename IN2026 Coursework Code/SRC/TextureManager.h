@@ -2,8 +2,8 @@
 #define __TEXTUREMANAGER_H__
 
 #include "GameUtil.h"
+#include "Image.h"
 
-class Image;
 class Texture;
 
 class TextureManager
@@ -16,15 +16,53 @@ public:
 	}
 
 	Texture* CreateTextureFromFile(const string& n, const uint w, const uint h, const string& filename);
-	Texture* CreateTextureFromImage(const string& name, Image* image);
+	Texture* CreateTextureFromImage(const string& name, shared_ptr<Image> image);
+	Texture* CreateTextureFromView(const string& name, const ImageView& view);
+	Texture* CreateTextureFromLevels(const string& name, const ImageViewVector& levels, shared_ptr<Image> owner = shared_ptr<Image>());
 	Texture* GetTextureByName(const string& name);
 
+	// Residency: textures past the budget are released least recently used
+	// first, and uploaded again from their source the next time they are used.
+	// Resident bytes are those that can be released; pinned bytes are apart.
+	static const size_t DEFAULT_BUDGET_BYTES = 64 * 1024 * 1024;
+
+	void BeginFrame(void);
+	uint UseTexture(Texture* texture);
+	void SetBudget(size_t bytes) { mBudgetBytes = bytes; EnforceBudget(); }
+	size_t GetBudget() const { return mBudgetBytes; }
+	size_t GetResidentBytes() const { return mResidentBytes; }
+	size_t GetPinnedBytes() const { return mPinnedBytes; }
+	uint GetTextureCount() const { return (uint)mTextureMap.size(); }
+	uint GetUploadCount() const { return mUploadCount; }
+	uint GetEvictionCount() const { return mEvictionCount; }
+
+	// Upload and discard: free a texture's source pixels once uploaded. The
+	// texture is pinned, as it could not be uploaded again after eviction.
+	void DiscardSource(Texture* texture);
+
 private:
-	TextureManager() {} // Private constructor
+	TextureManager() // Private constructor
+		: mBudgetBytes(DEFAULT_BUDGET_BYTES), mResidentBytes(0), mPinnedBytes(0), mFrame(1), mUploadCount(0), mEvictionCount(0) {}
 	~TextureManager() {} // Private destructor
+
+	Texture* AddTexture(const string& name, Texture* texture);
+	void MarkResident(Texture* texture);
+	void EnforceBudget(void);
 	
 	typedef map< string, Texture* > NamedTextureMap;
 	NamedTextureMap mTextureMap;
+
+	// Resident textures that can be evicted, most recently used first
+	typedef list<Texture*> TextureList;
+	TextureList mResidentTextures;
+	map<Texture*, TextureList::iterator> mResidentPositions;
+
+	size_t mBudgetBytes;
+	size_t mResidentBytes;
+	size_t mPinnedBytes;
+	uint mFrame;
+	uint mUploadCount;
+	uint mEvictionCount;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include "ITimerListener.h"
+#include "TimerWheel.h"
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+TimerWheel::TimerWheel()
+	: mFreeNodes(NODE_FREE),
+	  mTime(0),
+	  mNextSequence(0),
+	  mPendingCount(0),
+	  mFiredCount(0)
+{
+	Clear();
+}
+
+/** Destructor. */
+TimerWheel::~TimerWheel()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Call listener->OnTimer(value) once msecs of game time have passed. A delay
+	of 0 fires on the next Advance(). Timers due on the same tick fire in the
+	order they were scheduled. */
+TimerHandle TimerWheel::Schedule(uint msecs, ITimerListener* listener, int value)
+{
+	int index = AllocateNode();
+	TimerNode& node = mNodes[index];
+	node.listener = listener;
+	node.value = value;
+	node.expires = mTime + max(msecs, 1u);
+	node.sequence = mNextSequence++;
+	Insert(index);
+	mPendingCount++;
+
+	TimerHandle handle;
+	handle.index = index;
+	handle.generation = node.generation;
+	return handle;
+}
+
+/** Stop a timer from firing. Returns false if it had already fired or been cancelled. */
+bool TimerWheel::Cancel(TimerHandle& handle)
+{
+	if (!IsPending(handle)) return false;
+	TimerNode& node = mNodes[handle.index];
+	if (node.slot == NODE_FIRING) {
+		// Due this tick, but not called yet. FireSlot frees it.
+		node.listener = NULL;
+		node.generation++;
+	} else {
+		Unlink(handle.index);
+		FreeNode(handle.index);
+	}
+	mPendingCount--;
+	handle = TimerHandle();
+	return true;
+}
+
+bool TimerWheel::IsPending(const TimerHandle& handle) const
+{
+	if (handle.index < 0 || handle.index >= (int)mNodes.size()) return false;
+	const TimerNode& node = mNodes[handle.index];
+	return node.generation == handle.generation && node.slot != NODE_FREE && node.listener != NULL;
+}
+
+/** Cancel every timer. */
+void TimerWheel::Clear(void)
+{
+	for (uint i = 0; i < LEVELS * SLOTS; i++) {
+		mSlots[i].head = NODE_FREE;
+		mSlots[i].tail = NODE_FREE;
+	}
+	mFreeNodes = NODE_FREE;
+	for (int i = (int)mNodes.size() - 1; i >= 0; i--) {
+		if (mNodes[i].slot == NODE_FIRING) {
+			mNodes[i].listener = NULL;
+			mNodes[i].generation++;
+		} else {
+			FreeNode(i);
+		}
+	}
+	mPendingCount = 0;
+}
+
+/** Move game time on, firing every timer that comes due, one tick at a time. */
+void TimerWheel::Advance(uint msecs)
+{
+	while (msecs > 0) {
+		// Nothing can fire, so skip straight to the end
+		if (mPendingCount == 0) {
+			mTime += msecs;
+			return;
+		}
+		mTime++;
+		msecs--;
+
+		// Each time a level wraps, bring the next level's timers down
+		uint index = mTime & (SLOTS - 1);
+		for (uint level = 1; level < LEVELS && index == 0; level++) {
+			index = (mTime >> (level * SLOT_BITS)) & (SLOTS - 1);
+			Cascade(level);
+		}
+		FireSlot(mTime & (SLOTS - 1));
+	}
+}
+
+/** Allow timers for a listener to be saved. Snapshots refer to listeners by the
+	order they were registered in, so register the same ones in the same order
+	wherever a snapshot is restored. */
+void TimerWheel::RegisterListener(ITimerListener* listener)
+{
+	if (find(mListeners.begin(), mListeners.end(), listener) == mListeners.end()) mListeners.push_back(listener);
+}
+
+/** Save every pending timer whose listener is registered, in the order they will fire. */
+void TimerWheel::SaveState(TimerStateVector& timers) const
+{
+	timers.clear();
+	for (uint i = 0; i < mNodes.size(); i++) {
+		const TimerNode& node = mNodes[i];
+		if (node.slot < 0 || node.listener == NULL) continue;
+		vector<ITimerListener*>::const_iterator it = find(mListeners.begin(), mListeners.end(), node.listener);
+		if (it == mListeners.end()) continue;
+		TimerState timer;
+		timer.expires = node.expires;
+		timer.sequence = node.sequence;
+		timer.value = node.value;
+		timer.listener = (int)(it - mListeners.begin());
+		timers.push_back(timer);
+	}
+	sort(timers.begin(), timers.end(), CompareTimerStates);
+}
+
+/** Replace every timer with saved ones, at the given game time. Handles to the old timers stop being pending. */
+void TimerWheel::RestoreState(uint time, uint next_sequence, const TimerStateVector& timers)
+{
+	Clear();
+	mTime = time;
+	mNextSequence = next_sequence;
+	for (uint i = 0; i < timers.size(); i++) {
+		const TimerState& timer = timers[i];
+		if (timer.listener < 0 || timer.listener >= (int)mListeners.size()) continue;
+		int index = AllocateNode();
+		TimerNode& node = mNodes[index];
+		node.listener = mListeners[timer.listener];
+		node.value = timer.value;
+		node.expires = timer.expires;
+		node.sequence = timer.sequence;
+		Insert(index);
+		mPendingCount++;
+	}
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+int TimerWheel::AllocateNode(void)
+{
+	if (mFreeNodes == NODE_FREE) {
+		TimerNode node;
+		node.generation = 0;
+		node.slot = NODE_FREE;
+		node.next = NODE_FREE;
+		mNodes.push_back(node);
+		mFreeNodes = (int)mNodes.size() - 1;
+	}
+	int index = mFreeNodes;
+	mFreeNodes = mNodes[index].next;
+	return index;
+}
+
+/** Return a node to the pool. Bumping its generation invalidates any handles to it. */
+void TimerWheel::FreeNode(int index)
+{
+	TimerNode& node = mNodes[index];
+	node.generation++;
+	node.listener = NULL;
+	node.slot = NODE_FREE;
+	node.next = mFreeNodes;
+	mFreeNodes = index;
+}
+
+/** Put a node in the finest level whose span covers the time until it expires. */
+void TimerWheel::Insert(int index)
+{
+	TimerNode& node = mNodes[index];
+	uint delta = node.expires - mTime;
+	uint level = 0;
+	while (level < LEVELS - 1 && delta >= (1u << ((level + 1) * SLOT_BITS))) level++;
+	node.slot = level * SLOTS + ((node.expires >> (level * SLOT_BITS)) & (SLOTS - 1));
+
+	// Append, so timers in a slot keep the order they were scheduled in
+	TimerSlot& slot = mSlots[node.slot];
+	node.prev = slot.tail;
+	node.next = NODE_FREE;
+	if (slot.tail != NODE_FREE) mNodes[slot.tail].next = index; else slot.head = index;
+	slot.tail = index;
+}
+
+void TimerWheel::Unlink(int index)
+{
+	TimerNode& node = mNodes[index];
+	TimerSlot& slot = mSlots[node.slot];
+	if (node.prev != NODE_FREE) mNodes[node.prev].next = node.next; else slot.head = node.next;
+	if (node.next != NODE_FREE) mNodes[node.next].prev = node.prev; else slot.tail = node.prev;
+}
+
+/** Re-insert every timer in the current slot of a level, which puts them in finer levels. */
+void TimerWheel::Cascade(uint level)
+{
+	TimerSlot& slot = mSlots[level * SLOTS + ((mTime >> (level * SLOT_BITS)) & (SLOTS - 1))];
+	int index = slot.head;
+	slot.head = NODE_FREE;
+	slot.tail = NODE_FREE;
+	while (index != NODE_FREE) {
+		int next = mNodes[index].next;
+		Insert(index);
+		index = next;
+	}
+}
+
+/** Fire every timer in a slot of the finest level as one batch. Listeners may
+	schedule and cancel timers while the batch runs. */
+void TimerWheel::FireSlot(uint slot_index)
+{
+	TimerSlot& slot = mSlots[slot_index];
+	if (slot.head == NODE_FREE) return;
+
+	mFiring.clear();
+	for (int index = slot.head; index != NODE_FREE; index = mNodes[index].next) {
+		mFiring.push_back(index);
+	}
+	// Cascading can put a timer behind one scheduled after it, so restore the order
+	if (mFiring.size() > 1) sort(mFiring.begin(), mFiring.end(), [this](int a, int b) { return mNodes[a].sequence < mNodes[b].sequence; });
+	slot.head = NODE_FREE;
+	slot.tail = NODE_FREE;
+	for (uint i = 0; i < mFiring.size(); i++) mNodes[mFiring[i]].slot = NODE_FIRING;
+
+	for (uint i = 0; i < mFiring.size(); i++) {
+		int index = mFiring[i];
+		ITimerListener* listener = mNodes[index].listener;
+		int value = mNodes[index].value;
+		bool cancelled = (listener == NULL);
+		FreeNode(index);
+		if (cancelled) continue;
+		mPendingCount--;
+		mFiredCount++;
+		listener->OnTimer(value);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef __TIMERWHEEL_H__
+#define __TIMERWHEEL_H__
+
+#include <vector>
+#include "GameUtil.h"
+
+class ITimerListener;
+
+// Refers to a scheduled timer. It stays safe to use after the timer has
+// fired or been cancelled, when it simply stops being pending.
+struct TimerHandle
+{
+	TimerHandle() : index(-1), generation(0) {}
+
+	int index;
+	uint generation;
+};
+
+// A pending timer as saved in a snapshot. The listener is its position among
+// those registered with the wheel, so it means the same thing in any process.
+struct TimerState
+{
+	uint expires;
+	uint sequence;
+	int value;
+	int listener;
+};
+
+typedef vector<TimerState> TimerStateVector;
+
+// Timers driven by game time rather than the wall clock, so they only run
+// while the world is updated. A hierarchical wheel of LEVELS x SLOTS lists
+// gives O(1) scheduling and cancelling. Timers further away than one level
+// covers wait in a coarser level and move down as their time approaches.
+// Nodes are pooled and reused, so scheduling does not allocate once the pool
+// has grown to the number of timers in use.
+class TimerWheel
+{
+public:
+	TimerWheel();
+	~TimerWheel();
+
+	TimerHandle Schedule(uint msecs, ITimerListener* listener, int value = 0);
+	bool Cancel(TimerHandle& handle);
+	bool IsPending(const TimerHandle& handle) const;
+	void Clear(void);
+
+	void Advance(uint msecs);
+
+	void RegisterListener(ITimerListener* listener);
+	void SaveState(TimerStateVector& timers) const;
+	void RestoreState(uint time, uint next_sequence, const TimerStateVector& timers);
+	uint GetNextSequence() const { return mNextSequence; }
+
+	uint GetTime() const { return mTime; }
+	uint GetPendingCount() const { return mPendingCount; }
+	uint GetFiredCount() const { return mFiredCount; }
+
+private:
+	static const uint SLOT_BITS = 8;
+	static const uint SLOTS = 1 << SLOT_BITS;
+	static const uint LEVELS = 4;
+
+	// Where a node is when it is not in a slot
+	static const int NODE_FREE = -1;
+	static const int NODE_FIRING = -2;
+
+	struct TimerNode
+	{
+		ITimerListener* listener;
+		int value;
+		uint expires;
+		// Order of scheduling, which timers due on the same tick fire in
+		uint sequence;
+		uint generation;
+		int slot;
+		int prev;
+		int next;
+	};
+
+	struct TimerSlot
+	{
+		int head;
+		int tail;
+	};
+
+	static bool CompareTimerStates(const TimerState& a, const TimerState& b)
+	{
+		return (a.expires != b.expires) ? (a.expires < b.expires) : (a.sequence < b.sequence);
+	}
+
+	int AllocateNode(void);
+	void FreeNode(int index);
+	void Insert(int index);
+	void Unlink(int index);
+	void Cascade(uint level);
+	void FireSlot(uint slot);
+
+	vector<TimerNode> mNodes;
+	int mFreeNodes;
+	TimerSlot mSlots[LEVELS * SLOTS];
+	vector<int> mFiring;
+	// Listeners whose timers can be saved
+	vector<ITimerListener*> mListeners;
+
+	uint mTime;
+	uint mNextSequence;
+	uint mPendingCount;
+	uint mFiredCount;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <string.h>
+#include "UdpSocket.h"
+
+#ifdef _WIN32
+// Winsock has to be started before any socket is made, once per process
+static bool StartSockets(void)
+{
+	static bool started = false;
+	if (!started) {
+		WSADATA data;
+		started = (0 == WSAStartup(MAKEWORD(2, 2), &data));
+	}
+	return started;
+}
+#endif
+
+static void ToSockAddr(const NetAddress& address, sockaddr_in& sock_addr)
+{
+	memset(&sock_addr, 0, sizeof(sock_addr));
+	sock_addr.sin_family = AF_INET;
+	sock_addr.sin_addr.s_addr = htonl(address.host);
+	sock_addr.sin_port = htons(address.port);
+}
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+UdpSocket::UdpSocket()
+	: mSocket(0),
+	  mOpen(false),
+	  mPort(0)
+{
+}
+
+/** Destructor. */
+UdpSocket::~UdpSocket()
+{
+	Close();
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+/** Open a socket on the given port, or on any free port if it is 0. */
+bool UdpSocket::Open(unsigned short port)
+{
+	Close();
+#ifdef _WIN32
+	if (!StartSockets()) { cerr << "Unable to start Winsock" << endl; return false; }
+	SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s == INVALID_SOCKET) { cerr << "Unable to create socket" << endl; return false; }
+	mSocket = (uintptr_t)s;
+#else
+	int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s < 0) { cerr << "Unable to create socket" << endl; return false; }
+	mSocket = (uintptr_t)s;
+#endif
+	mOpen = true;
+
+	NetAddress any = { 0, port };
+	sockaddr_in sock_addr;
+	ToSockAddr(any, sock_addr);
+	if (0 != bind(s, (const sockaddr*)&sock_addr, sizeof(sock_addr))) {
+		cerr << "Unable to bind to port " << port << endl;
+		Close();
+		return false;
+	}
+	socklen_t length = sizeof(sock_addr);
+	if (0 == getsockname(s, (sockaddr*)&sock_addr, &length)) mPort = ntohs(sock_addr.sin_port);
+
+	// The game polls for packets each step rather than waiting for them
+#ifdef _WIN32
+	u_long non_blocking = 1;
+	bool set = (0 == ioctlsocket(s, FIONBIO, &non_blocking));
+#else
+	bool set = (0 == fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK));
+#endif
+	if (!set) { cerr << "Unable to make socket non-blocking" << endl; Close(); return false; }
+	return true;
+}
+
+void UdpSocket::Close(void)
+{
+	if (!mOpen) return;
+#ifdef _WIN32
+	closesocket((SOCKET)mSocket);
+#else
+	close((int)mSocket);
+#endif
+	mOpen = false;
+	mPort = 0;
+}
+
+bool UdpSocket::Send(const NetAddress& to, const char* data, uint size)
+{
+	if (!mOpen || size > MAX_PACKET_SIZE) return false;
+	sockaddr_in sock_addr;
+	ToSockAddr(to, sock_addr);
+#ifdef _WIN32
+	int sent = sendto((SOCKET)mSocket, data, (int)size, 0, (const sockaddr*)&sock_addr, sizeof(sock_addr));
+#else
+	int sent = (int)sendto((int)mSocket, data, size, 0, (const sockaddr*)&sock_addr, sizeof(sock_addr));
+#endif
+	return sent == (int)size;
+}
+
+/** Take the next waiting packet, returning its size, or -1 if there is none. */
+int UdpSocket::Receive(NetAddress& from, char* buffer, uint capacity)
+{
+	if (!mOpen) return -1;
+	sockaddr_in sock_addr;
+	socklen_t length = sizeof(sock_addr);
+	for (;;) {
+#ifdef _WIN32
+		int received = recvfrom((SOCKET)mSocket, buffer, (int)capacity, 0, (sockaddr*)&sock_addr, &length);
+		// Windows reports a previous send to a closed port here, which is not a packet
+		if (received < 0 && WSAGetLastError() == WSAECONNRESET) continue;
+#else
+		int received = (int)recvfrom((int)mSocket, buffer, capacity, 0, (sockaddr*)&sock_addr, &length);
+		if (received < 0 && errno == EINTR) continue;
+#endif
+		if (received < 0) return -1;
+		from.host = ntohl(sock_addr.sin_addr.s_addr);
+		from.port = ntohs(sock_addr.sin_port);
+		return received;
+	}
+}
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+/** Read an address written as "host:port" or "host", where host is a name or dotted numbers. */
+bool UdpSocket::ParseAddress(const string& text, unsigned short default_port, NetAddress& address)
+{
+#ifdef _WIN32
+	if (!StartSockets()) return false;
+#endif
+	string host = text;
+	address.port = default_port;
+	size_t colon = text.rfind(':');
+	if (colon != string::npos) {
+		host = text.substr(0, colon);
+		address.port = (unsigned short)atoi(text.c_str() + colon + 1);
+	}
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo* result = NULL;
+	if (0 != getaddrinfo(host.c_str(), NULL, &hints, &result) || result == NULL) {
+		cerr << "Unknown host " << host << endl;
+		return false;
+	}
+	address.host = ntohl(((const sockaddr_in*)result->ai_addr)->sin_addr.s_addr);
+	freeaddrinfo(result);
+	return true;
+}
+
+string UdpSocket::FormatAddress(const NetAddress& address)
+{
+	ostringstream stream;
+	stream << (address.host >> 24) << "." << ((address.host >> 16) & 0xFF) << "."
+		<< ((address.host >> 8) & 0xFF) << "." << (address.host & 0xFF) << ":" << address.port;
+	return stream.str();
+}
\ No newline at end of file
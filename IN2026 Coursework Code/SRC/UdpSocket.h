@@ -0,0 +1,45 @@
+#ifndef __UDPSOCKET_H__
+#define __UDPSOCKET_H__
+
+#include <stdint.h>
+#include "GameUtil.h"
+
+// An IPv4 address and port, both in host byte order
+struct NetAddress
+{
+	uint host;
+	unsigned short port;
+
+	bool operator==(const NetAddress& o) const { return host == o.host && port == o.port; }
+	bool operator!=(const NetAddress& o) const { return !(*this == o); }
+};
+
+// A non-blocking UDP socket over Winsock or BSD sockets. Nothing from either
+// is in this header, so it can be included alongside windows.h.
+class UdpSocket
+{
+public:
+	static const uint MAX_PACKET_SIZE = 65507;
+
+	UdpSocket();
+	~UdpSocket();
+
+	bool Open(unsigned short port);
+	void Close(void);
+	bool IsOpen() const { return mOpen; }
+	unsigned short GetPort() const { return mPort; }
+
+	bool Send(const NetAddress& to, const char* data, uint size);
+	int Receive(NetAddress& from, char* buffer, uint capacity);
+
+	static bool ParseAddress(const string& text, unsigned short default_port, NetAddress& address);
+	static string FormatAddress(const NetAddress& address);
+
+private:
+	// A SOCKET on Windows, a file descriptor elsewhere
+	uintptr_t mSocket;
+	bool mOpen;
+	unsigned short mPort;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include <string.h>
+#include "DeltaEncoding.h"
+#include "FileUtil.h"
+#include "GameObject.h"
+#include "WorldSnapshot.h"
+
+const char WorldSnapshot::MAGIC[4] = { 'W', 'S', 'N', 'P' };
+
+// PUBLIC INSTANCE CONSTRUCTORS ///////////////////////////////////////////////
+
+/** Default constructor. */
+WorldSnapshot::WorldSnapshot()
+{
+	Clear();
+}
+
+/** Destructor. */
+WorldSnapshot::~WorldSnapshot()
+{
+}
+
+// PUBLIC INSTANCE METHODS ////////////////////////////////////////////////////
+
+void WorldSnapshot::Clear(void)
+{
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	objects.clear();
+	timers.clear();
+	values.clear();
+}
+
+void WorldSnapshot::SetValue(uint key, int value)
+{
+	for (uint i = 0; i < values.size(); i++) {
+		if (values[i].key == key) { values[i].value = value; return; }
+	}
+	SnapshotValue entry = { key, value };
+	values.push_back(entry);
+}
+
+int WorldSnapshot::GetValue(uint key, int default_value) const
+{
+	for (uint i = 0; i < values.size(); i++) {
+		if (values[i].key == key) return values[i].value;
+	}
+	return default_value;
+}
+
+/** The checksum GameWorld::GetStateChecksum gave for the world when this was taken. */
+uint WorldSnapshot::GetChecksum() const
+{
+	uint hash = 2166136261u;
+	for (uint i = 0; i < objects.size(); i++) {
+		const GameObjectState& state = objects[i];
+		GLfloat values[] = { state.position.x, state.position.y, state.velocity.x, state.velocity.y, state.angle, state.scale };
+		const uchar* bytes = (const uchar*)values;
+		for (uint j = 0; j < sizeof(values); j++) hash = (hash ^ bytes[j]) * 16777619u;
+		hash = (hash ^ state.id) * 16777619u;
+	}
+	return hash;
+}
+
+/** Encode the whole snapshot: the header, then the objects, timers and values as they are in memory. */
+void WorldSnapshot::Encode(string& data) const
+{
+	WorldSnapshotHeader encoded_header = header;
+	encoded_header.num_objects = (uint)objects.size();
+	encoded_header.num_timers = (uint)timers.size();
+	encoded_header.num_values = (uint)values.size();
+
+	data.clear();
+	data.reserve(sizeof(encoded_header) + objects.size() * sizeof(GameObjectState)
+		+ timers.size() * sizeof(TimerState) + values.size() * sizeof(SnapshotValue));
+	data.append((const char*)&encoded_header, sizeof(encoded_header));
+	if (!objects.empty()) data.append((const char*)&objects[0], objects.size() * sizeof(GameObjectState));
+	if (!timers.empty()) data.append((const char*)&timers[0], timers.size() * sizeof(TimerState));
+	if (!values.empty()) data.append((const char*)&values[0], values.size() * sizeof(SnapshotValue));
+}
+
+bool WorldSnapshot::Decode(const char* data, size_t size)
+{
+	if (size < sizeof(WorldSnapshotHeader)) return false;
+	WorldSnapshotHeader decoded_header;
+	memcpy(&decoded_header, data, sizeof(decoded_header));
+	if (0 != memcmp(decoded_header.magic, MAGIC, sizeof(decoded_header.magic)) || decoded_header.version != VERSION) return false;
+	size_t offset = sizeof(decoded_header);
+	if ((size - offset) / sizeof(GameObjectState) < decoded_header.num_objects) return false;
+	size_t objects_size = (size_t)decoded_header.num_objects * sizeof(GameObjectState);
+	if (!HasArrays(decoded_header, size - offset - objects_size)) return false;
+
+	header = decoded_header;
+	objects.resize(header.num_objects);
+	// The records are plain 4 byte fields, though GLVector3f gives them a copy constructor
+	if (!objects.empty()) memcpy((void*)&objects[0], data + offset, objects_size);
+	ReadArrays(data + offset + objects_size);
+	return true;
+}
+
+/** Encode the snapshot as changes from base, which the receiver must already have.
+	Each object is XORed with the one in base with the same id, so whatever has
+	not changed becomes zeros, and then runs of zeros are replaced by their length. */
+void WorldSnapshot::EncodeDelta(const WorldSnapshot& base, string& data) const
+{
+	WorldSnapshotHeader encoded_header = header;
+	encoded_header.num_objects = (uint)objects.size();
+	encoded_header.num_timers = (uint)timers.size();
+	encoded_header.num_values = (uint)values.size();
+
+	string raw;
+	raw.reserve(sizeof(encoded_header) + objects.size() * (sizeof(GameObjectState) + 1)
+		+ timers.size() * sizeof(TimerState) + values.size() * sizeof(SnapshotValue));
+	raw.resize(sizeof(encoded_header));
+	DeltaEncoding::XorBytes(&raw[0], (const char*)&encoded_header, (const char*)&base.header, sizeof(encoded_header));
+	DeltaEncoding::AppendRecords(objects, base.objects, raw);
+
+	// Timers and values are few and change rarely, so they are sent as they are
+	if (!timers.empty()) raw.append((const char*)&timers[0], timers.size() * sizeof(TimerState));
+	if (!values.empty()) raw.append((const char*)&values[0], values.size() * sizeof(SnapshotValue));
+
+	DeltaEncoding::CompressZeroRuns(raw.data(), raw.size(), data);
+}
+
+bool WorldSnapshot::DecodeDelta(const WorldSnapshot& base, const char* data, size_t size)
+{
+	string raw;
+	if (!DeltaEncoding::ExpandZeroRuns(data, size, MAX_RAW_SIZE, raw) || raw.size() < sizeof(WorldSnapshotHeader)) return false;
+
+	WorldSnapshotHeader decoded_header;
+	DeltaEncoding::XorBytes((char*)&decoded_header, raw.data(), (const char*)&base.header, sizeof(decoded_header));
+	if (0 != memcmp(decoded_header.magic, MAGIC, sizeof(decoded_header.magic)) || decoded_header.version != VERSION) return false;
+
+	size_t offset = sizeof(decoded_header);
+	vector<GameObjectState> decoded_objects;
+	if (!DeltaEncoding::ReadRecords(raw.data(), raw.size(), offset, decoded_header.num_objects, base.objects, decoded_objects)) return false;
+	if (!HasArrays(decoded_header, raw.size() - offset)) return false;
+
+	header = decoded_header;
+	objects.swap(decoded_objects);
+	ReadArrays(raw.data() + offset);
+	return true;
+}
+
+/** Write the snapshot to a file in one step, so a crash part way through
+	leaves the last snapshot saved rather than half of this one. */
+bool WorldSnapshot::Save(const string& filename) const
+{
+	string data;
+	Encode(data);
+	string temp_filename = filename + ".tmp";
+	ofstream file(temp_filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!file) { cerr << "Error opening " << temp_filename << endl; return false; }
+	file.write(data.data(), data.size());
+	file.close();
+	if (!file) { cerr << "Error writing " << temp_filename << endl; return false; }
+	if (!FileUtil::Replace(temp_filename, filename)) { cerr << "Error replacing " << filename << endl; return false; }
+	return true;
+}
+
+bool WorldSnapshot::Load(const string& filename)
+{
+	ifstream file(filename.c_str(), ios::in | ios::binary);
+	if (!file) { cerr << "Error opening " << filename << endl; return false; }
+	string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	if (!Decode(data.data(), data.size())) {
+		cerr << "Invalid snapshot " << filename << endl;
+		Clear();
+		return false;
+	}
+	return true;
+}
+
+// PRIVATE INSTANCE METHODS ///////////////////////////////////////////////////
+
+/** Read the timers and values that follow the objects, once HasArrays has checked their size. */
+void WorldSnapshot::ReadArrays(const char* data)
+{
+	timers.resize(header.num_timers);
+	values.resize(header.num_values);
+	if (!timers.empty()) memcpy(&timers[0], data, timers.size() * sizeof(TimerState));
+	if (!values.empty()) memcpy(&values[0], data + timers.size() * sizeof(TimerState), values.size() * sizeof(SnapshotValue));
+}
+
+// PRIVATE STATIC METHODS /////////////////////////////////////////////////////
+
+/** Whether size bytes hold exactly the timers and values counted in the header. The
+	counts are divided into the size, as multiplying them can overflow a 32 bit size_t. */
+bool WorldSnapshot::HasArrays(const WorldSnapshotHeader& header, size_t size)
+{
+	if (header.num_timers > size / sizeof(TimerState)) return false;
+	size -= (size_t)header.num_timers * sizeof(TimerState);
+	return size % sizeof(SnapshotValue) == 0 && size / sizeof(SnapshotValue) == header.num_values;
+}
\ No newline at end of file
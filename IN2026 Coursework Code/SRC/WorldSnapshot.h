@@ -0,0 +1,104 @@
+#ifndef __WORLDSNAPSHOT_H__
+#define __WORLDSNAPSHOT_H__
+
+#include <vector>
+#include "GameUtil.h"
+#include "GameWorld.h"
+#include "TimerWheel.h"
+
+enum GameObjectStateFlags
+{
+	GAME_OBJECT_STATE_HAS_SPRITE = 1,
+	GAME_OBJECT_STATE_ANIMATING = 2,
+};
+
+// Everything about one object, in a fixed size record of 4 byte fields that
+// can be copied and compared as bytes
+struct GameObjectState
+{
+	uint id;
+	uint type;
+	GLVector3f position;
+	GLVector3f velocity;
+	GLVector3f acceleration;
+	GLfloat angle;
+	GLfloat rotation;
+	GLfloat scale;
+	uint render_layer;
+	uint flags;
+	int sprite_frame;
+	int sprite_millis;
+	// Kept by subclasses, e.g. a bullet's time to live or a ship's thrust
+	int user_int;
+	GLfloat user_float;
+};
+
+// A value belonging to the game rather than the world, e.g. the score
+struct SnapshotValue
+{
+	uint key;
+	int value;
+};
+
+// The fixed size start of an encoded snapshot
+struct WorldSnapshotHeader
+{
+	char magic[4];
+	uint version;
+	uint time;
+	uint step_count;
+	uint timer_time;
+	uint next_timer_sequence;
+	uint seed;
+	uint random_state[RANDOM_STREAM_COUNT][4];
+	uint next_object_id;
+	int width;
+	int height;
+	uint num_objects;
+	uint num_timers;
+	uint num_values;
+};
+
+// The whole state of a world at the end of a step: its objects in id order,
+// timers, random streams and clock, plus values saved by the game. Encoded,
+// it is the header followed by each array as it is in memory. A delta
+// against an earlier snapshot XORs each object with the one with the same id
+// and run-length encodes the zeros, so it costs little for objects that have
+// not changed.
+class WorldSnapshot
+{
+public:
+	static const char MAGIC[4];
+	static const uint VERSION = 1;
+	// Largest a delta may expand to when decoded, about 800,000 objects
+	static const uint MAX_RAW_SIZE = 1 << 26;
+
+	WorldSnapshot();
+	~WorldSnapshot();
+
+	void Clear(void);
+
+	void SetValue(uint key, int value);
+	int GetValue(uint key, int default_value = 0) const;
+	uint GetChecksum() const;
+
+	void Encode(string& data) const;
+	bool Decode(const char* data, size_t size);
+	void EncodeDelta(const WorldSnapshot& base, string& data) const;
+	bool DecodeDelta(const WorldSnapshot& base, const char* data, size_t size);
+
+	bool Save(const string& filename) const;
+	bool Load(const string& filename);
+
+	WorldSnapshotHeader header;
+	vector<GameObjectState> objects;
+	TimerStateVector timers;
+	vector<SnapshotValue> values;
+
+private:
+	void ReadArrays(const char* data);
+
+	static bool HasArrays(const WorldSnapshotHeader& header, size_t size);
+};
+
+#endif
\ No newline at end of file
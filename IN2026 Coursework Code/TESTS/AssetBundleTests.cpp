@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include "AssetBundle.h"
+#include "Shape.h"
+#include "Tests.h"
+
+TEST(AssetBundleMapsShapes)
+{
+	Tests::WriteFile("BundleTest.shape", "loop\n0 1 0\n0 1\n1 -1\n-1 -1\n");
+	Tests::WriteFile("BundleTest.manifest", "# shape name file\n\nshape triangle BundleTest.shape\n");
+	CHECK(AssetBundle::BuildBundle("BundleTest.bundle", "BundleTest.manifest"));
+
+	AssetBundle bundle;
+	CHECK(bundle.Open("BundleTest.bundle"));
+	CHECK(bundle.GetEntryCount() == 1);
+	CHECK(bundle.FindEntry("square") == NULL);
+	const AssetBundleEntry* entry = bundle.FindEntry("triangle");
+	CHECK(entry != NULL);
+	if (entry != NULL) {
+		CHECK(entry->type == ASSET_BUNDLE_SHAPE);
+		CHECK(entry->offset % AssetBundle::ALIGNMENT == 0);
+		Shape shape;
+		CHECK(shape.LoadCompiledShape(bundle.GetData(*entry), entry->size));
+		CHECK(shape.GetPoints().size() == 3);
+	}
+	bundle.Close();
+	CHECK(!bundle.IsOpen());
+
+	// A bundle cut short no longer holds its entries, so is not opened
+	string data = Tests::ReadFile("BundleTest.bundle");
+	Tests::WriteFile("BundleTest.bundle", data.substr(0, data.size() - 1));
+	CHECK(!bundle.Open("BundleTest.bundle"));
+	Tests::WriteFile("BundleTest.bundle", "");
+	CHECK(!bundle.Open("BundleTest.bundle"));
+	CHECK(!bundle.Open("BundleTest.missing"));
+	CHECK(!bundle.IsOpen());
+
+	remove("BundleTest.shape");
+	remove("BundleTest.manifest");
+	remove("BundleTest.bundle");
+}
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include "GameObject.h"
+#include "GameWorld.h"
+#include "HighScoreStore.h"
+#include "InterestManager.h"
+#include "NetProtocol.h"
+#include "PixelKernels.h"
+#include "RandomStream.h"
+#include "SimulationClock.h"
+#include "WorldSnapshot.h"
+#include "Tests.h"
+
+// Benchmarks print timings rather than checking anything, and only run when
+// asked for, e.g. "Tests --bench Snapshots"
+
+/** Time every kernel at every supported level on a sheet the size of the asteroid sprites,
+	checking each level produces the same pixels as the scalar kernels. */
+BENCHMARK(Kernels)
+{
+	const uint width = 128, height = 8192, iterations = 20;
+	// Random pixels in FreeImage's layout, with rows padded to 4 bytes and
+	// about a quarter of them black so the colour key has work to do
+	uint pitch24 = (3 * width + 3) & ~3u;
+	uint num_pixels = width * height;
+	vector<uchar> src24(pitch24 * height);
+	vector<uchar> src32(4 * num_pixels);
+	srand(1);
+	for (uint i = 0; i < src24.size(); i++) src24[i] = (rand() % 4 == 0) ? 0 : (uchar)rand();
+	for (uint i = 0; i < src32.size(); i++) src32[i] = (rand() % 4 == 0) ? 0 : (uchar)rand();
+
+	const char* kernel_names[] = { "expand 24bpp rotate 180", "copy 32bpp rotate 180", "colour key", "premultiply alpha", "downsample 2x2" };
+	const uint num_kernels = 5;
+	vector<uchar> reference[num_kernels];
+	vector<uchar> output(4 * num_pixels);
+
+	PixelKernelLevel saved_level = PixelKernels::GetLevel();
+	cout << "Pixel kernels on " << width << "x" << height << ", " << iterations << " passes each" << endl;
+	for (int level = PIXEL_KERNELS_SCALAR; level <= PixelKernels::GetSupportedLevel(); level++) {
+		PixelKernels::SetLevel((PixelKernelLevel)level);
+		for (uint kernel = 0; kernel < num_kernels; kernel++) {
+			double total_millis = 0.0;
+			for (uint pass = 0; pass < iterations; pass++) {
+				// In-place kernels start from the same pixels every pass
+				if (kernel >= 2) memcpy(&output[0], &src32[0], output.size());
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				switch (kernel)
+				{
+				case 0: PixelKernels::ConvertToBGRA(&src24[0], pitch24, 24, &output[0], width, height, PIXEL_ORIENTATION_ROTATE_180); break;
+				case 1: PixelKernels::ConvertToBGRA(&src32[0], 4 * width, 32, &output[0], width, height, PIXEL_ORIENTATION_ROTATE_180); break;
+				case 2: PixelKernels::ApplyColourKey(&output[0], num_pixels, 0, 0, 0); break;
+				case 3: PixelKernels::PremultiplyAlpha(&output[0], num_pixels); break;
+				case 4: PixelKernels::Downsample2x2(&src32[0], 4 * width, &output[0], width / 2, height / 2); break;
+				}
+				total_millis += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			}
+			if (level == PIXEL_KERNELS_SCALAR) reference[kernel] = output;
+			bool matches = (output == reference[kernel]);
+			double millis = total_millis / iterations;
+			cout << "  " << PixelKernels::GetLevelName(PixelKernels::GetLevel()) << "\t" << kernel_names[kernel] << "\t" << millis << " ms\t"
+				<< (num_pixels / 1000.0) / millis << " Mpixels/s" << (matches ? "" : "\tMISMATCH") << endl;
+		}
+	}
+	PixelKernels::SetLevel(saved_level);
+}
+
+/** Time taking, encoding and restoring snapshots of a world of moving objects. */
+BENCHMARK(Snapshots)
+{
+	const uint num_objects = 10000, iterations = 100;
+	GameWorld world;
+	world.SetWidth(800);
+	world.SetHeight(600);
+	world.SetSeed(1);
+	RandomStream& random = world.GetRandom(RANDOM_STREAM_SPAWN);
+	vector< shared_ptr<GameObject> > moving;
+	for (uint i = 0; i < num_objects; i++) {
+		shared_ptr<GameObject> object = make_shared<GameObject>("Benchmark");
+		object->SetPosition(GLVector3f(random.NextFloat(-400, 400), random.NextFloat(-300, 300), 0));
+		object->SetVelocity(GLVector3f(random.NextFloat(-50, 50), random.NextFloat(-50, 50), 0));
+		object->SetRotation(random.NextFloat(-90, 90));
+		world.AddObject(object);
+		moving.push_back(object);
+	}
+
+	// Objects are moved directly, as a full step would spend its time on collisions
+	WorldSnapshot previous, current, decoded;
+	world.TakeSnapshot(previous);
+	string full, delta;
+	double take_millis = 0.0, encode_millis = 0.0, delta_millis = 0.0, decode_millis = 0.0, restore_millis = 0.0;
+	size_t delta_bytes = 0;
+	bool matches = true;
+	for (uint pass = 0; pass < iterations; pass++) {
+		for (uint i = 0; i < moving.size(); i++) moving[i]->Update(SimulationClock::STEP_MILLIS);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		world.TakeSnapshot(current);
+		chrono::steady_clock::time_point taken = chrono::steady_clock::now();
+		current.Encode(full);
+		chrono::steady_clock::time_point encoded = chrono::steady_clock::now();
+		current.EncodeDelta(previous, delta);
+		chrono::steady_clock::time_point delta_encoded = chrono::steady_clock::now();
+		matches = decoded.DecodeDelta(previous, delta.data(), delta.size()) && matches;
+		chrono::steady_clock::time_point decoded_time = chrono::steady_clock::now();
+		world.RestoreSnapshot(current);
+		chrono::steady_clock::time_point restored = chrono::steady_clock::now();
+
+		take_millis += chrono::duration<double, milli>(taken - start).count();
+		encode_millis += chrono::duration<double, milli>(encoded - taken).count();
+		delta_millis += chrono::duration<double, milli>(delta_encoded - encoded).count();
+		decode_millis += chrono::duration<double, milli>(decoded_time - delta_encoded).count();
+		restore_millis += chrono::duration<double, milli>(restored - decoded_time).count();
+		delta_bytes += delta.size();
+		matches = matches && decoded.objects.size() == current.objects.size()
+			&& (current.objects.empty() || 0 == memcmp(&decoded.objects[0], &current.objects[0], current.objects.size() * sizeof(GameObjectState)));
+		previous.objects.swap(current.objects);
+		previous.header = current.header;
+		previous.timers = current.timers;
+		previous.values = current.values;
+	}
+
+	cout << "World snapshots of " << num_objects << " objects, " << iterations << " passes" << endl;
+	cout << "  take\t\t" << take_millis / iterations << " ms" << endl;
+	cout << "  encode\t" << encode_millis / iterations << " ms\t" << full.size() << " bytes" << endl;
+	cout << "  encode delta\t" << delta_millis / iterations << " ms\t" << delta_bytes / iterations << " bytes" << endl;
+	cout << "  decode delta\t" << decode_millis / iterations << " ms\t" << (matches ? "matches" : "MISMATCH") << endl;
+	cout << "  restore\t" << restore_millis / iterations << " ms" << endl;
+}
+
+/** Time choosing and encoding snapshots for more and more clients in a large world, and report
+	the bandwidth each client needs, sending everything and then with interest management. */
+BENCHMARK(Interest)
+{
+	const uint num_objects = 5000, iterations = 50;
+	static const uint CLIENT_COUNTS[] = { 1, 2, 4, 8, 16, 32, 64 };
+	static const uint SEND_RATE = 20;
+	static const uint ACK_DELAY = 2;
+	static const uint HISTORY = ACK_DELAY + 1;
+
+	GameWorld world;
+	world.SetWidth(2000);
+	world.SetHeight(2000);
+	world.SetSeed(1);
+	RandomStream& random = world.GetRandom(RANDOM_STREAM_SPAWN);
+	vector< shared_ptr<GameObject> > moving;
+	for (uint i = 0; i < num_objects; i++) {
+		shared_ptr<GameObject> object = make_shared<GameObject>("Benchmark");
+		object->SetPosition(GLVector3f(random.NextFloat(-1000, 1000), random.NextFloat(-1000, 1000), 0));
+		object->SetVelocity(GLVector3f(random.NextFloat(-30, 30), random.NextFloat(-30, 30), 0));
+		object->SetRotation(random.NextFloat(-90, 90));
+		world.AddObject(object);
+		moving.push_back(object);
+	}
+
+	cout << "Snapshots of " << num_objects << " objects in a 2000 x 2000 world, " << iterations << " sends at "
+		<< SEND_RATE << " Hz" << endl;
+	cout << "  clients\tmode\t\tms a send\tserver CPU\tbytes a client\tkB/s a client" << endl;
+	WorldSnapshot world_snapshot;
+	NetSnapshot snapshot;
+	string data;
+	for (uint c = 0; c < sizeof(CLIENT_COUNTS) / sizeof(CLIENT_COUNTS[0]); c++) {
+		uint num_clients = min(CLIENT_COUNTS[c], num_objects);
+		for (uint mode = 0; mode < 2; mode++) {
+			// Each client's focus is one of the objects, standing in for its ship
+			InterestManager manager;
+			if (mode == 1) {
+				manager.SetViewRadius(250);
+				manager.SetByteBudget(1200);
+			}
+			vector<ClientInterest> clients(num_clients);
+			vector< vector<NetSnapshot> > sent(num_clients, vector<NetSnapshot>(HISTORY));
+			for (uint i = 0; i < num_clients; i++) clients[i].focus_id = moving[i]->GetId();
+
+			double millis = 0;
+			size_t bytes = 0;
+			for (uint pass = 0; pass < iterations; pass++) {
+				// Objects are moved directly, as a full step would spend its time on collisions
+				for (uint step = 0; step < 1000 / SEND_RATE / SimulationClock::STEP_MILLIS; step++) {
+					for (uint i = 0; i < moving.size(); i++) moving[i]->Update(SimulationClock::STEP_MILLIS);
+				}
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				world.TakeSnapshot(world_snapshot);
+				snapshot.FromWorldSnapshot(world_snapshot);
+				snapshot.header.sequence = pass + 1;
+				manager.Index(snapshot);
+				for (uint i = 0; i < num_clients; i++) {
+					// Acknowledged a round trip after it was sent
+					const NetSnapshot* base = (pass >= ACK_DELAY) ? &sent[i][(pass - ACK_DELAY) % HISTORY] : NULL;
+					NetSnapshot& selected = sent[i][pass % HISTORY];
+					manager.Select(clients[i], snapshot, base, selected);
+					data.clear();
+					NetProtocol::WriteHeader(data, NET_MESSAGE_SNAPSHOT);
+					selected.Encode(base, data);
+					bytes += data.size();
+				}
+				millis += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			}
+			double send_millis = millis / iterations;
+			double client_bytes = (double)bytes / iterations / num_clients;
+			cout << "  " << num_clients << "\t\t" << (mode == 0 ? "everything" : "interest") << "\t" << send_millis << "\t\t"
+				<< send_millis * SEND_RATE / 10 << "%\t\t" << client_bytes << "\t\t"
+				<< (client_bytes + NetProtocol::PACKET_OVERHEAD) * SEND_RATE / 1000 << endl;
+		}
+	}
+}
+
+/** Time the table's operations on a large number of scores, then time adding them to
+	a store and reading them back, and report how long the game waits for each. */
+BENCHMARK(HighScores)
+{
+	const uint num_entries = 100000, iterations = 10000;
+	RandomStream random(1);
+	vector<HighScoreEntry> entries(num_entries);
+	for (uint i = 0; i < num_entries; i++) {
+		memset(&entries[i], 0, sizeof(entries[i]));
+		entries[i].score = random.NextInt(0, 1000000);
+		entries[i].sequence = i + 1;
+		sprintf(entries[i].name, "Player %u", random.NextInt(1000));
+	}
+
+	HighScoreTable table(num_entries);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (uint i = 0; i < num_entries; i++) table.Add(entries[i]);
+	chrono::steady_clock::time_point added = chrono::steady_clock::now();
+	vector<HighScoreEntry> top;
+	for (uint i = 0; i < iterations; i++) table.GetRange(1, 10, top);
+	chrono::steady_clock::time_point read_top = chrono::steady_clock::now();
+	uint rank_total = 0;
+	for (uint i = 0; i < iterations; i++) rank_total += table.GetRank(random.NextInt(0, 1000000));
+	chrono::steady_clock::time_point ranked = chrono::steady_clock::now();
+	for (uint i = 0; i < iterations; i++) table.GetRange(random.NextInt(num_entries) + 1, 10, top);
+	chrono::steady_clock::time_point read_range = chrono::steady_clock::now();
+
+	cout << "High score table of " << num_entries << " scores" << endl;
+	cout << "  add\t\t" << chrono::duration<double, micro>(added - start).count() / num_entries << " us" << endl;
+	cout << "  top 10\t" << chrono::duration<double, micro>(read_top - added).count() / iterations << " us" << endl;
+	cout << "  rank\t\t" << chrono::duration<double, micro>(ranked - read_top).count() / iterations << " us"
+		<< " (average rank " << rank_total / iterations << ")" << endl;
+	cout << "  10 from a rank\t" << chrono::duration<double, micro>(read_range - ranked).count() / iterations << " us" << endl;
+
+	// The store keeps the top MAX_ENTRIES, compacting the log as scores fall off it
+	const char* filename = "HighScoresBenchmark.log";
+	remove(filename);
+	HighScoreStore store;
+	if (!store.Open(filename)) return;
+	double longest_add = 0;
+	start = chrono::steady_clock::now();
+	for (uint i = 0; i < num_entries; i++) {
+		chrono::steady_clock::time_point add_start = chrono::steady_clock::now();
+		store.Add(entries[i].name, entries[i].score);
+		longest_add = max(longest_add, chrono::duration<double, micro>(chrono::steady_clock::now() - add_start).count());
+	}
+	added = chrono::steady_clock::now();
+	store.Close();
+	chrono::steady_clock::time_point written = chrono::steady_clock::now();
+	HighScoreStore loaded;
+	bool matches = loaded.Open(filename);
+	chrono::steady_clock::time_point opened = chrono::steady_clock::now();
+	matches = matches && loaded.GetTable().GetCount() == store.GetTable().GetCount();
+	for (uint rank = 1; matches && rank <= store.GetTable().GetCount(); rank += 97) {
+		matches = 0 == memcmp(loaded.GetTable().GetEntry(rank), store.GetTable().GetEntry(rank), sizeof(HighScoreEntry));
+	}
+	loaded.Close();
+	remove(filename);
+
+	cout << "High score store of " << HighScoreStore::MAX_ENTRIES << " scores, adding " << num_entries << endl;
+	cout << "  add\t\t" << chrono::duration<double, micro>(added - start).count() / num_entries << " us, longest "
+		<< longest_add << " us" << endl;
+	cout << "  write the rest\t" << chrono::duration<double, milli>(written - added).count() << " ms" << endl;
+	cout << "  open\t\t" << chrono::duration<double, milli>(opened - written).count() << " ms" << endl;
+	cout << "  read back\t" << (matches ? "matches" : "DOES NOT MATCH") << endl;
+}
\ No newline at end of file
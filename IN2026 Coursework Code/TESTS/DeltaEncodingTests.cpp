@@ -0,0 +1,177 @@
+#include <string.h>
+#include "DeltaEncoding.h"
+#include "NetSnapshot.h"
+#include "RandomStream.h"
+#include "Tests.h"
+
+static bool RoundTrips(const string& raw, size_t* compressed_size = NULL)
+{
+	string compressed, expanded;
+	DeltaEncoding::CompressZeroRuns(raw.data(), raw.size(), compressed);
+	if (compressed_size) *compressed_size = compressed.size();
+	return DeltaEncoding::ExpandZeroRuns(compressed.data(), compressed.size(), raw.size(), expanded) && expanded == raw;
+}
+
+static NetObjectState MakeObject(uint id, RandomStream& random)
+{
+	NetObjectState object = NetObjectState();
+	object.id = id;
+	object.type = 1 + random.NextInt(3);
+	object.position[0] = (short)random.NextInt(-3000, 3000);
+	object.position[1] = (short)random.NextInt(-3000, 3000);
+	object.angle = (unsigned short)random.NextInt(65536);
+	object.scale = NetSnapshot::SCALE_SCALE;
+	return object;
+}
+
+TEST(VarintRoundTrip)
+{
+	const size_t values[] = { 0, 1, 127, 128, 300, 16383, 16384, 0xFFFFFFFFu, (size_t)-1 };
+	string data;
+	for (uint i = 0; i < sizeof(values) / sizeof(values[0]); i++) DeltaEncoding::WriteVarint(data, values[i]);
+	size_t offset = 0, value;
+	for (uint i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		CHECK(DeltaEncoding::ReadVarint(data.data(), data.size(), offset, value));
+		CHECK(value == values[i]);
+	}
+	CHECK(offset == data.size());
+	CHECK(!DeltaEncoding::ReadVarint(data.data(), data.size(), offset, value));
+
+	// Cut off part way through, and too long to be any size_t
+	string cut(1, (char)0x80);
+	offset = 0;
+	CHECK(!DeltaEncoding::ReadVarint(cut.data(), cut.size(), offset, value));
+	string endless(16, (char)0xFF);
+	offset = 0;
+	CHECK(!DeltaEncoding::ReadVarint(endless.data(), endless.size(), offset, value));
+}
+
+TEST(ZeroRunsRoundTrip)
+{
+	CHECK(RoundTrips(string()));
+	CHECK(RoundTrips(string(1, '\0')));
+	CHECK(RoundTrips(string(3, 'x')));
+
+	size_t compressed_size;
+	CHECK(RoundTrips(string(100000, '\0'), &compressed_size));
+	CHECK(compressed_size < 16);
+
+	// Sparse changes in a long run of zeros, as in a delta of a slowly changing world
+	RandomStream random(3);
+	for (uint density = 1; density <= 256; density *= 4) {
+		string raw(5000, '\0');
+		for (uint i = 0; i < raw.size(); i++) {
+			if (random.NextInt(256) < density) raw[i] = (char)(1 + random.NextInt(255));
+		}
+		CHECK(RoundTrips(raw, &compressed_size));
+		if (density == 1) CHECK(compressed_size < raw.size() / 10);
+	}
+}
+
+TEST(ZeroRunsRejectBadInput)
+{
+	string raw(1000, '\0');
+	raw[10] = 1;
+	raw[500] = 2;
+	string compressed, expanded;
+	DeltaEncoding::CompressZeroRuns(raw.data(), raw.size(), compressed);
+
+	CHECK(!DeltaEncoding::ExpandZeroRuns(compressed.data(), compressed.size(), raw.size() - 1, expanded));
+	CHECK(!DeltaEncoding::ExpandZeroRuns(compressed.data(), compressed.size() - 1, raw.size(), expanded));
+	string trailing = compressed + 'x';
+	CHECK(!DeltaEncoding::ExpandZeroRuns(trailing.data(), trailing.size(), raw.size(), expanded));
+	CHECK(!DeltaEncoding::ExpandZeroRuns(compressed.data(), 0, raw.size(), expanded));
+
+	// A few bytes claiming gigabytes are turned away before anything is allocated
+	string huge;
+	DeltaEncoding::WriteVarint(huge, (size_t)1 << 40);
+	DeltaEncoding::WriteVarint(huge, (size_t)1 << 40);
+	DeltaEncoding::WriteVarint(huge, 0);
+	CHECK(!DeltaEncoding::ExpandZeroRuns(huge.data(), huge.size(), NetSnapshot::MAX_RAW_SIZE, expanded));
+
+	// Runs that go past the end of the data or the size given
+	string long_zeros;
+	DeltaEncoding::WriteVarint(long_zeros, 10);
+	DeltaEncoding::WriteVarint(long_zeros, 11);
+	DeltaEncoding::WriteVarint(long_zeros, 0);
+	CHECK(!DeltaEncoding::ExpandZeroRuns(long_zeros.data(), long_zeros.size(), 100, expanded));
+	string long_literals;
+	DeltaEncoding::WriteVarint(long_literals, 10);
+	DeltaEncoding::WriteVarint(long_literals, 0);
+	DeltaEncoding::WriteVarint(long_literals, 10);
+	long_literals += "abc";
+	CHECK(!DeltaEncoding::ExpandZeroRuns(long_literals.data(), long_literals.size(), 100, expanded));
+}
+
+TEST(RecordsRoundTripAgainstBase)
+{
+	RandomStream random(5);
+	vector<NetObjectState> base, records, decoded;
+	for (uint id = 1; id <= 100; id++) base.push_back(MakeObject(id, random));
+	// Keep most, change some, drop some and add new ones past the end
+	for (uint i = 0; i < base.size(); i++) {
+		if (i % 7 == 3) continue;
+		records.push_back(base[i]);
+		if (i % 5 == 0) records.back().position[0]++;
+	}
+	for (uint id = 150; id < 160; id++) records.push_back(MakeObject(id, random));
+
+	string raw;
+	DeltaEncoding::AppendRecords(records, base, raw);
+	size_t offset = 0;
+	CHECK(DeltaEncoding::ReadRecords(raw.data(), raw.size(), offset, (uint)records.size(), base, decoded));
+	CHECK(offset == raw.size());
+	CHECK(decoded.size() == records.size());
+	CHECK(!decoded.empty() && 0 == memcmp(&decoded[0], &records[0], records.size() * sizeof(NetObjectState)));
+
+	// More records than the bytes could hold, and bytes cut short
+	offset = 0;
+	CHECK(!DeltaEncoding::ReadRecords(raw.data(), raw.size(), offset, 0xFFFFFFFFu, base, decoded));
+	offset = 0;
+	CHECK(!DeltaEncoding::ReadRecords(raw.data(), raw.size() - 1, offset, (uint)records.size(), base, decoded));
+}
+
+TEST(NetSnapshotRoundTripAgainstBase)
+{
+	RandomStream random(9);
+	NetSnapshot base, current, decoded, decoded_full;
+	base.header.sequence = 4;
+	for (uint id = 1; id <= 200; id++) base.objects.push_back(MakeObject(id, random));
+	current = base;
+	current.header.sequence = 7;
+	current.objects[20].position[1] += 3;
+	current.objects.push_back(MakeObject(300, random));
+	SnapshotValue score = { 1, 4200 };
+	current.values.push_back(score);
+
+	string delta, full;
+	current.Encode(&base, delta);
+	current.Encode(NULL, full);
+	CHECK(delta.size() < full.size() / 4);
+	CHECK(decoded.Decode(&base, delta.data(), delta.size()));
+	CHECK(decoded_full.Decode(NULL, full.data(), full.size()));
+	CHECK(decoded.objects.size() == current.objects.size());
+	CHECK(0 == memcmp(&decoded.objects[0], &current.objects[0], current.objects.size() * sizeof(NetObjectState)));
+	CHECK(0 == memcmp(&decoded_full.objects[0], &current.objects[0], current.objects.size() * sizeof(NetObjectState)));
+	CHECK(decoded.values.size() == 1 && decoded.values[0].value == 4200);
+
+	// Only against the base it was encoded from
+	CHECK(!decoded.Decode(NULL, delta.data(), delta.size()));
+	CHECK(!decoded.Decode(&current, delta.data(), delta.size()));
+	CHECK(!decoded.Decode(&base, delta.data(), delta.size() - 1));
+}
+
+TEST(NetSnapshotRejectsValueCountWithoutValues)
+{
+	NetSnapshot empty, decoded;
+	empty.header.sequence = 1;
+	string data;
+	empty.Encode(NULL, data);
+	// Times the size of a value, this is 4 GB, or nothing with a 32 bit size_t
+	NetSnapshotHeader header;
+	CHECK(NetSnapshot::ReadHeader(data.data(), data.size(), header));
+	header.num_values = 0x20000000;
+	memcpy(&data[0], &header, sizeof(header));
+	CHECK(!decoded.Decode(NULL, data.data(), data.size()));
+	CHECK(decoded.values.empty());
+}
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include "HighScoreStore.h"
+#include "HighScoreTable.h"
+#include "RandomStream.h"
+#include "Tests.h"
+
+static HighScoreEntry MakeEntry(int score, uint sequence)
+{
+	HighScoreEntry entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.score = score;
+	entry.sequence = sequence;
+	sprintf(entry.name, "Player %u", sequence);
+	return entry;
+}
+
+static bool SameEntry(const HighScoreEntry* a, const HighScoreEntry& b)
+{
+	return a != NULL && 0 == memcmp(a, &b, sizeof(b));
+}
+
+static size_t GetFileSize(const char* filename)
+{
+	ifstream file(filename, ios::in | ios::binary | ios::ate);
+	return file ? (size_t)file.tellg() : 0;
+}
+
+TEST(HighScoreTableMatchesSortedScores)
+{
+	HighScoreTable table(1000);
+	vector<HighScoreEntry> sorted;
+	RandomStream random(3);
+	for (uint i = 0; i < 500; i++) {
+		// A narrow range of scores, so many are tied
+		HighScoreEntry entry = MakeEntry(random.NextInt(0, 100), i + 1);
+		table.Add(entry);
+		sorted.push_back(entry);
+	}
+	sort(sorted.begin(), sorted.end(), HighScoreTable::IsBefore);
+	CHECK(table.GetCount() == 500);
+	CHECK(table.GetEntry(0) == NULL);
+	CHECK(table.GetEntry(501) == NULL);
+	for (uint rank = 1; rank <= sorted.size(); rank++) CHECK(SameEntry(table.GetEntry(rank), sorted[rank - 1]));
+
+	for (int score = -1; score <= 101; score++) {
+		uint ahead = 0;
+		for (uint i = 0; i < sorted.size(); i++) if (sorted[i].score >= score) ahead++;
+		CHECK(table.GetRank(score) == ahead + 1);
+	}
+
+	const uint first_ranks[] = { 1, 2, 137, 491, 500 };
+	vector<HighScoreEntry> range;
+	for (uint i = 0; i < sizeof(first_ranks) / sizeof(first_ranks[0]); i++) {
+		table.GetRange(first_ranks[i], 10, range);
+		CHECK(range.size() == min(10u, 501 - first_ranks[i]));
+		for (uint j = 0; j < range.size(); j++) CHECK(SameEntry(&range[j], sorted[first_ranks[i] - 1 + j]));
+	}
+	table.GetRange(501, 10, range);
+	CHECK(range.empty());
+	table.GetRange(0, 10, range);
+	CHECK(range.empty());
+}
+
+TEST(HighScoreTableDropsLowestWhenFull)
+{
+	HighScoreTable table(5);
+	for (uint i = 0; i < 20; i++) table.Add(MakeEntry((i * 7) % 20, i + 1));
+	CHECK(table.GetCount() == 5);
+	for (uint rank = 1; rank <= 5; rank++) CHECK(table.GetEntry(rank)->score == (int)(20 - rank));
+	// A tie with the lowest score kept ranks below it, so it is the one dropped
+	table.Add(MakeEntry(15, 21));
+	CHECK(table.GetCount() == 5);
+	CHECK(table.GetEntry(5)->sequence != 21);
+	table.Clear();
+	CHECK(table.GetCount() == 0);
+}
+
+TEST(HighScoreStoreReopensScores)
+{
+	const char* filename = "HighScoreTest.log";
+	remove(filename);
+	HighScoreStore store;
+	CHECK(store.Open(filename));
+	CHECK(store.Add("First", 100) == 1);
+	CHECK(store.Add("Second", 300) == 1);
+	CHECK(store.Add("Third", 100) == 3);
+	store.Close();
+
+	HighScoreStore loaded;
+	CHECK(loaded.Open(filename));
+	CHECK(loaded.GetTable().GetCount() == 3);
+	for (uint rank = 1; rank <= 3; rank++) CHECK(SameEntry(loaded.GetTable().GetEntry(rank), *store.GetTable().GetEntry(rank)));
+	CHECK(0 == strcmp(loaded.GetTable().GetEntry(2)->name, "First"));
+	// Numbering carries on from the scores read back
+	CHECK(loaded.Add("Fourth", 100) == 4);
+	CHECK(loaded.GetTable().GetEntry(4)->sequence == 4);
+	loaded.Close();
+	remove(filename);
+}
+
+TEST(HighScoreStoreDropsTornEntry)
+{
+	const char* filename = "HighScoreTest.log";
+	remove(filename);
+	HighScoreStore store;
+	CHECK(store.Open(filename));
+	store.Add("First", 100);
+	store.Add("Second", 200);
+	store.Close();
+	size_t whole_size = GetFileSize(filename);
+
+	// Half of an entry, as left by a crash part way through an append
+	{
+		HighScoreEntry torn = MakeEntry(500, 3);
+		ofstream file(filename, ios::out | ios::binary | ios::app);
+		file.write((const char*)&torn, sizeof(torn) / 2);
+	}
+	HighScoreStore loaded;
+	CHECK(loaded.Open(filename));
+	CHECK(loaded.GetTable().GetCount() == 2);
+	CHECK(loaded.GetTable().GetEntry(1)->score == 200);
+	loaded.Flush();
+	CHECK(GetFileSize(filename) == whole_size);
+
+	// A whole entry with the wrong checksum is dropped too
+	loaded.Close();
+	{
+		HighScoreEntry damaged = MakeEntry(500, 3);
+		uint checksum = 0;
+		ofstream file(filename, ios::out | ios::binary | ios::app);
+		file.write((const char*)&damaged, sizeof(damaged));
+		file.write((const char*)&checksum, sizeof(checksum));
+	}
+	CHECK(loaded.Open(filename));
+	CHECK(loaded.GetTable().GetCount() == 2);
+	loaded.Close();
+	CHECK(GetFileSize(filename) == whole_size);
+	remove(filename);
+}
+
+TEST(HighScoreStoreImportsLegacyScores)
+{
+	const char* filename = "HighScoreTest.log";
+	const char* legacy_filename = "HighScoreTest.txt";
+	remove(filename);
+	{
+		ofstream legacy(legacy_filename);
+		legacy << "300\n0\n100\n50\n";
+	}
+	HighScoreStore store;
+	CHECK(store.Open(filename, legacy_filename));
+	// Only the first three are read, and empty places are left out
+	CHECK(store.GetTable().GetCount() == 2);
+	CHECK(store.GetTable().GetEntry(1)->score == 300);
+	CHECK(store.GetTable().GetEntry(2)->score == 100);
+	store.Close();
+
+	// Once there is a log the text file is not read again
+	HighScoreStore loaded;
+	CHECK(loaded.Open(filename, legacy_filename));
+	CHECK(loaded.GetTable().GetCount() == 2);
+	loaded.Close();
+	remove(filename);
+	remove(legacy_filename);
+}
+
+TEST(HighScoreStoreRejectsInvalidLog)
+{
+	const char* filename = "HighScoreTest.log";
+	Tests::WriteFile(filename, "300\n200\n100\n");
+	HighScoreStore store;
+	CHECK(!store.Open(filename));
+	CHECK(!store.IsOpen());
+	// Left as it was for someone to look at
+	CHECK(GetFileSize(filename) == 12);
+	remove(filename);
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <string.h>
+#include "GameWorld.h"
+#include "InputLog.h"
+#include "InputRecorder.h"
+#include "Tests.h"
+
+static InputEvent MakeEvent(uint step, InputEventType type, int key, int width = 0, int height = 0)
+{
+	InputEvent event;
+	memset(&event, 0, sizeof(event));
+	event.step = step;
+	event.type = type;
+	event.key = key;
+	event.width = width;
+	event.height = height;
+	return event;
+}
+
+static InputLogHeader MakeHeader(uint end_step)
+{
+	InputLogHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, InputLog::MAGIC, sizeof(header.magic));
+	header.version = InputLog::VERSION;
+	header.seed = 42;
+	header.end_step = end_step;
+	header.world_width = 400;
+	header.world_height = 300;
+	return header;
+}
+
+static string EncodeLog(const InputLogHeader& header, const InputEventVector& events)
+{
+	ostringstream stream;
+	InputLog::WriteHeader(stream, header);
+	for (uint i = 0; i < events.size(); i++) InputLog::WriteEvent(stream, events[i], i > 0 ? events[i-1].step : 0);
+	return stream.str();
+}
+
+static bool SameEvents(const InputEventVector& a, const InputEventVector& b, size_t count)
+{
+	if (a.size() != count || b.size() < count) return false;
+	for (size_t i = 0; i < count; i++) {
+		if (0 != memcmp(&a[i], &b[i], sizeof(InputEvent))) return false;
+	}
+	return true;
+}
+
+// Step gaps and values either side of each varint byte boundary, up to the largest that fit
+static InputEventVector MakeEvents(void)
+{
+	InputEventVector events;
+	events.push_back(MakeEvent(0, INPUT_KEY_PRESSED, 0));
+	events.push_back(MakeEvent(0, INPUT_KEY_RELEASED, 0x7F));
+	events.push_back(MakeEvent(127, INPUT_SPECIAL_KEY_PRESSED, 0x80));
+	events.push_back(MakeEvent(255, INPUT_SPECIAL_KEY_RELEASED, 0x3FFF));
+	events.push_back(MakeEvent(16639, INPUT_KEY_PRESSED, 0x4000));
+	events.push_back(MakeEvent(16640, INPUT_WORLD_RESIZED, 0, 0x1FFFFF, 0x200000));
+	events.push_back(MakeEvent(0xFFFFFFFF, INPUT_KEY_PRESSED, -1));
+	return events;
+}
+
+TEST(InputLogEventsRoundTrip)
+{
+	const char* filename = "InputLogTest.log";
+	InputEventVector events = MakeEvents();
+	InputLogHeader header = MakeHeader(0xFFFFFFFF);
+	Tests::WriteFile(filename, EncodeLog(header, events));
+
+	InputLog log;
+	CHECK(log.Load(filename));
+	CHECK(0 == memcmp(&log.GetHeader(), &header, sizeof(header)));
+	CHECK(SameEvents(log.GetEvents(), events, events.size()));
+
+	// Only the header, or not even that
+	Tests::WriteFile(filename, EncodeLog(header, InputEventVector()));
+	CHECK(log.Load(filename));
+	CHECK(log.GetEvents().empty());
+	Tests::WriteFile(filename, EncodeLog(header, InputEventVector()).substr(0, sizeof(header) - 1));
+	CHECK(!log.Load(filename));
+	remove(filename);
+}
+
+TEST(InputLogKeepsWholeEventsOfTornTail)
+{
+	const char* filename = "InputLogTest.log";
+	InputEventVector events = MakeEvents();
+	string data = EncodeLog(MakeHeader(0), events);
+	// The last event takes the longest step gap and key, so can be torn in many places
+	ostringstream last;
+	InputLog::WriteEvent(last, events.back(), events[events.size()-2].step);
+	size_t last_size = last.str().size();
+	CHECK(last_size == 11);
+
+	InputLog log;
+	for (size_t cut = 1; cut <= last_size; cut++) {
+		Tests::WriteFile(filename, data.substr(0, data.size() - cut));
+		CHECK(log.Load(filename));
+		CHECK(SameEvents(log.GetEvents(), events, events.size() - 1));
+	}
+	remove(filename);
+}
+
+TEST(InputLogEndsAfterLastEvent)
+{
+	const char* filename = "InputLogTest.log";
+	InputEventVector events;
+	events.push_back(MakeEvent(10, INPUT_KEY_PRESSED, 'a'));
+	Tests::WriteFile(filename, EncodeLog(MakeHeader(5), events));
+	InputLog log;
+	CHECK(log.Load(filename));
+	CHECK(log.GetHeader().end_step == 10);
+	Tests::WriteFile(filename, EncodeLog(MakeHeader(20), events));
+	CHECK(log.Load(filename));
+	CHECK(log.GetHeader().end_step == 20);
+
+	// A recorder only saves the end now and then, as if the game had crashed between
+	GameWorld world;
+	world.SetWidth(400);
+	world.SetHeight(300);
+	world.SetSeed(11);
+	InputRecorder recorder(&world);
+	CHECK(recorder.Open(filename));
+	world.AddListener(&recorder);
+	uint last_step = InputRecorder::END_STEP_INTERVAL + InputRecorder::END_STEP_INTERVAL / 2;
+	for (uint step = 0; step < last_step; step++) {
+		if (step == 3) recorder.OnKeyPressed('a', 0, 0);
+		if (step == last_step - 1) recorder.OnKeyReleased('a', 0, 0);
+		world.Step();
+	}
+	CHECK(log.Load(filename));
+	CHECK(log.GetHeader().seed == 11);
+	CHECK(log.GetEvents().size() == 2);
+	CHECK(log.GetHeader().end_step == last_step - 1);
+	recorder.Close();
+	CHECK(log.Load(filename));
+	CHECK(log.GetEvents().size() == 2);
+	CHECK(log.GetHeader().end_step == last_step);
+	world.RemoveListener(&recorder);
+	remove(filename);
+}
\ No newline at end of file
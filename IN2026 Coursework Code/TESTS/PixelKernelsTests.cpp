@@ -0,0 +1,93 @@
+#include <string.h>
+#include "PixelKernels.h"
+#include "RandomStream.h"
+#include "Tests.h"
+
+// Bytes left after each output, which no kernel may write to
+static const uint GUARD_BYTES = 64;
+static const uchar GUARD_VALUE = 0xCD;
+
+// Random pixels, with some fully transparent, some opaque and some matching the colour key
+static vector<uchar> MakePixels(uint size, RandomStream& random)
+{
+	vector<uchar> pixels(size);
+	for (uint i = 0; i < size; i++) pixels[i] = (uchar)random.Next();
+	for (uint i = 0; i + 4 <= size; i += 4) {
+		switch (random.NextInt(4u))
+		{
+		case 0: pixels[i+3] = 0; break;
+		case 1: pixels[i+3] = 255; break;
+		case 2: pixels[i] = 10; pixels[i+1] = 20; pixels[i+2] = 30; break;
+		}
+	}
+	return pixels;
+}
+
+static vector<uchar>& AddOutput(vector< vector<uchar> >& outputs, uint size)
+{
+	outputs.push_back(vector<uchar>(size + GUARD_BYTES, GUARD_VALUE));
+	return outputs.back();
+}
+
+// Every kernel on an image of the given size, at the level set, each output with its guard bytes
+static vector< vector<uchar> > RunKernels(uint width, uint height)
+{
+	RandomStream random(width * 1000 + height);
+	uint count = width * height;
+	uint pitch24 = (3 * width + 3) & ~3u;
+	vector<uchar> src24 = MakePixels(pitch24 * height, random);
+	vector<uchar> src32 = MakePixels(4 * count, random);
+	// Twice the width and height, with rows padded past their pixels
+	uint stride = 4 * (2 * width + 1);
+	vector<uchar> src_large = MakePixels(stride * 2 * height, random);
+
+	vector< vector<uchar> > outputs;
+	for (uint reverse = 0; reverse < 2; reverse++) {
+		PixelKernels::ExpandBGRToBGRA(&src24[0], &AddOutput(outputs, 4 * count)[0], count, reverse != 0);
+		PixelKernels::CopyBGRA(&src32[0], &AddOutput(outputs, 4 * count)[0], count, reverse != 0);
+	}
+	for (uint orientation = PIXEL_ORIENTATION_NONE; orientation <= PIXEL_ORIENTATION_ROTATE_180; orientation++) {
+		PixelKernels::ConvertToBGRA(&src24[0], pitch24, 24, &AddOutput(outputs, 4 * count)[0], width, height, (PixelOrientation)orientation);
+		PixelKernels::ConvertToBGRA(&src32[0], 4 * width, 32, &AddOutput(outputs, 4 * count)[0], width, height, (PixelOrientation)orientation);
+	}
+
+	vector<uchar>& keyed = AddOutput(outputs, 4 * count);
+	memcpy(&keyed[0], &src32[0], 4 * count);
+	PixelKernels::ApplyColourKey(&keyed[0], count, 10, 20, 30);
+	vector<uchar>& premultiplied = AddOutput(outputs, 4 * count);
+	memcpy(&premultiplied[0], &src32[0], 4 * count);
+	PixelKernels::PremultiplyAlpha(&premultiplied[0], count);
+	PixelKernels::Downsample2x2(&src_large[0], stride, &AddOutput(outputs, 4 * count)[0], width, height);
+
+	vector<uchar>& errors = AddOutput(outputs, PIXEL_FORMAT_COUNT * sizeof(uint));
+	PixelKernels::MeasureFormatErrors(&src_large[0], stride, width, height, (uint*)&errors[0]);
+	for (uint format = 0; format < PIXEL_FORMAT_COUNT; format++) {
+		uint size = GetPixelSize((PixelFormat)format) * count;
+		PixelKernels::ConvertFromBGRA(&src_large[0], stride, width, height, (PixelFormat)format, &AddOutput(outputs, size)[0]);
+	}
+	return outputs;
+}
+
+TEST(PixelKernelsMatchScalarOnOddWidths)
+{
+	// Odd widths either side of the 4, 8 and 16 pixel blocks the vector kernels take
+	const uint widths[] = { 1, 3, 5, 7, 9, 15, 17, 31, 33, 65 };
+	PixelKernelLevel saved_level = PixelKernels::GetLevel();
+	for (uint w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+		for (uint height = 1; height <= 3; height += 2) {
+			PixelKernels::SetLevel(PIXEL_KERNELS_SCALAR);
+			vector< vector<uchar> > reference = RunKernels(widths[w], height);
+			for (uint k = 0; k < reference.size(); k++) {
+				CHECK(reference[k][reference[k].size() - GUARD_BYTES] == GUARD_VALUE);
+			}
+			for (int level = PIXEL_KERNELS_SSE2; level <= PixelKernels::GetSupportedLevel(); level++) {
+				PixelKernels::SetLevel((PixelKernelLevel)level);
+				CHECK(PixelKernels::GetLevel() == level);
+				vector< vector<uchar> > outputs = RunKernels(widths[w], height);
+				CHECK(outputs.size() == reference.size());
+				for (uint k = 0; k < outputs.size() && k < reference.size(); k++) CHECK(outputs[k] == reference[k]);
+			}
+		}
+	}
+	PixelKernels::SetLevel(saved_level);
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "GameObject.h"
+#include "GameWorld.h"
+#include "RandomStream.h"
+#include "Tests.h"
+
+// An object that turns at random each step, drawing from the world's AI stream
+class Wanderer : public GameObject
+{
+public:
+	Wanderer() : GameObject("Wanderer") {}
+
+	void Update(int t)
+	{
+		RandomStream& random = mWorld->GetRandom(RANDOM_STREAM_AI);
+		SetVelocity(GLVector3f(random.NextFloat(-50, 50), random.NextFloat(-50, 50), 0));
+		GameObject::Update(t);
+	}
+};
+
+// A world of wanderers placed from the spawn stream, run for the given steps
+static void RunWorld(GameWorld& world, uint seed, uint num_steps)
+{
+	world.SetWidth(400);
+	world.SetHeight(300);
+	world.SetSeed(seed);
+	RandomStream& random = world.GetRandom(RANDOM_STREAM_SPAWN);
+	for (uint i = 0; i < 20; i++) {
+		shared_ptr<GameObject> object = make_shared<Wanderer>();
+		object->SetPosition(GLVector3f(random.NextFloat(-200, 200), random.NextFloat(-150, 150), 0));
+		world.AddObject(object);
+	}
+	for (uint i = 0; i < num_steps; i++) world.Step();
+}
+
+TEST(RandomStreamRepeatsItsSequence)
+{
+	// Worked out separately from the published algorithms, so any platform must match
+	RandomStream random(1);
+	CHECK(random.Next() == 0x650941ba);
+	CHECK(random.Next() == 0x54d30301);
+	CHECK(random.Next() == 0x25d2f321);
+	CHECK(random.Next() == 0x3fabdca9);
+	RandomStream other(1, 1);
+	CHECK(other.Next() == 0xf04d19d0);
+	CHECK(other.Next() == 0x3c58fc24);
+
+	// Seeding again starts over, and a saved state carries on from where it was saved
+	random.Seed(1);
+	CHECK(random.Next() == 0x650941ba);
+	uint state[4];
+	random.GetState(state);
+	uint expected = random.Next();
+	other.SetState(state);
+	CHECK(other.Next() == expected);
+
+	// Nearby seeds and streams do not follow each other
+	RandomStream a(7), b(8), c(7, 1);
+	uint same = 0;
+	for (uint i = 0; i < 1000; i++) {
+		uint value = a.Next();
+		if (value == b.Next()) same++;
+		if (value == c.Next()) same++;
+	}
+	CHECK(same == 0);
+}
+
+TEST(RandomStreamStaysInRange)
+{
+	RandomStream random(5);
+	bool seen[7] = { false };
+	for (uint i = 0; i < 10000; i++) {
+		CHECK(random.NextInt(10u) < 10);
+		CHECK(random.NextInt(1u) == 0);
+		int value = random.NextInt(-3, 3);
+		CHECK(value >= -3 && value <= 3);
+		if (value >= -3 && value <= 3) seen[value + 3] = true;
+		CHECK(random.NextInt(4, 4) == 4);
+		float fraction = random.NextFloat();
+		CHECK(fraction >= 0 && fraction < 1);
+		float scaled = random.NextFloat(-2.5f, 7.5f);
+		CHECK(scaled >= -2.5f && scaled <= 7.5f);
+	}
+	// Both ends of an inclusive range come up
+	for (uint i = 0; i < 7; i++) CHECK(seen[i]);
+}
+
+TEST(GameWorldSameSeedSameChecksum)
+{
+	GameWorld first, second, other;
+	RunWorld(first, 1234, 500);
+	RunWorld(second, 1234, 500);
+	RunWorld(other, 1235, 500);
+	CHECK(first.GetStateChecksum() == second.GetStateChecksum());
+	CHECK(first.GetStateChecksum() != other.GetStateChecksum());
+	// Effects draw from their own stream, so they do not change what the AI does
+	second.GetRandom(RANDOM_STREAM_EFFECTS).Next();
+	first.Step();
+	second.Step();
+	CHECK(first.GetStateChecksum() == second.GetStateChecksum());
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "GameUtil.h"
+#include "Animation.h"
+#include "GameObject.h"
+#include "RenderQueue.h"
+#include "RenderState.h"
+#include "Sprite.h"
+#include "SpriteBatch.h"
+#include "Tests.h"
+
+// One frame covering a whole texture, which the test sprites never look at
+static Animation* GetTestAnimation(void)
+{
+	static AnimationFrame* frames = new AnimationFrame[1];
+	frames[0].texture = NULL;
+	frames[0].u1 = frames[0].v1 = 0;
+	frames[0].u2 = frames[0].v2 = 1;
+	static Animation animation(16, 16, frames, 1);
+	return &animation;
+}
+
+// A sprite with a fixed texture id, so no texture has to be uploaded
+class TestSprite : public Sprite
+{
+public:
+	TestSprite(uint texture_id) : Sprite(16, 16, GetTestAnimation()), mTextureID(texture_id) {}
+
+	uint GetTextureID() const { return mTextureID; }
+	void Render(SpriteBatch& batch, const GLVector3f& position, GLfloat angle, GLfloat scale)
+	{
+		batch.AddSprite(mTextureID, position, angle, scale, -8, -8, 8, 8, 0, 0, 1, 1);
+	}
+
+private:
+	uint mTextureID;
+};
+
+TEST(RenderQueueDrawsLaterLayersOfSpritesLast)
+{
+	// An explosion on layer 1 uses a sheet with a lower texture id than the asteroid under it
+	GameObject asteroid("Asteroid"), explosion("Explosion");
+	TestSprite asteroid_sprite(2), explosion_sprite(1);
+	RenderQueue queue;
+	queue.SubmitSprite(1, &explosion, &explosion_sprite);
+	queue.SubmitSprite(0, &asteroid, &asteroid_sprite);
+
+	SpriteBatch batch;
+	queue.Execute(batch);
+	CHECK(batch.GetSpriteCount() == 2);
+	CHECK(batch.GetDrawCallCount() == 2);
+	// The explosion's texture is bound last, so it was drawn on top
+	CHECK(RenderState::GetInstance().GetBoundTexture() == 1);
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include <chrono>
+#include "GameObject.h"
+#include "GameWorld.h"
+#include "IRollbackListener.h"
+#include "RollbackSession.h"
+#include "Tests.h"
+
+// Each player pushes one object about with their buttons, changing them often enough
+// that the other peer's guesses are wrong and it has to roll back
+class TestPlayers : public IRollbackListener
+{
+public:
+	TestPlayers(GameWorld* world) : mWorld(world) {}
+
+	void OnRollbackFrame(RollbackSession* session, uint frame)
+	{
+		uint period = session->GetLocalPlayer() == 0 ? 7 : 11;
+		session->SetButtons(((frame / period) * 5 + session->GetLocalPlayer()) % 8);
+	}
+
+	void OnRollbackInput(RollbackSession* session, uint player, uint buttons)
+	{
+		shared_ptr<GameObject> object = mWorld->FindObject(player + 1);
+		float x = (buttons & NET_INPUT_LEFT ? -40.0f : 0) + (buttons & NET_INPUT_RIGHT ? 40.0f : 0);
+		float y = buttons & NET_INPUT_THRUST ? 60.0f : -20.0f;
+		object->SetVelocity(GLVector3f(x, y, 0));
+	}
+
+private:
+	GameWorld* mWorld;
+};
+
+static void FillWorld(GameWorld& world)
+{
+	world.SetWidth(400);
+	world.SetHeight(300);
+	world.SetSeed(11);
+	world.SetObjectFactory([](const GameObjectState& state) { return make_shared<GameObject>("Test"); });
+	RandomStream& random = world.GetRandom(RANDOM_STREAM_SPAWN);
+	for (uint i = 0; i < 20; i++) {
+		shared_ptr<GameObject> object = make_shared<GameObject>("Test");
+		object->SetPosition(GLVector3f(random.NextFloat(-200, 200), random.NextFloat(-150, 150), 0));
+		object->SetVelocity(GLVector3f(random.NextFloat(-50, 50), random.NextFloat(-50, 50), 0));
+		world.AddObject(object);
+	}
+}
+
+// How a game between two peers went for each of them
+struct PeerResult
+{
+	uint checksums_matched;
+	bool desynced;
+	uint rollbacks;
+};
+
+// Step two peers on this machine in turn until each has compared num_checks checksums with
+// the other or found they differ. Packets are held back by latency milliseconds and some
+// are lost, and the second world is nudged at nudge_frame if it is not 0.
+static bool PlayPeers(uint num_checks, uint latency, uint nudge_frame, PeerResult results[2])
+{
+	GameWorld worlds[2];
+	shared_ptr<TestPlayers> players[2];
+	shared_ptr<RollbackSession> sessions[2];
+	const unsigned short ports[2] = { 47611, 47612 };
+	for (uint i = 0; i < 2; i++) {
+		FillWorld(worlds[i]);
+		players[i] = make_shared<TestPlayers>(&worlds[i]);
+		sessions[i] = make_shared<RollbackSession>(&worlds[i]);
+		sessions[i]->SetListener(players[i].get());
+		sessions[i]->GetConditioner().SetLatency(latency);
+		sessions[i]->GetConditioner().SetJitter(latency / 2);
+		sessions[i]->GetConditioner().SetLoss(latency > 0 ? 0.05f : 0);
+		NetAddress peer;
+		if (!UdpSocket::ParseAddress("127.0.0.1", ports[1 - i], peer)) return false;
+		if (!sessions[i]->Open(ports[i], peer, i)) return false;
+	}
+
+	bool nudged = false;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	while (chrono::steady_clock::now() - start < chrono::seconds(20)) {
+		bool done = true;
+		for (uint i = 0; i < 2; i++) {
+			if (sessions[i]->OnStepStarting(&worlds[i])) worlds[i].Step();
+			done = done && (sessions[i]->IsDesynced() || sessions[i]->GetChecksumsMatched() >= num_checks);
+		}
+		if (nudge_frame != 0 && !nudged && worlds[1].GetClock().GetStepCount() == nudge_frame) {
+			shared_ptr<GameObject> object = worlds[1].FindObject(10);
+			object->SetPosition(object->GetPosition() + GLVector3f(0.5f, 0, 0));
+			nudged = true;
+		}
+		if (done) break;
+	}
+	for (uint i = 0; i < 2; i++) {
+		sessions[i]->Close();
+		results[i].checksums_matched = sessions[i]->GetChecksumsMatched();
+		results[i].desynced = sessions[i]->IsDesynced();
+		results[i].rollbacks = sessions[i]->GetRollbackCount();
+	}
+	return true;
+}
+
+TEST(RollbackPeersStayInSync)
+{
+	// Both peers guess wrong and roll back often, and must still end up with the same worlds
+	PeerResult results[2];
+	CHECK(PlayPeers(3, 20, 0, results));
+	for (uint i = 0; i < 2; i++) {
+		CHECK(!results[i].desynced);
+		CHECK(results[i].checksums_matched >= 3);
+		CHECK(results[i].rollbacks > 0);
+	}
+}
+
+TEST(RollbackChecksumFindsDesync)
+{
+	// Half a unit out of place in one world is seen at the next checksum both peers compare
+	PeerResult results[2];
+	CHECK(PlayPeers(3, 0, 50, results));
+	for (uint i = 0; i < 2; i++) {
+		CHECK(results[i].desynced);
+		CHECK(results[i].checksums_matched == 1);
+	}
+}
\ No newline at end of file
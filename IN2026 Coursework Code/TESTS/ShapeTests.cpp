@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include "Shape.h"
+#include "ShapeManager.h"
+#include "Tests.h"
+
+TEST(ShapeCompiledRoundTrip)
+{
+	const char* filename = "ShapeTest.shape";
+	Tests::WriteFile(filename, "loop\n1 0.5 0\n0 2\n-1.5 -1\n1.5 -1\n");
+	Shape text;
+	CHECK(text.LoadShape(filename));
+	CHECK(text.GetPoints().size() == 3);
+
+	ostringstream compiled_stream;
+	CHECK(text.SaveCompiledShape(compiled_stream));
+	string compiled = compiled_stream.str();
+	Shape loaded;
+	CHECK(loaded.LoadCompiledShape(compiled.data(), compiled.size()));
+	CHECK(loaded.GetPoints().size() == 3);
+	for (uint i = 0; i < 3 && i < loaded.GetPoints().size(); i++) {
+		CHECK(loaded.GetPoints()[i].x == text.GetPoints()[i].x);
+		CHECK(loaded.GetPoints()[i].y == text.GetPoints()[i].y);
+	}
+	CHECK(loaded.GetSourceHash() == text.GetSourceHash());
+	CHECK(!loaded.LoadCompiledShape(compiled.data(), compiled.size() - 1));
+	CHECK(!loaded.LoadCompiledShape(compiled.data(), sizeof(CompiledShapeHeader) - 1));
+	remove(filename);
+}
+
+TEST(ShapeManagerSkipsStaleCompiledShape)
+{
+	const char* filename = "ShapeTest.shape";
+	Tests::WriteFile(filename, "strip\n1 1 1\n0 0\n1 1\n");
+	CHECK(ShapeManager::CompileShapeFile(filename));
+	shared_ptr<Shape> fresh = ShapeManager::GetInstance().CreateShapeFromFile("shape-test-fresh", filename);
+	CHECK(fresh.get() != NULL && fresh->GetPoints().size() == 2);
+
+	// Edited after it was compiled, so the compiled copy is out of date
+	Tests::WriteFile(filename, "strip\n1 1 1\n0 0\n1 1\n2 0\n");
+	shared_ptr<Shape> edited = ShapeManager::GetInstance().CreateShapeFromFile("shape-test-edited", filename);
+	CHECK(edited.get() != NULL && edited->GetPoints().size() == 3);
+
+	// Without the text file, the compiled copy is all there is
+	remove(filename);
+	shared_ptr<Shape> compiled_only = ShapeManager::GetInstance().CreateShapeFromFile("shape-test-compiled", filename);
+	CHECK(compiled_only.get() != NULL && compiled_only->GetPoints().size() == 2);
+	remove(ShapeManager::GetCompiledFilename(filename).c_str());
+	CHECK(ShapeManager::GetInstance().CreateShapeFromFile("shape-test-missing", filename).get() == NULL);
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include "RandomStream.h"
+#include "SpatialGrid.h"
+#include "Tests.h"
+
+// What a search must find: every point within radius, the short way round the world
+static vector<uint> FindAll(const SpatialGrid& grid, const vector<GLVector2f>& points, float x, float y, float radius)
+{
+	vector<uint> indices;
+	for (uint i = 0; i < points.size(); i++) {
+		if (grid.GetDistance(x, y, points[i].x, points[i].y) <= radius) indices.push_back(i);
+	}
+	return indices;
+}
+
+static vector<uint> Query(const SpatialGrid& grid, float x, float y, float radius)
+{
+	vector<uint> indices;
+	grid.Query(x, y, radius, indices);
+	sort(indices.begin(), indices.end());
+	return indices;
+}
+
+TEST(SpatialGridWrapsDistance)
+{
+	SpatialGrid grid;
+	grid.Build(400, 300, 64, vector<GLVector2f>());
+	CHECK(fabs(grid.GetDistance(-190, 0, 190, 0) - 20) < 0.001f);
+	CHECK(fabs(grid.GetDistance(0, -140, 0, 140) - 20) < 0.001f);
+	CHECK(fabs(grid.GetDistance(-50, 0, 50, 0) - 100) < 0.001f);
+}
+
+TEST(SpatialGridFindsPointsAcrossWrappedEdge)
+{
+	// 400 is not a multiple of 64, so the grid must not leave a part-filled cell at the edge
+	vector<GLVector2f> points;
+	points.push_back(GLVector2f(140, 0));
+	points.push_back(GLVector2f(199, 10));
+	points.push_back(GLVector2f(0, 0));
+	SpatialGrid grid;
+	grid.Build(400, 400, 64, points);
+	vector<uint> found = Query(grid, -200, 0, 64);
+	CHECK(find(found.begin(), found.end(), 0u) != found.end());
+	CHECK(find(found.begin(), found.end(), 1u) != found.end());
+	CHECK(find(found.begin(), found.end(), 2u) == found.end());
+}
+
+TEST(SpatialGridMatchesExhaustiveSearch)
+{
+	const int sizes[][2] = { { 400, 400 }, { 2000, 2000 }, { 333, 150 }, { 50, 50 } };
+	const float radii[] = { 0, 10, 63, 64, 65, 150, 250, 1000 };
+	RandomStream random(11);
+	for (uint s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		int width = sizes[s][0], height = sizes[s][1];
+		vector<GLVector2f> points;
+		for (uint i = 0; i < 500; i++) {
+			points.push_back(GLVector2f(random.NextFloat(-width * 0.5f, width * 0.5f), random.NextFloat(-height * 0.5f, height * 0.5f)));
+		}
+		SpatialGrid grid;
+		grid.Build(width, height, 64, points);
+		for (uint r = 0; r < sizeof(radii) / sizeof(radii[0]); r++) {
+			for (uint q = 0; q < 50; q++) {
+				// Include searches from the very edges of the world
+				float x = (q % 5 == 0) ? -width * 0.5f : random.NextFloat(-width * 0.5f, width * 0.5f);
+				float y = (q % 7 == 0) ? height * 0.5f - 0.01f : random.NextFloat(-height * 0.5f, height * 0.5f);
+				CHECK(Query(grid, x, y, radii[r]) == FindAll(grid, points, x, y, radii[r]));
+			}
+		}
+	}
+}
\ No newline at end of file
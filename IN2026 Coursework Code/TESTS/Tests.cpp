@@ -0,0 +1,94 @@
+#include <string.h>
+#include "Tests.h"
+
+uint Tests::mFailedChecks = 0;
+
+// PUBLIC STATIC METHODS //////////////////////////////////////////////////////
+
+bool Tests::Register(const char* name, TestFunction function)
+{
+	RegisteredTest test = { name, function };
+	GetTests().push_back(test);
+	return true;
+}
+
+void Tests::Check(bool passed, const char* condition, const char* file, int line)
+{
+	if (passed) return;
+	mFailedChecks++;
+	cout << "  " << file << "(" << line << "): CHECK(" << condition << ") failed" << endl;
+}
+
+/** Run every test whose name contains filter, or all of them if it is NULL. */
+bool Tests::RunAll(const char* filter)
+{
+	uint run = 0, failed = 0;
+	vector<RegisteredTest>& tests = GetTests();
+	for (uint i = 0; i < tests.size(); i++) {
+		if (filter != NULL && strstr(tests[i].name, filter) == NULL) continue;
+		uint failed_checks = mFailedChecks;
+		tests[i].function();
+		run++;
+		if (mFailedChecks != failed_checks) failed++;
+		cout << (mFailedChecks != failed_checks ? "FAILED " : "ok     ") << tests[i].name << endl;
+	}
+	cout << run - failed << " of " << run << " tests passed" << endl;
+	return failed == 0;
+}
+
+bool Tests::RegisterBenchmark(const char* name, TestFunction function)
+{
+	RegisteredTest benchmark = { name, function };
+	GetBenchmarks().push_back(benchmark);
+	return true;
+}
+
+/** Run every benchmark whose name contains filter, or all of them if it is NULL. */
+void Tests::RunBenchmarks(const char* filter)
+{
+	vector<RegisteredTest>& benchmarks = GetBenchmarks();
+	for (uint i = 0; i < benchmarks.size(); i++) {
+		if (filter != NULL && strstr(benchmarks[i].name, filter) == NULL) continue;
+		benchmarks[i].function();
+	}
+}
+
+/** Replace the file with data, written as it is with no line ending translation. */
+void Tests::WriteFile(const char* filename, const string& data)
+{
+	ofstream file(filename, ios::out | ios::binary | ios::trunc);
+	file << data;
+}
+
+/** The whole file, or an empty string if it cannot be read. */
+string Tests::ReadFile(const char* filename)
+{
+	ifstream file(filename, ios::in | ios::binary);
+	return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+// PRIVATE STATIC METHODS /////////////////////////////////////////////////////
+
+/** Tests register before main, so the list is made on first use rather than by static initialization. */
+vector<Tests::RegisteredTest>& Tests::GetTests(void)
+{
+	static vector<RegisteredTest> tests;
+	return tests;
+}
+
+vector<Tests::RegisteredTest>& Tests::GetBenchmarks(void)
+{
+	static vector<RegisteredTest> benchmarks;
+	return benchmarks;
+}
+
+// Run the tests, e.g. "Tests Snapshot" for those with Snapshot in their names,
+// or the benchmarks with "Tests --bench", e.g. "Tests --bench Kernels"
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && 0 == strcmp(argv[1], "--bench")) {
+		Tests::RunBenchmarks(argc > 2 ? argv[2] : NULL);
+		return 0;
+	}
+	return Tests::RunAll(argc > 1 ? argv[1] : NULL) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef __TESTS_H__
+#define __TESTS_H__
+
+#include <vector>
+#include "GameUtil.h"
+
+typedef void (*TestFunction)(void);
+
+// A small test runner. Each TEST registers itself as the program starts, and
+// a failed CHECK is reported without stopping the test, so one run lists
+// everything that is wrong. A BENCHMARK registers the same way but only runs
+// when asked for, as its timings are for reading rather than checking. Tests
+// of loading write their files with WriteFile, which takes text or binary.
+class Tests
+{
+public:
+	static bool Register(const char* name, TestFunction function);
+	static void Check(bool passed, const char* condition, const char* file, int line);
+	static bool RunAll(const char* filter);
+	static bool RegisterBenchmark(const char* name, TestFunction function);
+	static void RunBenchmarks(const char* filter);
+
+	static void WriteFile(const char* filename, const string& data);
+	static string ReadFile(const char* filename);
+
+private:
+	Tests() {} // Not instantiated
+
+	struct RegisteredTest
+	{
+		const char* name;
+		TestFunction function;
+	};
+
+	static vector<RegisteredTest>& GetTests(void);
+	static vector<RegisteredTest>& GetBenchmarks(void);
+
+	static uint mFailedChecks;
+};
+
+#define TEST(name) \
+	static void name(void); \
+	static bool name##_registered = Tests::Register(#name, name); \
+	static void name(void)
+
+#define BENCHMARK(name) \
+	static void name(void); \
+	static bool name##_registered = Tests::RegisterBenchmark(#name, name); \
+	static void name(void)
+
+#define CHECK(condition) Tests::Check((condition), #condition, __FILE__, __LINE__)
+
+#endif
\ No newline at end of file
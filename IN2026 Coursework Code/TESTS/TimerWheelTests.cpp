@@ -0,0 +1,90 @@
+#include "ITimerListener.h"
+#include "TimerWheel.h"
+#include "Tests.h"
+
+// Records each value it is called with and the game time it was called at
+class TimerRecorder : public ITimerListener
+{
+public:
+	TimerRecorder(TimerWheel& wheel) : mWheel(wheel) {}
+
+	void OnTimer(int value)
+	{
+		values.push_back(value);
+		times.push_back(mWheel.GetTime());
+		if (value == CANCEL_NEXT) mWheel.Cancel(next);
+	}
+
+	// Cancels the timer in next, to cancel one due on the same tick
+	static const int CANCEL_NEXT = -1;
+	TimerHandle next;
+	vector<int> values;
+	vector<uint> times;
+
+private:
+	TimerWheel& mWheel;
+};
+
+TEST(TimerWheelFiresOnTimeFromEveryLevel)
+{
+	// Either side of where each level's span ends
+	const uint delays[] = { 1, 255, 256, 300, 65535, 65536, 70000, (1u << 24) + 5 };
+	const uint num_delays = sizeof(delays) / sizeof(delays[0]);
+	TimerWheel wheel;
+	TimerRecorder recorder(wheel);
+	wheel.Advance(1000);
+	for (uint i = 0; i < num_delays; i++) wheel.Schedule(delays[i], &recorder, (int)i);
+	CHECK(wheel.GetPendingCount() == num_delays);
+	wheel.Advance(delays[num_delays - 1]);
+	CHECK(wheel.GetPendingCount() == 0);
+	CHECK(recorder.values.size() == num_delays);
+	for (uint i = 0; i < recorder.values.size(); i++) {
+		CHECK(recorder.values[i] == (int)i);
+		CHECK(recorder.times[i] == 1000 + delays[i]);
+	}
+}
+
+TEST(TimerWheelIgnoresStaleHandles)
+{
+	TimerWheel wheel;
+	TimerRecorder recorder(wheel);
+	TimerHandle first = wheel.Schedule(10, &recorder, 1);
+	TimerHandle stale = first;
+	CHECK(wheel.Cancel(first));
+	CHECK(!wheel.Cancel(first));
+	// The cancelled timer's node is reused, but the old handle does not refer to it
+	TimerHandle second = wheel.Schedule(10, &recorder, 2);
+	CHECK(second.index == stale.index);
+	CHECK(!wheel.IsPending(stale));
+	CHECK(!wheel.Cancel(stale));
+	CHECK(wheel.IsPending(second));
+	wheel.Advance(10);
+	CHECK(recorder.values.size() == 1 && recorder.values[0] == 2);
+	CHECK(!wheel.IsPending(second));
+	CHECK(!wheel.Cancel(second));
+
+	// A timer cancelled by another due on the same tick does not fire
+	wheel.Schedule(5, &recorder, TimerRecorder::CANCEL_NEXT);
+	recorder.next = wheel.Schedule(5, &recorder, 3);
+	wheel.Advance(5);
+	CHECK(recorder.values.size() == 2 && recorder.values[1] == TimerRecorder::CANCEL_NEXT);
+	CHECK(wheel.GetPendingCount() == 0);
+}
+
+TEST(TimerWheelFiresSameTickInSchedulingOrder)
+{
+	TimerWheel wheel;
+	TimerRecorder recorder(wheel);
+	// The first waits in the second level, and only cascades into the slot
+	// the second went straight into once time reaches 256
+	wheel.Schedule(300, &recorder, 1);
+	wheel.Advance(100);
+	wheel.Schedule(200, &recorder, 2);
+	wheel.Schedule(200, &recorder, 3);
+	wheel.Advance(200);
+	CHECK(recorder.values.size() == 3);
+	for (uint i = 0; i < recorder.values.size(); i++) {
+		CHECK(recorder.values[i] == (int)i + 1);
+		CHECK(recorder.times[i] == 300);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+#include "GameObject.h"
+#include "GameWorld.h"
+#include "Tests.h"
+#include "WorldSnapshot.h"
+
+// A world of moving objects, with a timer and a game value, that can recreate its objects
+static void FillWorld(GameWorld& world, uint num_objects)
+{
+	world.SetWidth(400);
+	world.SetHeight(300);
+	world.SetSeed(7);
+	world.SetObjectFactory([](const GameObjectState& state) { return make_shared<GameObject>("Test"); });
+	RandomStream& random = world.GetRandom(RANDOM_STREAM_SPAWN);
+	for (uint i = 0; i < num_objects; i++) {
+		shared_ptr<GameObject> object = make_shared<GameObject>("Test");
+		object->SetPosition(GLVector3f(random.NextFloat(-200, 200), random.NextFloat(-150, 150), 0));
+		object->SetVelocity(GLVector3f(random.NextFloat(-50, 50), random.NextFloat(-50, 50), 0));
+		object->SetRotation(random.NextFloat(-90, 90));
+		world.AddObject(object);
+	}
+}
+
+// The counts in the header are only filled in as a snapshot is encoded, so they are left out
+static bool SameSnapshot(const WorldSnapshot& a, const WorldSnapshot& b)
+{
+	WorldSnapshotHeader a_header = a.header, b_header = b.header;
+	a_header.num_objects = a_header.num_timers = a_header.num_values = 0;
+	b_header.num_objects = b_header.num_timers = b_header.num_values = 0;
+	return 0 == memcmp(&a_header, &b_header, sizeof(a_header))
+		&& a.objects.size() == b.objects.size()
+		&& (a.objects.empty() || 0 == memcmp(&a.objects[0], &b.objects[0], a.objects.size() * sizeof(GameObjectState)))
+		&& a.timers.size() == b.timers.size()
+		&& (a.timers.empty() || 0 == memcmp(&a.timers[0], &b.timers[0], a.timers.size() * sizeof(TimerState)))
+		&& a.values.size() == b.values.size()
+		&& (a.values.empty() || 0 == memcmp(&a.values[0], &b.values[0], a.values.size() * sizeof(SnapshotValue)));
+}
+
+TEST(SnapshotEncodeDecodeRoundTrip)
+{
+	GameWorld world;
+	FillWorld(world, 50);
+	world.Step();
+	WorldSnapshot snapshot, decoded;
+	world.TakeSnapshot(snapshot);
+	snapshot.SetValue(1, 1234);
+	snapshot.SetValue(2, -5);
+
+	string data;
+	snapshot.Encode(data);
+	CHECK(decoded.Decode(data.data(), data.size()));
+	CHECK(SameSnapshot(snapshot, decoded));
+	CHECK(decoded.GetValue(1) == 1234);
+	CHECK(decoded.GetValue(2) == -5);
+	CHECK(decoded.GetValue(3, 9) == 9);
+	CHECK(decoded.GetChecksum() == snapshot.GetChecksum());
+	CHECK(snapshot.GetChecksum() == world.GetStateChecksum());
+}
+
+TEST(SnapshotDecodeRejectsBadData)
+{
+	GameWorld world;
+	FillWorld(world, 10);
+	WorldSnapshot snapshot, decoded;
+	world.TakeSnapshot(snapshot);
+	string data;
+	snapshot.Encode(data);
+
+	CHECK(!decoded.Decode(data.data(), data.size() - 1));
+	CHECK(!decoded.Decode(data.data(), sizeof(WorldSnapshotHeader) / 2));
+	string bad_magic = data;
+	bad_magic[0] ^= 1;
+	CHECK(!decoded.Decode(bad_magic.data(), bad_magic.size()));
+	// Times the size of a value, the extra count is 4 GB, or nothing with a 32 bit size_t
+	string bad_count = data;
+	WorldSnapshotHeader header;
+	memcpy(&header, bad_count.data(), sizeof(header));
+	header.num_values += 0x20000000;
+	memcpy(&bad_count[0], &header, sizeof(header));
+	CHECK(!decoded.Decode(bad_count.data(), bad_count.size()));
+
+	// A rejected snapshot or delta leaves the last one decoded as it was
+	CHECK(decoded.Decode(data.data(), data.size()));
+	CHECK(!decoded.Decode(data.data(), data.size() - 1));
+	CHECK(SameSnapshot(decoded, snapshot));
+	world.Step();
+	WorldSnapshot next;
+	world.TakeSnapshot(next);
+	string delta;
+	next.EncodeDelta(snapshot, delta);
+	CHECK(!decoded.DecodeDelta(snapshot, delta.data(), delta.size() - 1));
+	CHECK(SameSnapshot(decoded, snapshot));
+}
+
+TEST(SnapshotDeltaRoundTrip)
+{
+	GameWorld world;
+	FillWorld(world, 50);
+	WorldSnapshot base, current, decoded;
+	world.TakeSnapshot(base);
+
+	// Move everything, take one object out and put a new one in
+	for (uint i = 0; i < 20; i++) world.Step();
+	world.RemoveObject(world.FindObject(base.objects[10].id));
+	world.AddObject(make_shared<GameObject>("Test"));
+	world.TakeSnapshot(current);
+
+	string delta, full;
+	current.EncodeDelta(base, delta);
+	current.Encode(full);
+	CHECK(decoded.DecodeDelta(base, delta.data(), delta.size()));
+	CHECK(SameSnapshot(current, decoded));
+	CHECK(!decoded.DecodeDelta(base, delta.data(), delta.size() - 1));
+
+	// Against itself, a delta is little more than its length
+	string unchanged;
+	current.EncodeDelta(current, unchanged);
+	CHECK(unchanged.size() < full.size() / 10);
+	CHECK(decoded.DecodeDelta(current, unchanged.data(), unchanged.size()));
+	CHECK(SameSnapshot(current, decoded));
+}
+
+TEST(SnapshotRestoreRewindsWorld)
+{
+	GameWorld world;
+	FillWorld(world, 30);
+	WorldSnapshot saved, restored;
+	world.TakeSnapshot(saved);
+	uint checksum = world.GetStateChecksum();
+
+	for (uint i = 0; i < 50; i++) world.Step();
+	world.RemoveObject(world.FindObject(saved.objects[0].id));
+	CHECK(world.GetStateChecksum() != checksum);
+
+	CHECK(world.RestoreSnapshot(saved));
+	CHECK(world.GetStateChecksum() == checksum);
+	world.TakeSnapshot(restored);
+	CHECK(SameSnapshot(saved, restored));
+
+	// The same steps from the same state give the same world
+	for (uint i = 0; i < 50; i++) world.Step();
+	uint replayed = world.GetStateChecksum();
+	CHECK(world.RestoreSnapshot(saved));
+	for (uint i = 0; i < 50; i++) world.Step();
+	CHECK(world.GetStateChecksum() == replayed);
+}
+
+TEST(SnapshotSaveLoadRoundTrip)
+{
+	GameWorld world;
+	FillWorld(world, 20);
+	WorldSnapshot snapshot, loaded;
+	world.TakeSnapshot(snapshot);
+	const char* filename = "SnapshotTest.snapshot";
+	CHECK(snapshot.Save(filename));
+	CHECK(loaded.Load(filename));
+	CHECK(SameSnapshot(snapshot, loaded));
+	remove(filename);
+	CHECK(!loaded.Load(filename));
+}
\ No newline at end of file